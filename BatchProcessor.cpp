@@ -0,0 +1,221 @@
+#include "BatchProcessor.h"
+#include "globals.h"
+#include "util/StopWatch.h"
+#include <QDebug>
+#include <thread>
+
+// The BatchProcessor re-evaluates a recording, for example after a config change.
+// Unlike stepping the robot control through the state history, it does not touch
+// the global state or the global config. The config is copied once before the run,
+// and each worker thread owns a sample grid, a grid model and the buffers for one
+// frame, so the workers share nothing but the read only recording and the config.
+//
+// The frames are processed in blocks of consecutive frames. The workers take the
+// next block from an atomic counter. The floor detection feeds the floor plane of
+// a frame forward to the next one, so at the start of a block the floor is reset
+// and the frame before the block is processed once to warm the floor up. This makes
+// the results independent of the number of threads and the order in which the
+// blocks are taken, but not identical to the serial pipeline. One frame of warm up
+// does not always bring the floor to the state it would have after all previous
+// frames, so the first frames of a block can differ from a serial run, and the
+// results depend on the block size. The temporal stages of the robot control (registration,
+// stabilization and the map) depend on all previous frames and are not run here.
+//
+// Usage:
+//
+// BatchProcessor batch;
+// batch.open("data/statehistory.rec");
+// batch.setConfig(config);
+// batch.run();
+// const Vector<BatchResult>& results = batch.getResults();
+//
+// run() blocks until all frames are done. To keep a GUI responsive, call it in
+// another thread and poll numProcessed() for the progress. cancel() stops the run
+// after the blocks that are in progress.
+
+BatchProcessor::BatchProcessor()
+{
+    numThreads = 0;
+    blockSize = 64;
+    runTime = 0;
+    cancelled = false;
+    processedFrames = 0;
+}
+
+// Opens a recording.
+bool BatchProcessor::open(QString fileName)
+{
+    close();
+    if (!recording.open(fileName))
+        return false;
+    if (recording.numPoints() != NUMBER_OF_POINTS)
+    {
+        qDebug() << "BatchProcessor::open(): the recording has" << recording.numPoints() << "points per frame instead of" << NUMBER_OF_POINTS;
+        recording.close();
+        return false;
+    }
+    return true;
+}
+
+// Closes the recording and releases the results.
+void BatchProcessor::close()
+{
+    recording.close();
+    results.clear();
+}
+
+bool BatchProcessor::isOpen() const
+{
+    return recording.isOpen();
+}
+
+int BatchProcessor::numFrames() const
+{
+    return recording.numFrames();
+}
+
+// Sets the parameters of the pipeline. The config is copied.
+void BatchProcessor::setConfig(const Config& conf)
+{
+    this->conf = conf;
+}
+
+// Sets the number of worker threads. 0 uses one thread per core.
+void BatchProcessor::setThreads(int threads)
+{
+    numThreads = qMax(0, threads);
+}
+
+// Sets the number of consecutive frames a worker processes in one go.
+// Larger blocks need fewer warm ups and follow the serial pipeline more closely.
+void BatchProcessor::setBlockSize(int frames)
+{
+    blockSize = qMax(1, frames);
+}
+
+// Processes count frames of the recording starting with frame first.
+// With count < 0 all frames from first to the end are processed.
+// Blocks until all frames are done. Returns false if the run was cancelled.
+bool BatchProcessor::run(int first, int count)
+{
+    if (!isOpen())
+        return false;
+
+    first = qBound(0, first, numFrames());
+    if (count < 0 || first + count > numFrames())
+        count = numFrames() - first;
+
+    results.clear();
+    results.resize(count);
+    profiler.reset();
+    cancelled = false;
+    processedFrames = 0;
+
+    int blocks = (count + blockSize - 1) / blockSize;
+    int threads = numThreads > 0 ? numThreads : (int)std::thread::hardware_concurrency();
+    threads = qBound(1, threads, qMax(1, blocks));
+
+    StopWatch stopWatch;
+    stopWatch.start();
+
+    std::atomic<int> nextBlock(0);
+    std::vector<std::thread> workers;
+    for (int w = 1; w < threads; w++)
+        workers.emplace_back(&BatchProcessor::work, this, first, count, &nextBlock);
+    work(first, count, &nextBlock);
+    for (uint w = 0; w < workers.size(); w++)
+        workers[w].join();
+
+    runTime = stopWatch.elapsedTime();
+    return !cancelled;
+}
+
+// Stops a run that is in progress after the blocks the workers are processing.
+// Can be called from any thread.
+void BatchProcessor::cancel()
+{
+    cancelled = true;
+}
+
+// Returns true if the last run was cancelled. Its results are incomplete then.
+bool BatchProcessor::wasCancelled() const
+{
+    return cancelled;
+}
+
+// Returns the number of frames processed so far in the current or the last run.
+// Can be called from any thread.
+int BatchProcessor::numProcessed() const
+{
+    return processedFrames;
+}
+
+// The worker loop. Takes blocks of frames until all are processed.
+void BatchProcessor::work(int first, int count, std::atomic<int>* nextBlock)
+{
+    SampleGrid sampleGrid;
+    GridModel gridModel;
+    sampleGrid.init(conf);
+    gridModel.init(conf);
+
+    Vector<Vec3> points(NUMBER_OF_POINTS);
+    Vector<Pixel> colors(NUMBER_OF_POINTS);
+    Sample floor;
+    Transform3D cameraTransform;
+    PolygonSet polygonSet;
+    StopWatch stopWatch;
+
+    int block;
+    while (!cancelled && (block = (*nextBlock)++) * blockSize < count)
+    {
+        int begin = block*blockSize;
+        int end = qMin(count, begin + blockSize);
+
+        // Warm up the floor detection with the frame before the block.
+        sampleGrid.resetFloor();
+        if (first + begin > 0)
+        {
+            recording.readFrame(first + begin - 1, &points[0], &colors[0], false);
+            Pipeline::process(conf, &points[0], sampleGrid, gridModel, floor, cameraTransform, polygonSet, profiler);
+        }
+
+        for (int k = begin; k < end; k++)
+        {
+            int i = first + k;
+            recording.readFrame(i, &points[0], &colors[0], false);
+
+            BatchResult& result = results[k];
+            stopWatch.start();
+            Pipeline::process(conf, &points[0], sampleGrid, gridModel, result.floor, result.cameraTransform, result.polygonSet, profiler);
+            result.executionTime = stopWatch.elapsedTime();
+            result.frameId = recording.frameId(i);
+            result.time = recording.time(i);
+            processedFrames++;
+        }
+    }
+}
+
+// Returns the latencies of the pipeline stages of the last run. They are recorded
+// separately from the global profiler of the robot control loop.
+const Profiler& BatchProcessor::getProfiler() const
+{
+    return profiler;
+}
+
+// Returns the results of the last run. Result k belongs to frame first+k of the recording.
+const Vector<BatchResult>& BatchProcessor::getResults() const
+{
+    return results;
+}
+
+// Returns the wall clock time of the last run in seconds.
+double BatchProcessor::getRunTime() const
+{
+    return runTime;
+}
+
+// Returns the number of frames processed per second in the last run.
+double BatchProcessor::getThroughput() const
+{
+    return runTime > 0 ? results.size() / runTime : 0;
+}
@@ -0,0 +1,62 @@
+#ifndef BATCHPROCESSOR_H_
+#define BATCHPROCESSOR_H_
+#include <QString>
+#include <atomic>
+#include "Pipeline.h"
+#include "recording/Recording.h"
+
+// The outputs of the pipeline for one frame of a recording.
+struct BatchResult
+{
+    int frameId = 0;
+    double time = 0;
+    Sample floor;
+    Transform3D cameraTransform;
+    PolygonSet polygonSet;
+    double executionTime = 0; // Time spent in the pipeline in seconds.
+};
+
+// Runs the pipeline over the frames of a recording on all cores.
+// Every worker thread has its own pipeline data, and the parameters
+// are taken from a private copy of the config.
+class BatchProcessor
+{
+    Config conf;
+    Recording recording;
+    Vector<BatchResult> results;
+    Profiler profiler; // The latencies of the pipeline stages of the last run.
+    int numThreads;
+    int blockSize;
+    double runTime;
+    std::atomic<bool> cancelled;
+    std::atomic<int> processedFrames;
+
+public:
+
+    BatchProcessor();
+    ~BatchProcessor(){}
+
+    bool open(QString fileName);
+    void close();
+    bool isOpen() const;
+    int numFrames() const;
+
+    void setConfig(const Config& conf);
+    void setThreads(int threads);
+    void setBlockSize(int frames);
+
+    bool run(int first = 0, int count = -1);
+    void cancel();
+    bool wasCancelled() const;
+    int numProcessed() const;
+
+    const Vector<BatchResult>& getResults() const;
+    const Profiler& getProfiler() const;
+    double getRunTime() const;
+    double getThroughput() const;
+
+private:
+    void work(int first, int count, std::atomic<int>* nextBlock);
+};
+
+#endif /* BATCHPROCESSOR_H_ */
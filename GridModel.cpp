@@ -5,7 +5,10 @@
 #include "util/Logger.h"
 #include <iostream>
 #include "util/ColorUtil.h"
+#include "Profiler.h"
+#ifndef HEADLESS
 #include "GL/gl.h"
+#endif
 #include "blackboard/Command.h"
 
 // The grid model is a 2D grid representation of the world. The cell size is
@@ -37,6 +40,7 @@
 GridModel::GridModel()
 {
     maxv = 255;
+    conf = &config;
 }
 
 // Copy constructor.
@@ -52,22 +56,26 @@ GridModel& GridModel::operator=(const GridModel &o)
         return *this;
 
     Grid::operator=(o);
-    M = o.M.clone();
+    o.M.copyTo(M); // Reuses the memory of M when the size matches.
     maxv = o.maxv;
+    conf = o.conf;
 
     return *this;
 }
 
 // The init methods sets up the grid structure (min, max, number of cells) and computes the
-// raster of the grid coordinates. The parameters are computed using the config.
+// raster of the grid coordinates. The parameters are computed using the config, which is
+// also kept by reference for extractPolygons() and has to outlive the grid model.
 // This is where the data matrix M is initialized.
-void GridModel::init()
+void GridModel::init(const Config& conf)
 {
+    this->conf = &conf;
+
     // Set up the grid structure.
     setDim(2);
-    setN(Vec2u(config.gridSize, 100.0)); // Set the number of nodes per dimension.
-    setMin(Vec2(0, -config.gridY)); // Set the minimum values per dimension.
-    setMax(Vec2(config.gridX, config.gridY)); // Set the maximum values per dimension.
+    setN(Vec2u(conf.gridSize, 100.0)); // Set the number of nodes per dimension.
+    setMin(Vec2(0, -conf.gridY)); // Set the minimum values per dimension.
+    setMax(Vec2(conf.gridX, conf.gridY)); // Set the maximum values per dimension.
     rasterize(); // Compute the grid representation.
 
     // Set up the openCV matrix M, the data structure of the grid.
@@ -236,32 +244,54 @@ void GridModel::canny()
     cv::Canny(M, M, 0, 1);
 }
 
-// Converts the grid to a polygonal representation and writes them into state.polygons.
-// The polygons represent a segmentation of the grid.
-// The returned polygons are in transformed state, i.e. their transformation is 0.
+// Converts the grid to a polygonal representation and writes it into polygonSet.
+// The polygons represent a segmentation of the grid and are given in world coordinates.
+// Use PolygonSet::toPolygons() where Polygon objects are needed. The latencies of the
+// stages are recorded in the profiler.
 // The polygons are non-convex and disjunct.
 // The internal algorithm segments the grid by means of contour detection.
 // The edge of the segments is then simplified with the Douglas Peucker algorithm.
-void GridModel::extractPolygons()
+// When topologyPreserving is set in the config, the contours are simplified jointly by the
+// ContourSimplifier, which introduces no new crossings and keeps the polygons disjoint.
+// The polygons are only simple if the contours are, though; the contour of a one cell
+// wide part of a segment touches itself, and so does its polygon, up to the loops that
+// are split off below. Otherwise, each contour is simplified independently, which is
+// faster, but neighbouring polygons may overlap after the simplification.
+void GridModel::extractPolygons(PolygonSet& polygonSet, Profiler& profiler)
 {
     // Segmentation by contour detection.
+    StageTimer timer(profiler, Profiler::CONTOURS);
     cv::Mat M2 = M.clone(); // findContours changes the matrix
     std::vector<std::vector<cv::Point>> segmentsAsContour;
     cv::findContours(M2, segmentsAsContour, /*hierachy,*/ cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
 
     // Douglas Peucker
+    timer.next(Profiler::DOUGLAS_PEUCKER);
     std::vector<std::vector<cv::Point>> segmentsAsPolygonDP;
-    for (int i = 0; i < segmentsAsContour.size(); i++)
+    if (conf->topologyPreserving > 0)
+    {
+        // Simplify all contours jointly so that no new crossings are introduced.
+        std::vector<std::vector<cv::Point>> segments;
+        for (int i = 0; i < segmentsAsContour.size(); i++)
+            if (segmentsAsContour[i].size() >= conf->minimumSegmentSize)
+                segments.push_back(segmentsAsContour[i]);
+        contourSimplifier.simplify(segments, segmentsAsPolygonDP, conf->douglasPeuckerEpsilon);
+    }
+    else
     {
-        if (segmentsAsContour[i].size() >= config.minimumSegmentSize)
+        for (int i = 0; i < segmentsAsContour.size(); i++)
         {
-            std::vector<cv::Point> segmentPoints;
-            cv::approxPolyDP(segmentsAsContour[i], segmentPoints, config.douglasPeuckerEpsilon, true);
-            segmentsAsPolygonDP.push_back(segmentPoints);
+            if (segmentsAsContour[i].size() >= conf->minimumSegmentSize)
+            {
+                std::vector<cv::Point> segmentPoints;
+                cv::approxPolyDP(segmentsAsContour[i], segmentPoints, conf->douglasPeuckerEpsilon, true);
+                segmentsAsPolygonDP.push_back(segmentPoints);
+            }
         }
     }
 
     // Split segments (polygons) that contain loops.
+    timer.next(Profiler::LOOP_SPLIT);
     for (int i = 0; i < segmentsAsPolygonDP.size(); i++)
     {
         for (int j = 0; j < segmentsAsPolygonDP[i].size(); j++)
@@ -290,27 +320,21 @@ void GridModel::extractPolygons()
         }
     }
 
-    // Convert the Douglas Peucker segments to Polygon objects.
+    // Convert the Douglas Peucker segments into the flat polygon set.
     // The DP segments come in pixel coordinates and they need to be transformed
-    // into world coordinates using the grid layout parameters.
+    // into world coordinates using the grid layout parameters. The vertex order
+    // is reversed, because the y axis of the grid points the other way.
+    timer.next(Profiler::CONVERSION);
     Vec2 stride = getStride();
-    state.polygons.clear();
+    const double* gridMin = getMin();
+    polygonSet.clear();
     for (int i = 0; i < segmentsAsPolygonDP.size(); i++)
     {
-        Polygon pol;
-        for (int j = 0; j < segmentsAsPolygonDP[i].size(); j++)
-            pol << Vec2(segmentsAsPolygonDP[i][j].x, segmentsAsPolygonDP[i][j].y);
-        pol.scale(stride.x, stride.y);
-        pol.translate(getMin());
-        pol.transform();
-        pol.reverseOrder();
-        state.polygons << pol;
+        polygonSet.beginPolygon();
+        for (int j = segmentsAsPolygonDP[i].size()-1; j >= 0; j--)
+            polygonSet.addVertex(segmentsAsPolygonDP[i][j].x*stride.x+gridMin[0], segmentsAsPolygonDP[i][j].y*stride.y+gridMin[1]);
+        polygonSet.endPolygon();
     }
-
-    state.numPolygons = state.polygons.size();
-    state.numVertices = 0;
-    for (int i = 0; i < state.polygons.size(); i++)
-        state.numVertices += state.polygons[i].size();
 }
 
 // Evaluates the GridModel at point x using the output value of the cell that contains x.
@@ -396,6 +420,7 @@ void GridModel::draw(QPainter *painter) const
 // OpenGL drawing code.
 void GridModel::draw() const
 {
+#ifndef HEADLESS
     Vec2u n = getN();
     Vec2 stride = getStride();
     Vec2 min = getMin();
@@ -504,6 +529,7 @@ void GridModel::draw() const
     }
 
     glPopMatrix();
+#endif
 }
 
 QDebug operator<<(QDebug dbg, const GridModel &w)
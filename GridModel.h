@@ -7,12 +7,19 @@
 #include "util/Vec2i.h"
 #include "learner/Grid.h"
 #include "geometry/Polygon.h"
+#include "geometry/ContourSimplifier.h"
+#include "geometry/PolygonSet.h"
+#include "blackboard/Config.h"
 #include "opencv2/imgproc/imgproc.hpp"
 
+class Profiler;
+
 class GridModel : public Grid
 {
     cv::Mat M;
     uchar maxv;
+    ContourSimplifier contourSimplifier;
+    const Config* conf; // The parameters, given in init().
 
 public:
 
@@ -21,7 +28,7 @@ public:
     GridModel(const GridModel &o);  // copy constructor
     GridModel& operator=(const GridModel &o);
 
-    void init();
+    void init(const Config& conf = config);
     void clear();
 
     uint getWidth() const;
@@ -44,7 +51,7 @@ public:
     const uchar* data() const;
     const uchar* row(const int &r) const;
 
-    void extractPolygons();
+    void extractPolygons(PolygonSet& polygonSet, Profiler& profiler);
 
     bool isOccupied(const Vec2& x) const;
     bool isOccupied(const Vec2u& idx) const;
@@ -0,0 +1,60 @@
+#include "Pipeline.h"
+#include "globals.h"
+#include "Profiler.h"
+
+// Runs the per frame stages of the pipeline on the point cloud given by points,
+// which holds NUMBER_OF_POINTS points. The sample grid and the grid model are
+// the working data of the pipeline and have to be initialized with conf. The
+// sample grid also carries the floor plane over to the next frame. The results
+// are written into floor, cameraTransform and polygonSet.
+// Only the given objects are accessed, neither the state nor the global config.
+// The latency of every stage is recorded in the given profiler.
+void Pipeline::process(const Config& conf, const Vec3* points, SampleGrid& sampleGrid, GridModel& gridModel,
+                       Sample& floor, Transform3D& cameraTransform, PolygonSet& polygonSet, Profiler& profiler)
+{
+    // Run the floor detection.
+    StageTimer timer(profiler, Profiler::SAMPLE_UPDATE);
+    sampleGrid.update(points);
+    timer.stop();
+    floor = sampleGrid.findFloor(profiler); // Times its own stages.
+    timer.next(Profiler::TRANSFORM);
+    cameraTransform.setFromGroundPlane(floor.n, floor.p);
+
+    // Sort all the points into an occupancy map.
+    timer.next(Profiler::BINNING);
+    binPoints(conf, points, cameraTransform, gridModel);
+
+    // Dilate the occupancy map.
+    timer.next(Profiler::DILATE);
+    gridModel.dilate(conf.dilationRadius);
+    timer.next(Profiler::SET_BORDER);
+    gridModel.setBorder(0);
+
+    // Extract the polygons from the occupancy map.
+    timer.stop();
+    gridModel.extractPolygons(polygonSet, profiler); // Times its own stages.
+}
+
+// Clears the grid model and marks the cells that contain at least one of the
+// points between the floor and the ceiling height after the camera transform.
+void Pipeline::binPoints(const Config& conf, const Vec3* points, const Transform3D& cameraTransform, GridModel& gridModel)
+{
+    Vec3 p;
+    gridModel.clear();
+    for (uint i = 0; i < NUMBER_OF_POINTS; i++)
+    {
+        if (points[i].isNull())
+            continue;
+
+        p = cameraTransform * points[i];
+
+        if (p.z < conf.floor || p.z > conf.ceiling)
+            continue;
+
+        if (!gridModel.containsPoint(p))
+            continue;
+
+        Vec2u idx = gridModel.getNodeIndex(p);
+        gridModel.setAt(idx, 255);
+    }
+}
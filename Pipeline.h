@@ -0,0 +1,25 @@
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+#include "util/Vector.h"
+#include "util/Vec3.h"
+#include "util/Transform3D.h"
+#include "geometry/Polygon.h"
+#include "geometry/PolygonSet.h"
+#include "SampleGrid.h"
+#include "GridModel.h"
+#include "blackboard/Config.h"
+#include "Profiler.h"
+
+// The per frame stages of the perception pipeline: floor detection, the
+// occupancy grid and the polygon extraction. All data is passed in, so
+// that several pipelines can process frames concurrently.
+class Pipeline
+{
+public:
+
+    static void process(const Config& conf, const Vec3* points, SampleGrid& sampleGrid, GridModel& gridModel,
+                        Sample& floor, Transform3D& cameraTransform, PolygonSet& polygonSet, Profiler& profiler);
+    static void binPoints(const Config& conf, const Vec3* points, const Transform3D& cameraTransform, GridModel& gridModel);
+};
+
+#endif /* PIPELINE_H_ */
@@ -0,0 +1,366 @@
+#include "PolygonMap.h"
+#include "globals.h"
+#include "blackboard/Config.h"
+#ifndef HEADLESS
+#include "GL/gl.h"
+#endif
+
+// The PolygonMap fuses the polygons extracted in every frame into a persistent
+// obstacle map in the world frame. The polygons of a frame are given in the
+// robot frame, i.e. the camera transform has already been applied and the
+// polygons lie in the ground plane below the robot. The odometry pose of the
+// robot (x, y, theta) transforms them into the world frame.
+//
+// An observed polygon that overlaps one or more map polygons is merged with them
+// into their boolean union. The union is computed by rasterizing the involved
+// polygons into a small local image with the map resolution and extracting the
+// outer contour again, the same way the GridModel extracts polygons from the
+// occupancy grid. An observed polygon that overlaps nothing becomes a new map
+// polygon. The overlapping candidates are found with a spatial hash over the
+// bounding boxes of the map polygons.
+//
+// Map polygons that lie inside the field of view but have not been confirmed by
+// an observation for config.mapRetireTime seconds are retired. Map polygons
+// outside of the field of view are kept, since there is no evidence against them.
+// To bound the memory, the map holds at most config.mapMaxPolygons polygons and
+// the ones that have not been seen the longest are dropped first.
+//
+// Usage:
+//
+// polygonMap.update(polygons, odometryPose, time, view);
+// const Vector<Polygon>& obstacles = polygonMap.getPolygons();
+
+PolygonMap::PolygonMap()
+{
+    cellSize = 1.0;
+    buckets.resize(256);
+    queryStamp = 0;
+}
+
+// Removes all polygons from the map.
+void PolygonMap::clear()
+{
+    entries.clear();
+    freeEntries.clear();
+    for (int i = 0; i < buckets.size(); i++)
+        buckets[i].clear();
+    polygons.clear();
+}
+
+// Fuses the observed polygons into the map. The observed polygons are given in
+// the robot frame, the pose (x, y, theta) is the pose of the robot in the world
+// frame, and view is the observed area in the robot frame.
+void PolygonMap::update(const Vector<Polygon> &observed, const Vec3 &pose, double time, const Box &view)
+{
+    // Transform the observations into the world frame.
+    observations.clear();
+    for (int i = 0; i < observed.size(); i++)
+    {
+        Polygon pol = observed[i];
+        pol.setPos(pose.x, pose.y);
+        pol.setRotation(pose.z);
+        pol.transform();
+        observations << pol;
+    }
+
+    // Merge the observations into the map.
+    Box margin;
+    margin.set(0, 0, config.mapResolution, -config.mapResolution, -config.mapResolution, config.mapResolution);
+    for (int i = 0; i < observations.size(); i++)
+    {
+        const Polygon& obs = observations[i];
+
+        // Find the map polygons that overlap the observation.
+        query(obs.boundingBox()+margin, candidates);
+        group.clear();
+        for (int j = 0; j < candidates.size(); j++)
+            if (overlaps(obs, entries[candidates[j]].polygon))
+                group << candidates[j];
+
+        if (group.isEmpty())
+        {
+            addEntry(obs, time);
+            continue;
+        }
+
+        // Replace the overlapping polygons with the union.
+        involved.clear();
+        involved << obs;
+        double firstSeen = time;
+        int count = 0;
+        for (int j = 0; j < group.size(); j++)
+        {
+            involved << entries[group[j]].polygon;
+            firstSeen = min(firstSeen, entries[group[j]].firstSeen);
+            count = max(count, entries[group[j]].observations);
+            removeEntry(group[j]);
+        }
+
+        unite(involved, unionResult);
+        for (int j = 0; j < unionResult.size(); j++)
+        {
+            int id = addEntry(unionResult[j], time);
+            entries[id].firstSeen = firstSeen;
+            entries[id].observations = count+1;
+        }
+    }
+
+    // Retire the polygons in the field of view that have not been confirmed.
+    double c = cos(-pose.z);
+    double s = sin(-pose.z);
+    for (int i = 0; i < entries.size(); i++)
+    {
+        if (!entries[i].used || entries[i].lastSeen > time-config.mapRetireTime)
+            continue;
+
+        // Transform the corners of the bounding box into the robot frame.
+        const Box& bb = entries[i].polygon.boundingBox();
+        Vec2 corners[4] = {bb.topLeft(), bb.topRight(), bb.bottomLeft(), bb.bottomRight()};
+        bool inView = true;
+        for (int k = 0; k < 4 && inView; k++)
+        {
+            double dx = corners[k].x-pose.x;
+            double dy = corners[k].y-pose.y;
+            inView = view.intersects(Vec2(c*dx-s*dy, s*dx+c*dy));
+        }
+        if (inView)
+            removeEntry(i);
+    }
+
+    // Bound the memory by dropping the polygons that have not been seen the longest.
+    while (size() > config.mapMaxPolygons)
+    {
+        int oldest = -1;
+        for (int i = 0; i < entries.size(); i++)
+            if (entries[i].used && (oldest < 0 || entries[i].lastSeen < entries[oldest].lastSeen))
+                oldest = i;
+        removeEntry(oldest);
+    }
+
+    rebuildHash();
+
+    polygons.clear();
+    for (int i = 0; i < entries.size(); i++)
+        if (entries[i].used)
+            polygons << entries[i].polygon;
+}
+
+// Returns the number of polygons in the map.
+int PolygonMap::size() const
+{
+    return entries.size()-freeEntries.size();
+}
+
+// Returns the polygons of the map in world coordinates.
+const Vector<Polygon> &PolygonMap::getPolygons() const
+{
+    return polygons;
+}
+
+// Writes the ids of the map polygons whose bounding box intersects box into ids.
+void PolygonMap::query(const Box &box, Vector<int> &ids) const
+{
+    ids.clear();
+    queryMarks.ensureSize(entries.size());
+    queryStamp++;
+
+    int cx0 = floor(box.left()/cellSize);
+    int cx1 = floor(box.right()/cellSize);
+    int cy0 = floor(box.bottom()/cellSize);
+    int cy1 = floor(box.top()/cellSize);
+    for (int cy = cy0; cy <= cy1; cy++)
+    {
+        for (int cx = cx0; cx <= cx1; cx++)
+        {
+            const Vector<int>& bucket = buckets[bucketIndex(cx, cy)];
+            for (int i = 0; i < bucket.size(); i++)
+            {
+                int id = bucket[i];
+                if (!entries[id].used || queryMarks[id] == queryStamp)
+                    continue;
+                queryMarks[id] = queryStamp;
+                if (box.intersects(entries[id].polygon.boundingBox()))
+                    ids << id;
+            }
+        }
+    }
+}
+
+// Draws the map polygons in an OpenGL context.
+void PolygonMap::draw() const
+{
+#ifndef HEADLESS
+    glColor3f(0.8, 0.4, 0.0);
+    for (int i = 0; i < polygons.size(); i++)
+        polygons[i].draw();
+#endif
+}
+
+// Adds a polygon to the map and returns its id.
+int PolygonMap::addEntry(const Polygon &pol, double time)
+{
+    int id;
+    if (freeEntries.isEmpty())
+    {
+        id = entries.size();
+        entries << Entry();
+    }
+    else
+    {
+        id = freeEntries.last();
+        freeEntries.resize(freeEntries.size()-1);
+    }
+
+    Entry& e = entries[id];
+    e.polygon = pol;
+    e.firstSeen = time;
+    e.lastSeen = time;
+    e.observations = 1;
+    e.used = true;
+
+    // Insert into the spatial hash.
+    const Box& bb = e.polygon.boundingBox();
+    int cx0 = floor(bb.left()/cellSize);
+    int cx1 = floor(bb.right()/cellSize);
+    int cy0 = floor(bb.bottom()/cellSize);
+    int cy1 = floor(bb.top()/cellSize);
+    for (int cy = cy0; cy <= cy1; cy++)
+        for (int cx = cx0; cx <= cx1; cx++)
+            buckets[bucketIndex(cx, cy)] << id;
+
+    return id;
+}
+
+// Removes a polygon from the map. Its id stays in the spatial hash
+// until the next rebuild, but it is ignored by the queries.
+void PolygonMap::removeEntry(int id)
+{
+    entries[id].used = false;
+    entries[id].polygon.clear();
+    freeEntries << id;
+}
+
+// Rebuilds the spatial hash from the polygons in use.
+void PolygonMap::rebuildHash()
+{
+    for (int i = 0; i < buckets.size(); i++)
+        buckets[i].clear();
+
+    for (int id = 0; id < entries.size(); id++)
+    {
+        if (!entries[id].used)
+            continue;
+        const Box& bb = entries[id].polygon.boundingBox();
+        int cx0 = floor(bb.left()/cellSize);
+        int cx1 = floor(bb.right()/cellSize);
+        int cy0 = floor(bb.bottom()/cellSize);
+        int cy1 = floor(bb.top()/cellSize);
+        for (int cy = cy0; cy <= cy1; cy++)
+            for (int cx = cx0; cx <= cx1; cx++)
+                buckets[bucketIndex(cx, cy)] << id;
+    }
+}
+
+// Returns true if the polygons a and b overlap. The polygons may be nonconvex.
+bool PolygonMap::overlaps(const Polygon &a, const Polygon &b)
+{
+    if (!a.boundingBox().intersects(b.boundingBox()))
+        return false;
+
+    // Crossing edges.
+    segments.clear();
+    segments.add(b);
+    ListIterator<Vec2> it = a.vertexIterator();
+    while (it.hasNext())
+    {
+        const Vec2& v1 = it.peekCur();
+        const Vec2& v2 = it.peekNext();
+        it.next();
+        if (segments.intersects(v1, v2))
+            return true;
+    }
+
+    // Containment.
+    return b.intersects(a.vertexIterator().peekCur()) || a.intersects(b.vertexIterator().peekCur());
+}
+
+// Computes the boolean union of the polygons by rasterizing them with the map
+// resolution and extracting the outer contours. The union can consist of more
+// than one polygon if the polygons do not touch after all. The contours are
+// simplified with config.mapDouglasPeuckerEpsilon, which is given in meters.
+void PolygonMap::unite(const Vector<Polygon> &pols, Vector<Polygon> &result)
+{
+    result.clear();
+
+    double res = config.mapResolution;
+    int pad = 2;
+    double minx = std::numeric_limits<double>::max();
+    double miny = std::numeric_limits<double>::max();
+    double maxx = -std::numeric_limits<double>::max();
+    double maxy = -std::numeric_limits<double>::max();
+    for (int i = 0; i < pols.size(); i++)
+    {
+        const Box& bb = pols[i].boundingBox();
+        minx = min(minx, bb.left());
+        maxx = max(maxx, bb.right());
+        miny = min(miny, bb.bottom());
+        maxy = max(maxy, bb.top());
+    }
+
+    int w = (maxx-minx)/res+2*pad+1;
+    int h = (maxy-miny)/res+2*pad+1;
+    if (w*h > 4000000)
+    {
+        qDebug() << "PolygonMap::unite(): union area too large:" << w << "x" << h;
+        for (int i = 0; i < pols.size(); i++)
+            result << pols[i];
+        return;
+    }
+
+    // Rasterize the polygons.
+    rasterPolygons.resize(pols.size());
+    for (int i = 0; i < pols.size(); i++)
+    {
+        rasterPolygons[i].clear();
+        ListIterator<Vec2> it = pols[i].vertexIterator();
+        while (it.hasNext())
+        {
+            const Vec2& v = it.next();
+            rasterPolygons[i].push_back(cv::Point(round((v.x-minx)/res)+pad, round((v.y-miny)/res)+pad));
+        }
+    }
+    raster.create(h, w, CV_8UC1);
+    raster.setTo(cv::Scalar(0));
+    // Polygons are filled one by one, since a single fillPoly() call uses the even-odd
+    // rule and would leave the area where polygons overlap empty.
+    for (uint i = 0; i < rasterPolygons.size(); i++)
+    {
+        if (rasterPolygons[i].empty())
+            continue;
+        const cv::Point* points = &rasterPolygons[i][0];
+        int numPoints = rasterPolygons[i].size();
+        cv::fillPoly(raster, &points, &numPoints, 1, cv::Scalar(255));
+    }
+
+    // Extract the outer contours and convert them back to world coordinates.
+    cv::findContours(raster, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    std::vector<cv::Point> approx;
+    for (uint i = 0; i < contours.size(); i++)
+    {
+        cv::approxPolyDP(contours[i], approx, config.mapDouglasPeuckerEpsilon/res, true);
+        if (approx.size() < 3)
+            continue;
+
+        Polygon pol;
+        for (uint j = 0; j < approx.size(); j++)
+            pol << Vec2((approx[j].x-pad)*res+minx, (approx[j].y-pad)*res+miny);
+        pol.reverseOrder();
+        result << pol;
+    }
+}
+
+// Returns the hash bucket of the cell (cx, cy).
+uint PolygonMap::bucketIndex(int cx, int cy) const
+{
+    return ((uint)(cx*73856093) ^ (uint)(cy*19349663)) & (buckets.size()-1);
+}
@@ -0,0 +1,68 @@
+#ifndef POLYGONMAP_H_
+#define POLYGONMAP_H_
+#include "util/Vector.h"
+#include "util/Vec2.h"
+#include "util/Vec3.h"
+#include "geometry/Polygon.h"
+#include "geometry/Box.h"
+#include "geometry/SegmentSet.h"
+#include "opencv2/imgproc/imgproc.hpp"
+
+class PolygonMap
+{
+    // A fused obstacle in the map.
+    struct Entry
+    {
+        Polygon polygon; // World coordinates, transformed.
+        double firstSeen = 0;
+        double lastSeen = 0;
+        int observations = 0;
+        bool used = false;
+    };
+
+    Vector<Entry> entries; // Entry slots.
+    Vector<int> freeEntries; // Indices of unused entry slots.
+
+    // Spatial hash over the bounding boxes of the entries.
+    double cellSize;
+    Vector<Vector<int> > buckets;
+    mutable Vector<int> queryMarks;
+    mutable int queryStamp;
+
+    Vector<Polygon> polygons; // Compact output of all map polygons.
+
+    // Scratch buffers.
+    Vector<Polygon> observations;
+    Vector<int> group;
+    Vector<int> candidates;
+    Vector<Polygon> involved;
+    Vector<Polygon> unionResult;
+    SegmentSet segments;
+    cv::Mat raster;
+    std::vector<std::vector<cv::Point> > rasterPolygons;
+    std::vector<std::vector<cv::Point> > contours;
+
+public:
+
+    PolygonMap();
+    ~PolygonMap(){}
+
+    void clear();
+    void update(const Vector<Polygon>& observed, const Vec3& pose, double time, const Box& view);
+
+    int size() const;
+    const Vector<Polygon>& getPolygons() const;
+    void query(const Box& box, Vector<int>& ids) const;
+
+    void draw() const;
+
+private:
+    int addEntry(const Polygon& pol, double time);
+    void removeEntry(int id);
+    void rebuildHash();
+    bool overlaps(const Polygon& a, const Polygon& b);
+    void unite(const Vector<Polygon>& pols, Vector<Polygon>& result);
+    uint bucketIndex(int cx, int cy) const;
+};
+
+#endif
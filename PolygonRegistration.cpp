@@ -0,0 +1,336 @@
+#include "PolygonRegistration.h"
+#include "globals.h"
+#include "blackboard/Config.h"
+#include "util/OdometryBuffer.h"
+
+// The PolygonRegistration aligns the polygons of the current frame with a set of
+// reference polygons, typically the polygons of the previous frame or the polygons
+// of the PolygonMap, and estimates the planar pose delta between them. This can be
+// used to correct the drift of the wheel odometry. Since the polygons describe the
+// scene with a few hundred vertices rather than with a point cloud, a registration
+// costs microseconds.
+//
+// The algorithm is a point to edge ICP. The edges of the current polygons are sampled
+// with a spacing of config.registrationSampleStep, and the sample points are matched
+// to their nearest reference edge within config.registrationMaxDistance. The nearest
+// edges are found with a bucket grid over the reference edges. Then, the pose update
+// that minimizes the sum of the squared distances of the points to the lines of their
+// matched edges is computed in closed form from the linearized 3x3 normal equations.
+// This is repeated until the update is negligible or config.registrationIterations
+// iterations have been performed. The point and edge data are kept in structure of
+// arrays layout so that the inner loops vectorize.
+//
+// The pose delta (x, y, theta) transforms points from the current frame into the
+// reference frame, i.e. it is the motion of the robot from the reference pose to the
+// current pose expressed in the reference frame. The initial guess is the relative
+// odometry pose. Usage:
+//
+// registration.setReference(previousPolygons, previousOdometryPose);
+// registration.match(polygons, state.odometryPose);
+// Vec3 delta = registration.getDelta();
+
+PolygonRegistration::PolygonRegistration()
+{
+    hasReference = false;
+    cellSize = 0.3;
+    minX = minY = 0;
+    cellsX = cellsY = 0;
+    rmse = 0;
+    inliers = 0;
+    iterations = 0;
+    converged = false;
+}
+
+// Forgets the reference.
+void PolygonRegistration::clear()
+{
+    reference.clear();
+    hasReference = false;
+}
+
+// Returns true if a reference has been set.
+bool PolygonRegistration::isValid() const
+{
+    return hasReference;
+}
+
+// Sets the reference polygons. The pose is the odometry pose at which the
+// reference polygons were observed and it is used to compute the initial
+// guess of the next match.
+void PolygonRegistration::setReference(const Vector<Polygon> &polygons, const Vec3 &pose)
+{
+    reference.clear();
+    reference.add(polygons);
+    referencePose = pose;
+    hasReference = (reference.size() > 0);
+    if (!hasReference)
+        return;
+
+    // Copy the edges into plain arrays for the nearest edge queries.
+    ax.resize(reference.size());
+    ay.resize(reference.size());
+    bx.resize(reference.size());
+    by.resize(reference.size());
+    for (int i = 0; i < reference.size(); i++)
+    {
+        Vec2 a = reference.p1(i);
+        Vec2 b = reference.p2(i);
+        ax[i] = a.x;
+        ay[i] = a.y;
+        bx[i] = b.x;
+        by[i] = b.y;
+    }
+
+    // Build the bucket grid over the reference edges.
+    cellSize = max((double)config.registrationMaxDistance, 0.05);
+    double maxX = minX = ax[0];
+    double maxY = minY = ay[0];
+    for (int i = 0; i < reference.size(); i++)
+    {
+        minX = min(minX, min(ax[i], bx[i]));
+        maxX = max(maxX, max(ax[i], bx[i]));
+        minY = min(minY, min(ay[i], by[i]));
+        maxY = max(maxY, max(ay[i], by[i]));
+    }
+    while ((maxX-minX)/cellSize*(maxY-minY)/cellSize > 100000)
+        cellSize *= 2;
+    cellsX = (maxX-minX)/cellSize+1;
+    cellsY = (maxY-minY)/cellSize+1;
+
+    // Counting sort of the edges into the cells their bounding box overlaps.
+    cellStart.resize(cellsX*cellsY+1);
+    cellStart.fill(0);
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int i = 0; i < reference.size(); i++)
+        {
+            int cx0 = (min(ax[i], bx[i])-minX)/cellSize;
+            int cx1 = (max(ax[i], bx[i])-minX)/cellSize;
+            int cy0 = (min(ay[i], by[i])-minY)/cellSize;
+            int cy1 = (max(ay[i], by[i])-minY)/cellSize;
+            for (int cy = cy0; cy <= cy1; cy++)
+            {
+                for (int cx = cx0; cx <= cx1; cx++)
+                {
+                    if (pass == 0)
+                        cellStart[cy*cellsX+cx+1]++;
+                    else
+                        cellSegments[cellStart[cy*cellsX+cx]++] = i;
+                }
+            }
+        }
+
+        if (pass == 0)
+        {
+            for (int i = 1; i < cellStart.size(); i++)
+                cellStart[i] += cellStart[i-1];
+            cellSegments.resize(cellStart.last());
+        }
+        else
+        {
+            for (int i = cellStart.size()-1; i > 0; i--)
+                cellStart[i] = cellStart[i-1];
+            cellStart[0] = 0;
+        }
+    }
+}
+
+// Matches the polygons to the reference. The pose is the odometry pose at which
+// the polygons were observed. The initial guess is the odometry motion since the
+// reference. Returns true if the registration converged.
+bool PolygonRegistration::match(const Vector<Polygon> &polygons, const Vec3 &pose)
+{
+    return match(polygons, pose, OdometryBuffer::relativePose(referencePose, pose));
+}
+
+// Matches the polygons to the reference starting from the initial guess.
+// Returns true if the registration converged.
+bool PolygonRegistration::match(const Vector<Polygon> &polygons, const Vec3 &pose, const Vec3 &guess)
+{
+    delta = guess;
+    rmse = 0;
+    inliers = 0;
+    iterations = 0;
+    converged = false;
+
+    if (!hasReference)
+        return false;
+
+    samplePoints(polygons);
+    if (px.size() < 3)
+        return false;
+
+    double tx = guess.x;
+    double ty = guess.y;
+    double theta = guess.z;
+    double maxDist = config.registrationMaxDistance;
+
+    for (iterations = 1; iterations <= config.registrationIterations; iterations++)
+    {
+        double c = cos(theta);
+        double s = sin(theta);
+
+        // Accumulate the normal equations A x = b of the linearized problem.
+        double A[3][3] = {{0,0,0},{0,0,0},{0,0,0}};
+        double b[3] = {0,0,0};
+        double sse = 0;
+        inliers = 0;
+        for (int i = 0; i < px.size(); i++)
+        {
+            double x = c*px[i]-s*py[i]+tx;
+            double y = s*px[i]+c*py[i]+ty;
+            double qx, qy, nx, ny;
+            if (nearestSegment(x, y, maxDist, qx, qy, nx, ny) < 0)
+                continue;
+
+            double r = nx*(x-qx)+ny*(y-qy);
+            double J[3] = {nx, ny, ny*x-nx*y};
+            for (int j = 0; j < 3; j++)
+            {
+                for (int k = 0; k < 3; k++)
+                    A[j][k] += J[j]*J[k];
+                b[j] -= J[j]*r;
+            }
+            sse += r*r;
+            inliers++;
+        }
+
+        if (inliers < 3)
+            break;
+        rmse = sqrt(sse/inliers);
+
+        // Solve the 3x3 system with Cramer's rule.
+        double det = A[0][0]*(A[1][1]*A[2][2]-A[1][2]*A[2][1])
+                   - A[0][1]*(A[1][0]*A[2][2]-A[1][2]*A[2][0])
+                   + A[0][2]*(A[1][0]*A[2][1]-A[1][1]*A[2][0]);
+        if (fabs(det) < EPSILON)
+            break;
+        double dx = (b[0]*(A[1][1]*A[2][2]-A[1][2]*A[2][1])
+                   - A[0][1]*(b[1]*A[2][2]-A[1][2]*b[2])
+                   + A[0][2]*(b[1]*A[2][1]-A[1][1]*b[2]))/det;
+        double dy = (A[0][0]*(b[1]*A[2][2]-A[1][2]*b[2])
+                   - b[0]*(A[1][0]*A[2][2]-A[1][2]*A[2][0])
+                   + A[0][2]*(A[1][0]*b[2]-b[1]*A[2][0]))/det;
+        double dt = (A[0][0]*(A[1][1]*b[2]-b[1]*A[2][1])
+                   - A[0][1]*(A[1][0]*b[2]-b[1]*A[2][0])
+                   + b[0]*(A[1][0]*A[2][1]-A[1][1]*A[2][0]))/det;
+
+        // Apply the update on the left: p -> R(dt)p + (dx,dy).
+        double cd = cos(dt);
+        double sd = sin(dt);
+        double ntx = cd*tx-sd*ty+dx;
+        double nty = sd*tx+cd*ty+dy;
+        tx = ntx;
+        ty = nty;
+        theta += dt;
+
+        if (fabs(dx) < 1e-5 && fabs(dy) < 1e-5 && fabs(dt) < 1e-5)
+        {
+            converged = true;
+            break;
+        }
+    }
+
+    delta = Vec3(tx, ty, picut(theta));
+    return converged;
+}
+
+// Returns the estimated pose delta (x, y, theta) from the reference to the current frame.
+Vec3 PolygonRegistration::getDelta() const
+{
+    return delta;
+}
+
+// Returns the root mean square point to edge distance of the last match.
+double PolygonRegistration::getError() const
+{
+    return rmse;
+}
+
+// Returns the number of points that were matched to an edge in the last match.
+int PolygonRegistration::getInliers() const
+{
+    return inliers;
+}
+
+// Returns the number of iterations of the last match.
+int PolygonRegistration::getIterations() const
+{
+    return iterations;
+}
+
+// Returns true if the last match converged.
+bool PolygonRegistration::hasConverged() const
+{
+    return converged;
+}
+
+// Samples points along the edges of the polygons.
+void PolygonRegistration::samplePoints(const Vector<Polygon> &polygons)
+{
+    px.clear();
+    py.clear();
+    double step = max(config.registrationSampleStep, 0.01);
+    for (int i = 0; i < polygons.size(); i++)
+    {
+        ListIterator<Vec2> it = polygons[i].vertexIterator();
+        while (it.hasNext())
+        {
+            const Vec2& a = it.peekCur();
+            const Vec2& b = it.peekNext();
+            it.next();
+            double len = (b-a).norm();
+            int n = max(1, (int)(len/step));
+            for (int k = 0; k < n; k++)
+            {
+                double t = (double)k/n;
+                px << a.x+t*(b.x-a.x);
+                py << a.y+t*(b.y-a.y);
+            }
+        }
+    }
+}
+
+// Finds the reference edge closest to the point (x,y) within maxDist. The closest
+// point on the edge is written into (qx,qy) and the normal of the edge into (nx,ny).
+// Returns the index of the edge or -1 if there is none within maxDist.
+int PolygonRegistration::nearestSegment(double x, double y, double maxDist, double &qx, double &qy, double &nx, double &ny) const
+{
+    int cx0 = max(0, (int)floor((x-maxDist-minX)/cellSize));
+    int cx1 = min(cellsX-1, (int)floor((x+maxDist-minX)/cellSize));
+    int cy0 = max(0, (int)floor((y-maxDist-minY)/cellSize));
+    int cy1 = min(cellsY-1, (int)floor((y+maxDist-minY)/cellSize));
+
+    int best = -1;
+    double bestD2 = maxDist*maxDist;
+    for (int cy = cy0; cy <= cy1; cy++)
+    {
+        for (int cx = cx0; cx <= cx1; cx++)
+        {
+            int cell = cy*cellsX+cx;
+            for (int k = cellStart[cell]; k < cellStart[cell+1]; k++)
+            {
+                int i = cellSegments[k];
+                double dx = bx[i]-ax[i];
+                double dy = by[i]-ay[i];
+                double l2 = dx*dx+dy*dy;
+                double t = (l2 > 0) ? bound(0.0, ((x-ax[i])*dx+(y-ay[i])*dy)/l2, 1.0) : 0.0;
+                double ex = ax[i]+t*dx-x;
+                double ey = ay[i]+t*dy-y;
+                double d2 = ex*ex+ey*ey;
+                if (d2 < bestD2)
+                {
+                    bestD2 = d2;
+                    best = i;
+                    qx = ax[i]+t*dx;
+                    qy = ay[i]+t*dy;
+                    double l = sqrt(l2);
+                    nx = (l > 0) ? -dy/l : 0;
+                    ny = (l > 0) ? dx/l : 0;
+                }
+            }
+        }
+    }
+
+    return best;
+}
@@ -0,0 +1,54 @@
+#ifndef POLYGONREGISTRATION_H_
+#define POLYGONREGISTRATION_H_
+#include "util/Vector.h"
+#include "util/Vec2.h"
+#include "util/Vec3.h"
+#include "geometry/Polygon.h"
+#include "geometry/SegmentSet.h"
+
+class PolygonRegistration
+{
+    // The reference edges and a bucket grid over them.
+    SegmentSet reference;
+    Vector<double> ax, ay, bx, by;
+    Vec3 referencePose;
+    bool hasReference;
+    double cellSize;
+    double minX, minY;
+    int cellsX, cellsY;
+    Vector<int> cellStart;
+    Vector<int> cellSegments;
+
+    // The source points in structure of arrays layout.
+    Vector<double> px, py;
+
+    // The result of the last match.
+    Vec3 delta;
+    double rmse;
+    int inliers;
+    int iterations;
+    bool converged;
+
+public:
+
+    PolygonRegistration();
+    ~PolygonRegistration(){}
+
+    void clear();
+    bool isValid() const;
+    void setReference(const Vector<Polygon>& polygons, const Vec3& pose = Vec3());
+    bool match(const Vector<Polygon>& polygons, const Vec3& pose = Vec3());
+    bool match(const Vector<Polygon>& polygons, const Vec3& pose, const Vec3& guess);
+
+    Vec3 getDelta() const;
+    double getError() const;
+    int getInliers() const;
+    int getIterations() const;
+    bool hasConverged() const;
+
+private:
+    void samplePoints(const Vector<Polygon>& polygons);
+    int nearestSegment(double x, double y, double maxDist, double& qx, double& qy, double& nx, double& ny) const;
+};
+
+#endif
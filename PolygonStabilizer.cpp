@@ -0,0 +1,280 @@
+#include "PolygonStabilizer.h"
+#include "globals.h"
+#include "blackboard/Config.h"
+#include "util/OdometryBuffer.h"
+
+// The PolygonStabilizer removes the frame to frame jitter from the extracted
+// polygons. The vertices of the same obstacle typically move by a grid cell or
+// two from one frame to the next due to sensor noise, which would invalidate
+// everything downstream that is keyed on the obstacle geometry.
+//
+// The stabilizer keeps a set of tracks in the world frame. In every update, the
+// observed polygons are transformed into the world frame with the odometry pose
+// and associated with the tracks by the overlap of their bounding boxes. The
+// candidate pairs come from a sweep and prune broadphase and the assignment is
+// greedy, best overlap first. For an associated pair, every observed vertex that
+// lies within config.stabilizationTolerance of a track vertex snaps to the track
+// vertex. If every observed vertex snapped and every track vertex was used, the
+// track is "unchanged" and keeps its polygon exactly. Otherwise, the track takes
+// over the snapped polygon.
+//
+// Appearance and disappearance are subject to hysteresis. A new track is only
+// output after it has been observed in config.stabilizationAppear consecutive
+// frames, and a track that is not observed any more is held for
+// config.stabilizationDisappear frames before it is dropped.
+//
+// The output polygons are given in the robot frame at the given pose, along with
+// a stable id and an unchanged flag per polygon.
+
+PolygonStabilizer::PolygonStabilizer()
+{
+    nextId = 0;
+    changedCount = 0;
+}
+
+// Drops all tracks.
+void PolygonStabilizer::clear()
+{
+    tracks.clear();
+    polygons.clear();
+    unchanged.clear();
+    ids.clear();
+    changedCount = 0;
+}
+
+// Stabilizes the observed polygons. The polygons are given in the robot frame
+// and pose is the odometry pose (x, y, theta) of the robot in the world frame.
+void PolygonStabilizer::update(const Vector<Polygon> &observed, const Vec3 &pose)
+{
+    // Transform the observations into the world frame.
+    observations.clear();
+    for (int i = 0; i < observed.size(); i++)
+    {
+        observations << observed[i];
+        Polygon& pol = observations.last();
+        pol.setPos(pose.x, pose.y);
+        pol.setRotation(pose.z);
+        pol.transform();
+    }
+
+    // Find the candidate pairs with overlapping bounding boxes.
+    trackPolygons.clear();
+    for (int i = 0; i < tracks.size(); i++)
+        trackPolygons << tracks[i].polygon;
+    sap.setBoxes(0, observations);
+    sap.setBoxes(1, trackPolygons);
+    const Vector<SweepAndPrune::Pair>& pairs = sap.findPairs();
+
+    // Score the pairs by the intersection over union of the bounding boxes.
+    matches.clear();
+    for (int i = 0; i < pairs.size(); i++)
+    {
+        const Box& a = observations[pairs[i].a].boundingBox();
+        const Box& b = trackPolygons[pairs[i].b].boundingBox();
+        double w = min(a.right(), b.right())-max(a.left(), b.left());
+        double h = min(a.top(), b.top())-max(a.bottom(), b.bottom());
+        double inter = max(w, 0.0)*max(h, 0.0);
+        double uni = (a.right()-a.left())*(a.top()-a.bottom())+(b.right()-b.left())*(b.top()-b.bottom())-inter;
+        Match m;
+        m.observation = pairs[i].a;
+        m.track = pairs[i].b;
+        m.score = (uni > EPSILON) ? inter/uni : 1.0;
+        if (m.score > 0.3)
+            matches << m;
+    }
+    if (matches.size() > 1)
+        std::sort(&matches[0], &matches[0]+matches.size());
+
+    // Greedy assignment, best overlap first.
+    observationMatched.resize(observations.size());
+    observationMatched.fill(0);
+    for (int i = 0; i < tracks.size(); i++)
+    {
+        tracks[i].matched = false;
+        tracks[i].justConfirmed = false;
+    }
+    for (int i = 0; i < matches.size(); i++)
+    {
+        const Match& m = matches[i];
+        Track& track = tracks[m.track];
+        if (observationMatched[m.observation] || track.matched)
+            continue;
+        observationMatched[m.observation] = 1;
+        track.matched = true;
+        track.unchanged = snap(observations[m.observation], track.polygon);
+        track.hits++;
+        track.misses = 0;
+        if (!track.confirmed && track.hits >= config.stabilizationAppear)
+        {
+            track.confirmed = true;
+            track.justConfirmed = true;
+        }
+    }
+
+    // Tracks that were not observed are held for a while.
+    for (int i = 0; i < tracks.size(); i++)
+    {
+        Track& track = tracks[i];
+        if (track.matched)
+            continue;
+        track.hits = 0;
+        track.misses++;
+        track.unchanged = true;
+    }
+
+    // Drop the tracks that have disappeared. Tentative tracks are dropped immediately.
+    int k = 0;
+    for (int i = 0; i < tracks.size(); i++)
+    {
+        const Track& track = tracks[i];
+        if (track.misses > config.stabilizationDisappear || (!track.confirmed && track.misses > 0))
+            continue;
+        if (k != i)
+            tracks[k] = tracks[i];
+        k++;
+    }
+    tracks.resize(k);
+
+    // Observations without a track start a new one.
+    for (int i = 0; i < observations.size(); i++)
+    {
+        if (observationMatched[i])
+            continue;
+        Track track;
+        track.polygon = observations[i];
+        track.id = nextId++;
+        track.hits = 1;
+        track.confirmed = (config.stabilizationAppear <= 1);
+        track.justConfirmed = track.confirmed;
+        track.matched = true;
+        tracks << track;
+    }
+
+    // Output the confirmed tracks in the robot frame.
+    Vec3 inv = OdometryBuffer::relativePose(pose, Vec3());
+    polygons.clear();
+    unchanged.clear();
+    ids.clear();
+    changedCount = 0;
+    for (int i = 0; i < tracks.size(); i++)
+    {
+        const Track& track = tracks[i];
+        if (!track.confirmed)
+            continue;
+        polygons << track.polygon;
+        Polygon& pol = polygons.last();
+        pol.setPos(inv.x, inv.y);
+        pol.setRotation(inv.z);
+        pol.transform();
+
+        // A track that just got confirmed is new to the output.
+        bool same = track.unchanged && !track.justConfirmed;
+        unchanged << (char)same;
+        ids << track.id;
+        if (!same)
+            changedCount++;
+    }
+}
+
+// Returns the stabilized polygons in the robot frame.
+const Vector<Polygon> &PolygonStabilizer::getPolygons() const
+{
+    return polygons;
+}
+
+// Returns a flag per stabilized polygon that is set if the polygon has not changed since the last update.
+const Vector<char> &PolygonStabilizer::getUnchanged() const
+{
+    return unchanged;
+}
+
+// Returns a stable id per stabilized polygon.
+const Vector<int> &PolygonStabilizer::getIds() const
+{
+    return ids;
+}
+
+// Returns the number of stabilized polygons that have changed or appeared in the last update.
+int PolygonStabilizer::numChanged() const
+{
+    return changedCount;
+}
+
+// Snaps the vertices of the observation to the vertices of the track polygon
+// and updates the track polygon. Returns true if the track polygon is unchanged.
+// If fewer than three vertices are left after the snapping, the track polygon
+// takes over the observation as it is.
+bool PolygonStabilizer::snap(const Polygon &observation, Polygon &track)
+{
+    double tol2 = config.stabilizationTolerance*config.stabilizationTolerance;
+
+    trackVertices.clear();
+    ListIterator<Vec2> jt = track.vertexIterator();
+    while (jt.hasNext())
+        trackVertices << jt.next();
+    int n = trackVertices.size();
+    vertexUsed.resize(n);
+    vertexUsed.fill(0);
+
+    bool allSnapped = true;
+    int firstSnap = -1;
+    int lastSnap = -1;
+    snapped.clear();
+    ListIterator<Vec2> it = observation.vertexIterator();
+    while (it.hasNext())
+    {
+        const Vec2& v = it.next();
+
+        // Find the closest track vertex.
+        int best = -1;
+        double bestD2 = tol2;
+        for (int j = 0; j < n; j++)
+        {
+            double d2 = (v-trackVertices[j]).norm2();
+            if (d2 <= bestD2)
+            {
+                bestD2 = d2;
+                best = j;
+            }
+        }
+
+        if (best < 0)
+        {
+            allSnapped = false;
+            lastSnap = -1;
+            snapped << v;
+            continue;
+        }
+
+        // Consecutive vertices that snap to the same track vertex collapse.
+        if (best == lastSnap)
+            continue;
+        if (snapped.isEmpty())
+            firstSnap = best;
+        vertexUsed[best] = 1;
+        lastSnap = best;
+        snapped << trackVertices[best];
+    }
+
+    // The collapse wraps around the end of the polygon.
+    if (snapped.size() > 1 && lastSnap >= 0 && lastSnap == firstSnap)
+        snapped.resize(snapped.size()-1);
+
+    bool allUsed = true;
+    for (int j = 0; j < n; j++)
+        allUsed = allUsed && vertexUsed[j];
+
+    if (allSnapped && allUsed && snapped.size() == n)
+        return true;
+
+    if (snapped.size() < 3)
+    {
+        track = observation;
+        return false;
+    }
+
+    track.clear();
+    for (int i = 0; i < snapped.size(); i++)
+        track << snapped[i];
+    return false;
+}
@@ -0,0 +1,68 @@
+#ifndef POLYGONSTABILIZER_H_
+#define POLYGONSTABILIZER_H_
+#include "util/Vector.h"
+#include "util/Vec3.h"
+#include "geometry/Polygon.h"
+#include "geometry/SweepAndPrune.h"
+
+class PolygonStabilizer
+{
+    // A polygon that is tracked over consecutive frames.
+    struct Track
+    {
+        Polygon polygon; // World coordinates.
+        int id = 0;
+        int hits = 0; // Number of consecutive frames the polygon was observed.
+        int misses = 0; // Number of consecutive frames the polygon was not observed.
+        bool confirmed = false; // The polygon has been observed often enough to be output.
+        bool justConfirmed = false; // The polygon got confirmed in the last update.
+        bool unchanged = false; // Nothing moved beyond the tolerance in the last update.
+        bool matched = false;
+    };
+
+    // A candidate assignment of an observation to a track.
+    struct Match
+    {
+        int observation;
+        int track;
+        double score;
+        bool operator<(const Match& o) const {return score > o.score;} // Descending order.
+    };
+
+    Vector<Track> tracks;
+    int nextId;
+
+    // Output.
+    Vector<Polygon> polygons;
+    Vector<char> unchanged;
+    Vector<int> ids;
+    int changedCount;
+
+    // Scratch buffers.
+    SweepAndPrune sap;
+    Vector<Polygon> observations;
+    Vector<Polygon> trackPolygons;
+    Vector<Match> matches;
+    Vector<char> observationMatched;
+    Vector<Vec2> trackVertices;
+    Vector<char> vertexUsed;
+    Vector<Vec2> snapped;
+
+public:
+
+    PolygonStabilizer();
+    ~PolygonStabilizer(){}
+
+    void clear();
+    void update(const Vector<Polygon>& observed, const Vec3& pose);
+
+    const Vector<Polygon>& getPolygons() const;
+    const Vector<char>& getUnchanged() const;
+    const Vector<int>& getIds() const;
+    int numChanged() const;
+
+private:
+    bool snap(const Polygon& observation, Polygon& track);
+};
+
+#endif
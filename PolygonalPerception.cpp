@@ -1,6 +1,7 @@
 ﻿#include "PolygonalPerception.h"
 #include <QMainWindow>
 #include <QMenuBar>
+#include <QtConcurrentRun>
 
 PolygonalPerception::PolygonalPerception(QWidget *parent)
     : QMainWindow(parent)
@@ -242,6 +243,7 @@ PolygonalPerception::PolygonalPerception(QWidget *parent)
 	// Animation components.
     tscale = 1;
     recording = false;
+    shownEpoch = 0;
     cfi = 0;
     animationTimer.setInterval(120);
 	connect(&animationTimer, SIGNAL(timeout()), this, SLOT(animate()));
@@ -250,12 +252,20 @@ PolygonalPerception::PolygonalPerception(QWidget *parent)
     connect(this, SIGNAL(frameIndexChangedOut(int)), &cameraViewWidget, SLOT(frameIndexChangedIn(int)));
     //animationTimer.start();
 
+    // Reprocessing of the recording in the background.
+    batchProgressTimer.setInterval(1000);
+    connect(&batchProgressTimer, SIGNAL(timeout()), this, SLOT(reprocessingProgress()));
+    connect(&batchWatcher, SIGNAL(finished()), this, SLOT(reprocessingFinished()));
+
     //record();
     loadStateHistory();
 }
 
 PolygonalPerception::~PolygonalPerception()
 {
+    batch.cancel();
+    batchWatcher.waitForFinished();
+
     QSettings settings;
     settings.setValue("verticalSplitterTop", verticalSplitterTop->saveState());
     settings.setValue("verticalSplitterBottom", verticalSplitterBottom->saveState());
@@ -282,9 +292,15 @@ void PolygonalPerception::toggleConfig()
 // This function is called by the animation timer to update the gui.
 void PolygonalPerception::animate()
 {
-    cfi = bound(0, cfi-tscale, state.size()-1);
+    cfi = bound(0, cfi-tscale, numFrames()-1);
     if (recording)
+    {
+        // Skip the update if the control loop has not completed a step since the last one.
         cfi = 0;
+        if (snapshots.epoch() == shownEpoch)
+            return;
+        shownEpoch = snapshots.epoch();
+    }
     loadFrame(cfi);
 }
 
@@ -302,6 +318,8 @@ void PolygonalPerception::record()
     }
     else
     {
+        // Live data replaces the playback of a recording.
+        framePager.close();
         recording = true;
         openGLWidget.recording = true;
         animationTimer.start();
@@ -341,7 +359,7 @@ void PolygonalPerception::frameBack()
     if (!recording)
     {
         animationTimer.stop();
-        cfi = qMin(cfi+1, state.size()-1);
+        cfi = qMin(cfi+1, numFrames()-1);
         loadFrame(cfi);
     }
 }
@@ -364,7 +382,7 @@ void PolygonalPerception::jumpToStart()
     if (!recording)
     {
         animationTimer.stop();
-        cfi = state.size()-1;
+        cfi = numFrames()-1;
         loadFrame(cfi);
     }
 }
@@ -375,7 +393,7 @@ void PolygonalPerception::jumpToFrame(int f)
     if (!recording)
     {
         animationTimer.stop();
-        cfi = qMax(0, int(state.size()-1 - (double)((state.size()-1) * f)/1000));
+        cfi = qMax(0, int(numFrames()-1 - (double)((numFrames()-1) * f)/1000));
         loadFrame(cfi);
     }
 }
@@ -393,27 +411,54 @@ void PolygonalPerception::loadConfig()
     messageIn("Config reset.");
 }
 
+// Saves the state history to data/statehistory.rec. This is refused while a
+// recording is played back, since the history does not hold the played frames.
 void PolygonalPerception::saveStateHistory()
 {
+    if (framePager.isOpen())
+    {
+        messageIn("Close the recording before saving the state history.");
+        return;
+    }
     state.saveHistory();
     messageIn("State history saved.");
 }
 
 void PolygonalPerception::clearStateHistory()
 {
+    framePager.close();
     state.clear();
+    robotControlLoop.reset();
 }
 
+// Opens the recording for playback. The frames are paged in on demand, so this
+// returns immediately regardless of the length of the recording.
 void PolygonalPerception::loadStateHistory()
 {
     if (recording)
         record();
     messageIn("Loading...");
-    state.loadHistory(config.bufferSize);
+    state.clear();
+    if (!QFile::exists("data/statehistory.rec") && QFile::exists("data/statehistory.dat"))
+        Recording::convert("data/statehistory.dat", "data/statehistory.rec");
+    if (!framePager.open("data/statehistory.rec", config.playbackCacheSize, config.playbackPrefetch))
+    {
+        messageIn("No recording found.");
+        return;
+    }
     jumpToStart();
     messageIn("State history loaded.");
 }
 
+// Returns the number of frames the player can browse. These are the frames of the
+// loaded recording, or the frames in the state history if no recording is loaded.
+int PolygonalPerception::numFrames() const
+{
+    if (framePager.isOpen())
+        return framePager.numFrames();
+    return state.size();
+}
+
 // Global event filter.
 bool PolygonalPerception::eventFilter(QObject *obj, QEvent *event)
 {
@@ -465,6 +510,11 @@ void PolygonalPerception::jumpToEnd()
 {
     if (!recording)
     {
+        if (framePager.isOpen())
+        {
+            loadFrame(0);
+            return;
+        }
         cfi = 0;
         emit progressOut(qMax(0, (int)(1000.0 * ((state.size()-1)-cfi)/(state.size()-1))));
         emit frameIndexChangedOut(cfi);
@@ -481,6 +531,27 @@ void PolygonalPerception::reset()
 // the frame forward, frame backward, and playback functions.
 void PolygonalPerception::loadFrame(int frameIndex)
 {
+    if (framePager.isOpen())
+    {
+        // Page the frame in from the recording. Frame index 0 is the last recorded frame.
+        int r = framePager.numFrames()-1 - frameIndex;
+        int direction = frameIndex <= cfi ? 1 : -1;
+        if (!framePager.load(r, direction, state.pointBuffer, state.colorBuffer))
+            return;
+        state.frameId = framePager.frameId(r);
+        state.time = framePager.time(r);
+
+        // Recompute the frame. It is not buffered, because the history can not hold
+        // all frames of a long recording.
+        robotControlLoop.replayStep(r);
+
+        // The widgets browse the state history, where the current state has index 0.
+        cfi = frameIndex;
+        emit progressOut(qMax(0, (int)(1000.0 * ((numFrames()-1)-cfi)/qMax(1, numFrames()-1))));
+        emit frameIndexChangedOut(0);
+        return;
+    }
+
     if (frameIndex > 0)
     {
         // The browsing of the state history is implemented in a generic way such that
@@ -497,6 +568,58 @@ void PolygonalPerception::loadFrame(int frameIndex)
     emit frameIndexChangedOut(cfi);
 }
 
+// Runs the pipeline with the current config over all frames of the recording
+// on all cores. The batch runs in a background thread, so that the gui stays
+// responsive, and reprocessingFinished() reports the throughput. Calling this
+// again while the batch is running cancels it.
+void PolygonalPerception::reprocessRecording()
+{
+    if (batchWatcher.isRunning())
+    {
+        batch.cancel();
+        messageIn("Cancelling the reprocessing.");
+        return;
+    }
+
+    if (recording)
+        return;
+
+    if (!batch.open("data/statehistory.rec"))
+    {
+        messageIn("No recording found.");
+        return;
+    }
+    batch.setConfig(config);
+    messageIn(QString("Reprocessing %1 frames. Press Ctrl+R again to cancel.").arg(batch.numFrames()));
+    batchWatcher.setFuture(QtConcurrent::run(&batch, &BatchProcessor::run, 0, -1));
+    batchProgressTimer.start();
+}
+
+// Reports the progress of the reprocessing.
+void PolygonalPerception::reprocessingProgress()
+{
+    messageIn(QString("Reprocessed %1 of %2 frames.").arg(batch.numProcessed()).arg(batch.numFrames()));
+}
+
+// Reports the throughput when the reprocessing is done.
+void PolygonalPerception::reprocessingFinished()
+{
+    batchProgressTimer.stop();
+    if (batch.wasCancelled())
+    {
+        messageIn("Reprocessing cancelled.");
+        return;
+    }
+
+    const Vector<BatchResult>& results = batch.getResults();
+    double vertices = 0;
+    for (int i = 0; i < results.size(); i++)
+        vertices += results[i].polygonSet.numVertices();
+    messageIn(QString("Reprocessed %1 frames in %2 s (%3 fps), %4 vertices per frame.")
+              .arg(results.size()).arg(batch.getRunTime(), 0, 'f', 2).arg(batch.getThroughput(), 0, 'f', 1)
+              .arg(vertices/qMax(1, results.size()), 0, 'f', 1));
+}
+
 void PolygonalPerception::toggleFileBuffering()
 {
     command.bufferToFile = !command.bufferToFile;
@@ -506,6 +629,7 @@ void PolygonalPerception::toggleFileBuffering()
     }
     else
     {
+        state.closeFile();
         messageIn("File buffering is disabled.");
     }
 }
@@ -528,6 +652,10 @@ void PolygonalPerception::keyPressEvent(QKeyEvent *event)
     {
         close();
     }
+    else if (event->key() == Qt::Key_R && event->modifiers() & Qt::ControlModifier)
+    {
+        reprocessRecording();
+    }
     else if (event->key() == Qt::Key_Up)
     {
         if (recording)
@@ -4,6 +4,7 @@
 #include "ui_polygonalperception.h"
 #include <QMainWindow>
 #include <QSplitter>
+#include <QFutureWatcher>
 #include "gui/GraphWidget.h"
 #include "gui/ConfigWidget.h"
 #include "gui/CheckBoxWidget.h"
@@ -12,7 +13,10 @@
 #include "blackboard/State.h"
 #include "blackboard/Config.h"
 #include "blackboard/Command.h"
+#include "blackboard/Snapshot.h"
 #include "RobotControlLoop.h"
+#include "recording/FramePager.h"
+#include "BatchProcessor.h"
 
 class PolygonalPerception : public QMainWindow
 {
@@ -35,9 +39,15 @@ class PolygonalPerception : public QMainWindow
     int cfi;
     int tscale;
     bool recording;
+    quint64 shownEpoch; // The epoch of the snapshot shown last while recording.
     QTimer animationTimer;
 
     RobotControlLoop robotControlLoop;
+    FramePager framePager; // Pages the frames of a loaded recording in during playback.
+
+    BatchProcessor batch; // Reprocesses the recording in the background.
+    QFutureWatcher<bool> batchWatcher;
+    QTimer batchProgressTimer;
 
 public:
     PolygonalPerception(QWidget *parent = 0);
@@ -69,6 +79,12 @@ public slots:
     void loadStateHistory();
     void loadFrame(int fi);
     void toggleFileBuffering();
+    void reprocessRecording();
+    void reprocessingProgress();
+    void reprocessingFinished();
+
+private:
+    int numFrames() const;
 
 signals:
     void frameIndexChangedOut(int);
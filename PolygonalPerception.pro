@@ -3,6 +3,7 @@ include(gui/gui.pri)
 include(util/util.pri)
 include(geometry/geometry.pri)
 include(learner/learner.pri)
+include(recording/recording.pri)
 
 TEMPLATE = app
 TARGET = PolygonalPerception
@@ -10,18 +11,31 @@ QT += core \
     gui \
     xml \
     opengl \
-    network
+    network \
+    concurrent
 HEADERS += PolygonalPerception.h \
     RobotControlLoop.h \
     RobotControl.h \
+    Pipeline.h \
+    Profiler.h \
+    BatchProcessor.h \
     GridModel.h \
     globals.h \
-    SampleGrid.h
+    SampleGrid.h \
+    PolygonMap.h \
+    PolygonRegistration.h \
+    PolygonStabilizer.h
 SOURCES += PolygonalPerception.cpp \
     RobotControlLoop.cpp \
     RobotControl.cpp \
+    Pipeline.cpp \
+    Profiler.cpp \
+    BatchProcessor.cpp \
     GridModel.cpp \
     SampleGrid.cpp \
+    PolygonMap.cpp \
+    PolygonRegistration.cpp \
+    PolygonStabilizer.cpp \
     main.cpp
 FORMS += polygonalperception.ui
 RESOURCES +=
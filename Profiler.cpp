@@ -0,0 +1,51 @@
+#include "Profiler.h"
+
+// The stages are timed with StageTimers inside Pipeline::process(), SampleGrid::findFloor()
+// and GridModel::extractPolygons(). A timer costs two clock readings and a few relaxed
+// atomic increments, so the stages stay instrumented in all builds. The profiler is
+// passed into the pipeline. A profiler can be shared by several threads that run the
+// pipeline, for example the workers of a BatchProcessor, and it accumulates until
+// reset() is called.
+
+Profiler profiler;
+
+// Removes all recorded latencies.
+void Profiler::reset()
+{
+    for (int s = 0; s < NUMBER_OF_STAGES; s++)
+        histograms[s].reset();
+}
+
+// Records the latency of a stage in seconds.
+void Profiler::record(int stage, double seconds)
+{
+    histograms[stage].record(seconds);
+}
+
+// Returns the histogram of a stage.
+const LatencyHistogram& Profiler::histogram(int stage) const
+{
+    return histograms[stage];
+}
+
+// Writes the median, the 99th percentile and the maximum latency of every stage
+// in seconds into the given arrays, which have NUMBER_OF_STAGES elements.
+void Profiler::summarize(double* p50, double* p99, double* max) const
+{
+    for (int s = 0; s < NUMBER_OF_STAGES; s++)
+    {
+        p50[s] = histograms[s].percentile(50);
+        p99[s] = histograms[s].percentile(99);
+        max[s] = histograms[s].max();
+    }
+}
+
+// Returns the name of a stage as it is used for the state members and in reports.
+QString Profiler::stageName(int stage)
+{
+    static const char* names[NUMBER_OF_STAGES] = {
+        "sampleUpdate", "prune", "floorSearch", "ols", "transform", "binning",
+        "dilate", "setBorder", "contours", "douglasPeucker", "loopSplit", "conversion"
+    };
+    return (stage >= 0 && stage < NUMBER_OF_STAGES) ? QString(names[stage]) : QString();
+}
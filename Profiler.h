@@ -0,0 +1,88 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+#include <QString>
+#include "util/LatencyHistogram.h"
+#include "util/StopWatch.h"
+
+// Collects the latencies of the individual stages of the perception pipeline
+// in one histogram per stage. The global profiler collects the latencies of
+// the robot control loop. Runs outside of the loop, such as a BatchProcessor,
+// record into their own profiler.
+class Profiler
+{
+public:
+
+    enum Stage
+    {
+        SAMPLE_UPDATE,
+        PRUNE,
+        FLOOR_SEARCH,
+        OLS_FIT,
+        TRANSFORM,
+        BINNING,
+        DILATE,
+        SET_BORDER,
+        CONTOURS,
+        DOUGLAS_PEUCKER,
+        LOOP_SPLIT,
+        CONVERSION,
+        NUMBER_OF_STAGES
+    };
+
+private:
+
+    LatencyHistogram histograms[NUMBER_OF_STAGES];
+
+public:
+
+    Profiler(){}
+    ~Profiler(){}
+
+    void reset();
+    void record(int stage, double seconds);
+    const LatencyHistogram& histogram(int stage) const;
+    void summarize(double* p50, double* p99, double* max) const;
+
+    static QString stageName(int stage);
+};
+
+extern Profiler profiler;
+
+// Measures the time from its construction to its destruction and records it
+// as the latency of a stage in the given profiler. next() ends the current stage and starts the next
+// one, so that consecutive stages can be timed without nesting scopes. stop()
+// ends the current stage without starting another one.
+class StageTimer
+{
+    Profiler& profiler;
+    StopWatch stopWatch;
+    int stage; // -1 when stopped.
+
+public:
+
+    StageTimer(Profiler& profiler, int stage) : profiler(profiler), stage(stage)
+    {
+        stopWatch.start();
+    }
+
+    ~StageTimer()
+    {
+        stop();
+    }
+
+    void next(int stage)
+    {
+        stop();
+        stopWatch.start();
+        this->stage = stage;
+    }
+
+    void stop()
+    {
+        if (stage >= 0)
+            profiler.record(stage, stopWatch.elapsedTime());
+        stage = -1;
+    }
+};
+
+#endif /* PROFILER_H_ */
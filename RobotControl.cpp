@@ -5,6 +5,9 @@
 #include "globals.h"
 #include "util/Statistics.h"
 #include "util/StopWatch.h"
+#include "geometry/Box.h"
+#include "Pipeline.h"
+#include "Profiler.h"
 
 // The RobotControl class implements a classic sense() - act() loop.
 // The sense() and act() functions are called periodically at a
@@ -12,52 +15,116 @@
 
 RobotControl::RobotControl(QObject *parent) : QObject(parent)
 {
-
+    live = true;
 }
 
 // Initialization cascade after construction.
 void RobotControl::init()
 {
     QMutexLocker locker(&state.gMutex);
-    state.gridModel.init();
-    state.sampleGrid.init();
+    state.gridModel.init(config);
+    state.sampleGrid.init(config);
+}
+
+// Drops everything that was accumulated over the previous frames.
+void RobotControl::reset()
+{
+    registration.clear();
+    stabilizer.clear();
+    polygonMap.clear();
+}
+
+// Adds an odometry pose (x, y, theta) of the robot in the world frame measured
+// at the given system time. This is the entry point for an odometry source, which
+// should call it whenever it receives a new pose. None is connected yet, so the
+// odometry buffer stays empty and the polygons are published without motion
+// compensation.
+void RobotControl::addOdometry(double time, const Vec3& pose)
+{
+    odometry.add(time, pose);
+}
+
+// Tells whether the following frames are live. The latency from capture to
+// publication is only measured for live frames. A frame that is restored from
+// the history or replayed from a recording keeps the latency it was recorded
+// with, since its capture time lies in the past.
+void RobotControl::setLive(bool live)
+{
+    this->live = live;
 }
 
 // Processes the sensor input to a world model.
 void RobotControl::sense()
 {   
-    // Run the floor detection.
-    state.sampleGrid.update(); // Pulls samples from the point cloud in state.pointBuffer.
-    state.floor = state.sampleGrid.findFloor();
-    state.cameraTransform.setFromGroundPlane(state.floor.n, state.floor.p);
-
-    // Sort all the points into an occupancy map.
-    Vec3 p;
-    state.gridModel.clear();
-    for (uint i = 0; i < NUMBER_OF_POINTS; i++)
+    // Look up the odometry pose at the time the point cloud was captured.
+    if (!odometry.isEmpty())
+        state.odometryPose = odometry.poseAt(state.captureTime);
+
+    // Detect the floor and extract the polygons from the point cloud.
+    Pipeline::process(config, state.pointBuffer.constData(), state.sampleGrid, state.gridModel,
+                      state.floor, state.cameraTransform, state.polygonSet, profiler);
+    state.numPolygons = state.polygonSet.size();
+    state.numVertices = state.polygonSet.numVertices();
+    state.polygonSet.toPolygons(polygons);
+
+    // Align the polygons with the polygons of the previous frame to estimate
+    // the motion of the robot independently of the odometry.
+    if (registration.isValid())
     {
-        if (state.pointBuffer[i].isNull())
-            continue;
+        registration.match(polygons, state.odometryPose);
+        state.registrationDelta = registration.getDelta();
+        state.registrationError = registration.getError();
+        state.registrationInliers = registration.getInliers();
+    }
+    registration.setReference(polygons, state.odometryPose);
 
-        p = state.cameraTransform * state.pointBuffer[i];
+    // Stabilize the polygons over time.
+    stabilizer.update(polygons, state.odometryPose);
+    state.stablePolygons = stabilizer.getPolygons();
+    state.stablePolygonIds = stabilizer.getIds();
+    state.stablePolygonUnchanged = stabilizer.getUnchanged();
+    state.numChangedPolygons = stabilizer.numChanged();
 
-        if (p.z < config.floor || p.z > config.ceiling)
-            continue;
+    // Fuse the polygons into the world map using the odometry pose.
+    // The observed area is the extent of the grid in the robot frame.
+    const double* gridMin = state.gridModel.getMin();
+    const double* gridMax = state.gridModel.getMax();
+    Box view;
+    view.set(gridMax[1], gridMin[0], gridMin[1], gridMax[0]);
+    polygonMap.update(polygons, state.odometryPose, state.time, view);
+    state.mapPolygons = polygonMap.getPolygons();
+    state.numMapPolygons = polygonMap.size();
 
-        if (!state.gridModel.containsPoint(p))
-            continue;
+    publish();
+}
 
-        Vec2u idx = state.gridModel.getNodeIndex(p);
-        state.gridModel.setAt(idx, 255);
-    }
+// Publishes the stabilized polygons of the current frame. By the time the polygons
+// are extracted, the robot has moved on since the point cloud was captured. The
+// polygons are transformed from the robot frame at the capture time into the
+// robot frame at the publish time using the odometry, and the latency from
+// capture to publication is measured for live frames.
+void RobotControl::publish()
+{
+    state.publishTime = stopWatch.systemTime();
+    if (live)
+        state.latency = state.publishTime - state.captureTime;
 
-    // Dilate the occupancy map.
-    state.gridModel.dilate(config.dilationRadius);
-    state.gridModel.setBorder(0);
+    Vec3 delta;
+    if (!odometry.isEmpty())
+    {
+        Vec3 now = odometry.poseAt(state.publishTime, config.maxExtrapolationTime);
+        delta = OdometryBuffer::relativePose(now, state.odometryPose);
+    }
 
-    // Extract the polygons from the occupancy map.
-    // The polygons are written into state.polygons.
-    state.gridModel.extractPolygons();
+    state.publishedPolygons.clear();
+    for (int i = 0; i < state.stablePolygons.size(); i++)
+    {
+        state.publishedPolygons << state.stablePolygons[i];
+        Polygon& pol = state.publishedPolygons.last();
+        pol.setPos(delta.x, delta.y);
+        pol.setRotation(delta.z);
+        pol.transform();
+    }
 }
 
 // Generates an action for the agent given the current state of the world, goals, and commands.
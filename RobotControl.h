@@ -1,19 +1,36 @@
 #ifndef ROBOTCONTROL_H
 #define ROBOTCONTROL_H
 #include <QObject>
+#include "PolygonRegistration.h"
+#include "PolygonStabilizer.h"
+#include "PolygonMap.h"
+#include "util/OdometryBuffer.h"
+#include "util/StopWatch.h"
 
 class RobotControl : public QObject
 {
     Q_OBJECT
 
+    PolygonRegistration registration; // Aligns the polygons of consecutive frames.
+    PolygonStabilizer stabilizer; // Removes the frame to frame jitter from the polygons.
+    PolygonMap polygonMap; // Obstacle polygons fused over time in the world frame.
+    OdometryBuffer odometry; // Timestamped odometry poses written by the robot interface.
+    Vector<Polygon> polygons; // The polygons of state.polygonSet for the consumers that need Polygon objects.
+    StopWatch stopWatch;
+    bool live; // The frame was just captured, rather than restored from the history or a recording.
+
 public:
 
     RobotControl(QObject *parent = 0);
     ~RobotControl(){}
 
     void init();
+    void reset();
+    void addOdometry(double time, const Vec3& pose);
+    void setLive(bool live);
     void sense();
     void act();
+    void publish();
 
 signals:
     void messageOut(QString);
@@ -2,6 +2,9 @@
 #include "blackboard/State.h"
 #include "blackboard/Config.h"
 #include "blackboard/Command.h"
+#include "blackboard/Snapshot.h"
+#include "blackboard/Telemetry.h"
+#include "Profiler.h"
 #include "util/Statistics.h"
 #include <QDebug>
 
@@ -22,6 +25,9 @@ RobotControlLoop::RobotControlLoop(QObject *parent) : QObject(parent)
 	running = false;
     lastUpdateTimestamp = 0;
     lastStartTimestamp = 0;
+    lastCaptureTimestamp = 0;
+    executionSamples = 0;
+    lastReplayed = -1;
 }
 
 // Initialization cascade after construction.
@@ -33,7 +39,9 @@ void RobotControlLoop::init()
 // Reset to an initial state.
 void RobotControlLoop::reset()
 {
-
+    QMutexLocker locker(&state.gMutex);
+    robotControl.reset();
+    lastReplayed = -1;
 }
 
 // Starts the main control loop.
@@ -54,8 +62,8 @@ void RobotControlLoop::stop()
 // The main loop of the game. It's triggered by the timer.
 void RobotControlLoop::step()
 {
-    // This is a mutex against the gui draw() to avoid thread issues.
-    // Be aware that this does influence the iteration time, but not the execution time.
+    // This is a mutex against other writers of the state. The gui does not take it,
+    // it draws the snapshots published at the end of the step.
     QMutexLocker locker(&state.gMutex);
 
     stopWatch.start();
@@ -66,20 +74,36 @@ void RobotControlLoop::step()
     state.rcIterationTime = state.realTime - lastUpdateTimestamp;
 	lastUpdateTimestamp = state.realTime;
 
+    // The sensor interface stamps the point cloud with its capture time.
+    // If it did not provide a fresh time stamp, the start of the iteration
+    // is the best estimate we have.
+    if (state.captureTime <= lastCaptureTimestamp)
+        state.captureTime = stopWatch.systemTime();
+    lastCaptureTimestamp = state.captureTime;
+
     // Step the robot control (sense, act loop).
     stopWatch.start();
+    robotControl.setLive(true);
     robotControl.sense();
     robotControl.act();
   
 	state.frameId++;
 
-    // Measure execution time.
+    // Measure execution time. The average is the incremental mean over the steps
+    // of this loop, independent of the frame id, which can jump during playback.
     state.rcExecutionTime = stopWatch.elapsedTime();
-    state.avgExecutionTime = (state.avgExecutionTime*state.frameId+state.rcExecutionTime)/(state.frameId+1);
+    executionSamples++;
+    state.avgExecutionTime += (state.rcExecutionTime-state.avgExecutionTime)/executionSamples;
+
+    // Summarize the latencies of the pipeline stages.
+    profiler.summarize(state.stageP50, state.stageP99, state.stageMax);
 
     // Buffer the state into history.
     state.bufferAppend(config.bufferSize);
 
+    // Hand the outputs over to the gui.
+    snapshots.publish(state);
+
     // Buffer also into a file if requested.
     if(command.bufferToFile)
         state.bufferToFile();
@@ -89,7 +113,32 @@ void RobotControlLoop::step()
 // This is to recompute things for a loaded state.
 void RobotControlLoop::smallStep(int frameIndex)
 {
+    robotControl.setLive(false);
     robotControl.sense();
     robotControl.act();
     state.bufferOverwrite(frameIndex);
+    snapshots.publish(state);
+}
+
+// Executes a robot control step for the frame with index r that was paged in from
+// a recording. The frame is neither timed nor buffered in the state history, but
+// it is appended to the telemetry so that the graphs follow the playback. The
+// registration, the stabilizer, the map, and the telemetry assume consecutive
+// frames, so they are reset when the frame does not follow the previously
+// replayed one, e.g. after a jump or when stepping backwards. The graphs then
+// start over at the frame.
+void RobotControlLoop::replayStep(int r)
+{
+    if (r != lastReplayed+1)
+    {
+        robotControl.reset();
+        telemetry.clear();
+    }
+    lastReplayed = r;
+
+    robotControl.setLive(false);
+    robotControl.sense();
+    robotControl.act();
+    telemetry.append(state, config.telemetrySize);
+    snapshots.publish(state);
 }
@@ -14,6 +14,9 @@ class RobotControlLoop : public QObject
     Timer timer; // High precicision timer that drives the rc thread
     double lastUpdateTimestamp;
     double lastStartTimestamp;
+    double lastCaptureTimestamp;
+    int executionSamples; // Number of steps averaged into avgExecutionTime.
+    int lastReplayed; // Index of the last frame replayed from a recording.
 
     RobotControl robotControl;
 
@@ -25,6 +28,7 @@ public:
     void start();
     void stop();
     void smallStep(int frameIndex);
+    void replayStep(int r);
     void reset();
 
 public slots:
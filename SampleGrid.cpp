@@ -3,16 +3,21 @@
 #include "blackboard/Config.h"
 #include "blackboard/State.h"
 #include "util/ColorUtil.h"
+#include "geometry/Polygon.h"
+#include "Profiler.h"
+#include <algorithm>
+#ifndef HEADLESS
 #include <GL/glu.h>
 #include "util/GLlib.h"
-#include "geometry/Polygon.h"
 #include <QGLViewer/qglviewer.h>
+#endif
 
 // The SampleGrid organizes a set of samples taken from the point cloud
 // in a grid structure defined in the pixel coordinates of the camera image.
 // The normals are also computed for every sample in the grid.
 // You can call one of the provided functions to find the floor plane.
 // First, call the init() function once to initialize the grid structure.
+// The config given to init() provides the parameters for all later calls.
 // Then, call the update() function to populate the samples.
 // Then, you can use for example the fitPlaneFlood() function to find
 // the ground plane.
@@ -23,22 +28,25 @@ Vec3 Sample::up = Vec3(0,0,1);
 
 SampleGrid::SampleGrid()
 {
+    conf = &config;
     upVector.z = 1;
     floorPlane.n = upVector;
 }
 
 // Initializes a set of low resolution samples in image coordinates.
-// Config variables determine the size of the grid.
-void SampleGrid::init()
+// Config variables determine the size of the grid. The config is kept
+// by reference and has to outlive the sample grid.
+void SampleGrid::init(const Config& conf)
 {
+    this->conf = &conf;
     samples.clear();
-    for (int k = 0; k < config.samplesY; k++)
+    for (int k = 0; k < conf.samplesY; k++)
     {
         Vector<Sample> V;
-        for (int l = 0; l < config.samplesX; l++)
+        for (int l = 0; l < conf.samplesX; l++)
         {
-            int i = l*(IMAGE_WIDTH-1)/(config.samplesX-1);
-            int j = IMAGE_HEIGHT-1-k*(IMAGE_HEIGHT-1)/(config.samplesY-1);
+            int i = l*(IMAGE_WIDTH-1)/(conf.samplesX-1);
+            int j = IMAGE_HEIGHT-1-k*(IMAGE_HEIGHT-1)/(conf.samplesY-1);
             Sample sample;
             sample.gridIdx = Vec2u(l,k);
             sample.imagePx = Vec2u(i,j);
@@ -50,9 +58,18 @@ void SampleGrid::init()
     }
 }
 
-// Populates the samples with fresh data from state.pointBuffer
+// Forgets the floor plane found in the previous frames, so that the next
+// frame is processed as if it were the first one.
+void SampleGrid::resetFloor()
+{
+    upVector = Vec3(0,0,1);
+    floorPlane = Sample();
+    floorPlane.n = upVector;
+}
+
+// Populates the samples with fresh data from the point cloud
 // and computes the normals of all samples.
-void SampleGrid::update()
+void SampleGrid::update(const Vec3* points)
 {
     //qDebug() << "update start:" << floorAvg.n << floorAvg.p;
     if (upVector*floorPlane.n > 0.5)
@@ -70,7 +87,7 @@ void SampleGrid::update()
     {
         for (int j = 0; j < samples[i].size(); j++)
         {
-            samples[i][j].p = state.pointBuffer[samples[i][j].bufferIdx];
+            samples[i][j].p = points[samples[i][j].bufferIdx];
             samples[i][j].in = !samples[i][j].p.isNull();
         }
     }
@@ -121,7 +138,6 @@ void SampleGrid::setUpVector(const Vec3 &up)
 {
     upVector = up;
     upVector.normalize();
-    Sample::up = upVector;
 }
 
 // Returns the up vector.
@@ -132,18 +148,24 @@ Vec3 SampleGrid::getUpVector() const
 
 // Detects the floor plane by starting flood fills in the vertically
 // sorted pruned samples and accepting the first large plane.
-Sample SampleGrid::findFloor()
+Sample SampleGrid::findFloor(Profiler& profiler)
 {
-    if (config.debugLevel > 0)
+    if (conf->debugLevel > 0)
         qDebug() << "SampleGrid::findFloor(): up:" << upVector;
 
+    StageTimer timer(profiler, Profiler::PRUNE);
     prune();
 
     if (prunedSamples.size() < 2)
         return floorPlane;
 
-    // Sort by z coordinate.
-    prunedSamples.sort();
+    timer.next(Profiler::FLOOR_SEARCH);
+
+    // Sort by height along the up vector of this grid. Sample::up is not used,
+    // because it is shared by all sample grids.
+    const Vec3 up = upVector;
+    std::sort(&prunedSamples[0], &prunedSamples[0]+prunedSamples.size(),
+              [up](const Sample& a, const Sample& b) {return up*a.p < up*b.p;});
 
     // Reset things.
     planes.clear();
@@ -154,7 +176,7 @@ Sample SampleGrid::findFloor()
     // Start a flood fill at every point in the sorted pruned set.
     for (int i = 2; i < prunedSamples.size()-1; i++)
     {
-        if (config.debugLevel > 0)
+        if (conf->debugLevel > 0)
             qDebug() << "Trying" << prunedSamples[i].p << upVector*prunedSamples[i].p << "in:" << isIn(prunedSamples[i].gridIdx);
 
         if (!isIn(prunedSamples[i].gridIdx))
@@ -179,11 +201,11 @@ Sample SampleGrid::findFloor()
         planeAvg << avg;
         planes << planeCluster;
 
-        if (config.debugLevel > 0)
+        if (conf->debugLevel > 0)
             qDebug() << "New cluster:" << planeCluster.size() << "(" << floorSegment.size() << ")" << avg << "dist:" << floorPlane.distance(avg);
 
         // Merge the cluster with the floor plane if the distance is close.
-        if (floorPlane.distance(avg) < config.mergeThreshold)
+        if (floorPlane.distance(avg) < conf->mergeThreshold)
         {
             // Merge the new cluster into the floor.
             floorPlane.p = (floorPlane.p*floorSegment.size()+avg.p*planeCluster.size())/(floorSegment.size()+planeCluster.size());
@@ -191,7 +213,7 @@ Sample SampleGrid::findFloor()
             floorPlane.n.normalize();
             floorSegment << planeCluster;
 
-            if (config.debugLevel > 0)
+            if (conf->debugLevel > 0)
                 qDebug() << "Merged with floor. New rep:" << floorPlane;
         }
 
@@ -202,12 +224,19 @@ Sample SampleGrid::findFloor()
             floorSegment.clear();
             floorSegment << planeCluster;
 
-            if (config.debugLevel > 0)
+            if (conf->debugLevel > 0)
                 qDebug() << "Replaced floor." << floorSegment.size() << "avg:" << floorPlane;
         }
     }
 
+    // Compute the convex hull of the floor segment.
+    floorPoints.clear();
+    for (int i = 0; i < floorSegment.size(); i++)
+        floorPoints << Vec2(floorSegment[i].p.x, floorSegment[i].p.y);
+    hull.convexHull(floorPoints, floorHull);
+
     // Fit a plane to the points in the floor segment.
+    timer.next(Profiler::OLS_FIT);
     if (floorSegment.size() > 2)
     {
         ols.reset();
@@ -221,6 +250,13 @@ Sample SampleGrid::findFloor()
     return floorPlane;
 }
 
+// Returns the convex hull of the floor segment found in the last call of findFloor().
+// The hull is given in world coordinates in ccw order.
+const Vector<Vec2>& SampleGrid::getFloorHull() const
+{
+    return floorHull;
+}
+
 // Collects neighbouring samples into the planeCluster vector based on their distance function.
 // This is a simple recursive four-neighbour implementation.
 void SampleGrid::floodFill(const Vec2u &parentIdx)
@@ -232,43 +268,43 @@ void SampleGrid::floodFill(const Vec2u &parentIdx)
     parent.in = false;
     planeCluster << parent;
 
-    if (config.debugLevel > 1)
+    if (conf->debugLevel > 1)
         qDebug() << "   pushed" << parent.gridIdx << parent;
 
     if (parent.gridIdx.x > 0)
     {
         Vec2u childIdx = parent.gridIdx - Vec2u(1,0);
         Sample& child = samples[childIdx.y][childIdx.x];
-        if (config.debugLevel > 1)
+        if (conf->debugLevel > 1)
             qDebug() << "   dist:" << childIdx << parent.distance(child) << "parent:" << parent << "child:" << child;
-        if (parent.distance(child) < config.floodThreshold)
+        if (parent.distance(child) < conf->floodThreshold)
             floodFill(childIdx);
     }
-    if (parent.gridIdx.x < config.samplesX-1)
+    if (parent.gridIdx.x < conf->samplesX-1)
     {
         Vec2u childIdx = parent.gridIdx + Vec2u(1,0);
         Sample& child = samples[childIdx.y][childIdx.x];
-        if (config.debugLevel > 1)
+        if (conf->debugLevel > 1)
             qDebug() << "   dist:" << childIdx << parent.distance(child) << "parent:" << parent << "child:" << child;
-        if (parent.distance(child) < config.floodThreshold)
+        if (parent.distance(child) < conf->floodThreshold)
             floodFill(childIdx);
     }
     if (parent.gridIdx.y > 0)
     {
         Vec2u childIdx = parent.gridIdx - Vec2u(0,1);
         Sample& child = samples[childIdx.y][childIdx.x];
-        if (config.debugLevel > 1)
+        if (conf->debugLevel > 1)
             qDebug() << "   dist:" << childIdx << parent.distance(child) << "parent:" << parent << "child:" << child;
-        if (parent.distance(child) < config.floodThreshold)
+        if (parent.distance(child) < conf->floodThreshold)
             floodFill(childIdx);
     }
-    if (parent.gridIdx.y < config.samplesY-1)
+    if (parent.gridIdx.y < conf->samplesY-1)
     {
         Vec2u childIdx = parent.gridIdx + Vec2u(0,1);
         Sample& child = samples[childIdx.y][childIdx.x];
-        if (config.debugLevel > 1)
+        if (conf->debugLevel > 1)
             qDebug() << "   dist:" << childIdx << parent.distance(child) << "parent:" << parent << "child:" << child;
-        if (parent.distance(child) < config.floodThreshold)
+        if (parent.distance(child) < conf->floodThreshold)
             floodFill(childIdx);
     }
 }
@@ -285,7 +321,7 @@ void SampleGrid::prune()
                 continue;
 
             samples[i][j].angle = samples[i][j].n*upVector; // A scalar product-based upright check.
-            if (samples[i][j].angle > config.pruneThreshold)
+            if (samples[i][j].angle > conf->pruneThreshold)
             {
                 prunedSamples << samples[i][j];
             }
@@ -413,6 +449,7 @@ void SampleGrid::drawSamples(QPainter *painter) const
 // Draws a visualization of the samples and the normals in an OpenGL context.
 void SampleGrid::drawSamples() const
 {
+#ifndef HEADLESS
     glLineWidth(2);
 
     // Draw the normal vectors of all samples.
@@ -491,22 +528,14 @@ void SampleGrid::drawSamples() const
         }
     }
 
-    // Compute and draw the convex hull of the floor segment.
+    // Draw the convex hull of the floor segment.
     if (true)
     {
-        Polygon pol;
-        for (int i = 0; i < floorSegment.size(); i++)
-            pol << floorSegment[i].p;
-        Polygon ch = pol.convexHull();
         glLineWidth(6);
         glColor3f(0, 0, 1.0);
         glBegin(GL_LINE_LOOP);
-        ListIterator<Vec2> it = ch.vertexIterator();
-        while (it.hasNext())
-        {
-            Vec2& v = it.next();
-            glVertex3f(v.x, v.y, floorPlane.evaluateAt(v));
-        }
+        for (int i = 0; i < floorHull.size(); i++)
+            glVertex3f(floorHull[i].x, floorHull[i].y, floorPlane.evaluateAt(floorHull[i]));
         glEnd();
     }
 
@@ -552,6 +581,7 @@ void SampleGrid::drawSamples() const
         QGLViewer::drawArrow(qglviewer::Vec(0,0,0), qglviewer::Vec(upVector.normalized(0.3)), 0.01);
         glPopMatrix();
     }
+#endif
 }
 
 QDebug operator<<(QDebug dbg, const SampleGrid &o)
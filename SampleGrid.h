@@ -4,8 +4,12 @@
 #include "util/Vec2u.h"
 #include "util/Vec3.h"
 #include "learner/OLS.h"
+#include "geometry/Hull.h"
+#include "blackboard/Config.h"
 #include <QPainter>
 
+class Profiler;
+
 // A sample s = (p,n) is a point p and a normal n that together
 // desribe a plane. A sample is gained from the RGB-D image, so
 // it also has pixel coordinates, a bufferIdx in the point buffer,
@@ -98,18 +102,26 @@ class SampleGrid
     Vec3 upVector; // The up vector the samples are pruned against.
     OLS ols; // Linear fitter.
 
+    Hull hull; // Hull engine with reusable buffers.
+    Vector<Vec2> floorPoints; // The floor segment projected to the xy plane.
+    Vector<Vec2> floorHull; // The convex hull of the floor segment.
+
+    const Config* conf; // The parameters, given in init().
+
 public:
 
     SampleGrid();
     ~SampleGrid(){}
 
-    void init();
-    void update();
+    void init(const Config& conf = config);
+    void update(const Vec3* points);
+    void resetFloor();
 
     void setUpVector(const Vec3& up);
     Vec3 getUpVector() const;
 
-    Sample findFloor();
+    Sample findFloor(Profiler& profiler);
+    const Vector<Vec2>& getFloorHull() const;
 
     void drawSamples(QPainter *painter) const;
     void drawSamples() const;
@@ -0,0 +1,214 @@
+#include "Benchmark.h"
+#include "util/StopWatch.h"
+#include "util/Statistics.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QDateTime>
+#include <QFile>
+#include <QRegExp>
+#include <QThread>
+
+// Every kernel is timed in three phases. The warmup calls the kernel for warmupTime
+// seconds to fill the caches and to let the cpu clock up. The calibration doubles the
+// number of iterations until one batch takes at least minTime seconds, so that the
+// resolution of the clock does not matter. Then the batch is repeated and the time per
+// iteration of every repetition goes into the statistics. The median is the figure to
+// compare, because it is robust against the occasional interruption by the system.
+//
+// If a kernel changes its input, a setup function restores the input before every
+// iteration. Then every iteration is timed separately and the setup is not counted,
+// like with PauseTiming() and ResumeTiming() in Google Benchmark.
+
+Benchmark::Benchmark()
+{
+    repetitions = 5;
+    minTime = 0.1;
+    warmupTime = 0.05;
+}
+
+// Sets the number of timed repetitions of every kernel.
+void Benchmark::setRepetitions(int repetitions)
+{
+    this->repetitions = qMax(1, repetitions);
+}
+
+// Sets the minimum duration of one repetition.
+void Benchmark::setMinTime(double seconds)
+{
+    minTime = qMax(0.0, seconds);
+}
+
+// Sets how long every kernel is run before it is timed.
+void Benchmark::setWarmupTime(double seconds)
+{
+    warmupTime = qMax(0.0, seconds);
+}
+
+// Only benchmarks whose name matches the regular expression are run.
+void Benchmark::setFilter(QString regexp)
+{
+    filter = regexp;
+}
+
+// Loads the results of an earlier run, so that the results of this run can be
+// compared with them.
+bool Benchmark::loadBaseline(QString fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly))
+        return false;
+
+    baselines = QJsonObject();
+    QJsonArray benchmarks = QJsonDocument::fromJson(file.readAll()).object().value("benchmarks").toArray();
+    for (int i = 0; i < benchmarks.size(); i++)
+    {
+        QJsonObject b = benchmarks[i].toObject();
+        baselines[b["name"].toString()] = b["median"].toDouble();
+    }
+    return true;
+}
+
+// Benchmarks the kernel body on the given input. items is the number of items,
+// for example points or polygons, that one call of the body processes.
+void Benchmark::run(QString kernel, QString input, double items, Kernel body, Kernel setup)
+{
+    Result result;
+    result.kernel = kernel;
+    result.input = input;
+    result.name = kernel + "/" + input;
+    result.items = items;
+    if (!filter.isEmpty() && QRegExp(filter).indexIn(result.name) < 0)
+        return;
+
+    qint64 counter = 0;
+
+    // Warm up.
+    StopWatch stopWatch;
+    stopWatch.start();
+    do
+    {
+        measure(1, counter, body, setup);
+    }
+    while (stopWatch.elapsedTime() < warmupTime);
+
+    // Calibrate the number of iterations per repetition.
+    qint64 iterations = 1;
+    double t = measure(iterations, counter, body, setup);
+    while (t < minTime && iterations < 1000000000)
+    {
+        qint64 next = t > 0 ? (qint64)(1.4 * iterations * minTime / t) : 100 * iterations;
+        iterations = qBound(2 * iterations, next, 100 * iterations);
+        t = measure(iterations, counter, body, setup);
+    }
+
+    // Time the repetitions.
+    Vector<double> times;
+    for (int r = 0; r < repetitions; r++)
+        times << 1.0e9 * measure(iterations, counter, body, setup) / iterations;
+
+    result.iterations = iterations;
+    result.repetitions = repetitions;
+    Vec2 meanstddev = Statistics::meanstddev(times);
+    result.mean = meanstddev.x;
+    result.stddev = meanstddev.y;
+    result.median = Statistics::percentile(times, 50);
+    result.min = Statistics::min(times);
+    result.itemsPerSecond = result.median > 0 ? 1.0e9 * items / result.median : 0;
+    result.baseline = baselines.value(result.name).toDouble();
+    results << result;
+}
+
+// Runs the body for the given number of iterations and returns the time it took in seconds.
+double Benchmark::measure(qint64 iterations, qint64& counter, Kernel& body, Kernel& setup)
+{
+    StopWatch stopWatch;
+    if (!setup)
+    {
+        stopWatch.start();
+        for (qint64 i = 0; i < iterations; i++)
+            body(counter++);
+        return stopWatch.elapsedTime();
+    }
+
+    double t = 0;
+    for (qint64 i = 0; i < iterations; i++)
+    {
+        setup(counter);
+        stopWatch.start();
+        body(counter++);
+        t += stopWatch.elapsedTime();
+    }
+    return t;
+}
+
+const Vector<Benchmark::Result>& Benchmark::getResults() const
+{
+    return results;
+}
+
+// Prints the results as a human readable table.
+void Benchmark::printTable(QTextStream& out) const
+{
+    out << QString("%1 %2 %3 %4 %5 %6\n")
+           .arg("Benchmark", -48).arg("Median ns", 14).arg("Stddev ns", 12)
+           .arg("Iterations", 11).arg("Items/s", 12).arg("Change", 8);
+    for (int i = 0; i < results.size(); i++)
+    {
+        const Result& r = results[i];
+        QString change = r.baseline > 0 ? QString("%1%").arg(100.0 * (r.median / r.baseline - 1.0), 0, 'f', 1) : QString("-");
+        out << QString("%1 %2 %3 %4 %5 %6\n")
+               .arg(r.name, -48)
+               .arg(r.median, 14, 'f', 0)
+               .arg(r.stddev, 12, 'f', 0)
+               .arg(r.iterations, 11)
+               .arg(r.itemsPerSecond, 12, 'g', 4)
+               .arg(change, 8);
+    }
+    out.flush();
+}
+
+// Returns the results and the context of the run as JSON.
+QJsonObject Benchmark::report() const
+{
+    QJsonObject context;
+    context["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    context["cpus"] = QThread::idealThreadCount();
+    context["repetitions"] = repetitions;
+    context["minTime"] = minTime;
+    context["warmupTime"] = warmupTime;
+#ifdef QT_NO_DEBUG
+    context["build"] = QString("release");
+#else
+    context["build"] = QString("debug");
+#endif
+    context["timeUnit"] = QString("ns");
+
+    QJsonArray benchmarks;
+    for (int i = 0; i < results.size(); i++)
+    {
+        const Result& r = results[i];
+        QJsonObject b;
+        b["name"] = r.name;
+        b["kernel"] = r.kernel;
+        b["input"] = r.input;
+        b["iterations"] = (double)r.iterations;
+        b["repetitions"] = r.repetitions;
+        b["items"] = r.items;
+        b["mean"] = r.mean;
+        b["median"] = r.median;
+        b["stddev"] = r.stddev;
+        b["min"] = r.min;
+        b["itemsPerSecond"] = r.itemsPerSecond;
+        if (r.baseline > 0)
+        {
+            b["baseline"] = r.baseline;
+            b["change"] = r.median / r.baseline - 1.0;
+        }
+        benchmarks.append(b);
+    }
+
+    QJsonObject json;
+    json["context"] = context;
+    json["benchmarks"] = benchmarks;
+    return json;
+}
@@ -0,0 +1,79 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+#include <QString>
+#include <QJsonObject>
+#include <QTextStream>
+#include <functional>
+#include "util/Vector.h"
+
+// A small microbenchmark runner in the style of Google Benchmark. A kernel is
+// warmed up, the number of iterations is calibrated so that one repetition takes
+// at least minTime seconds, and then the kernel is timed for several repetitions.
+// The results are reported as a table and as JSON.
+class Benchmark
+{
+public:
+
+    // The kernel and the setup receive the running iteration counter, so that
+    // they can cycle through a set of inputs.
+    typedef std::function<void(qint64)> Kernel;
+
+    struct Result
+    {
+        QString name; // Kernel name and input, for example "GridModel::dilate/synthetic/32".
+        QString kernel;
+        QString input;
+        qint64 iterations = 0; // Iterations per repetition.
+        int repetitions = 0;
+        double items = 0; // Items processed per iteration.
+        double mean = 0; // Time per iteration in ns.
+        double median = 0;
+        double stddev = 0;
+        double min = 0;
+        double itemsPerSecond = 0;
+        double baseline = 0; // Median of the baseline run, 0 if there is none.
+    };
+
+private:
+
+    Vector<Result> results;
+    QJsonObject baselines;
+    int repetitions;
+    double minTime;
+    double warmupTime;
+    QString filter;
+
+public:
+
+    Benchmark();
+    ~Benchmark(){}
+
+    void setRepetitions(int repetitions);
+    void setMinTime(double seconds);
+    void setWarmupTime(double seconds);
+    void setFilter(QString regexp);
+    bool loadBaseline(QString fileName);
+
+    void run(QString kernel, QString input, double items, Kernel body, Kernel setup = Kernel());
+
+    const Vector<Result>& getResults() const;
+    void printTable(QTextStream& out) const;
+    QJsonObject report() const;
+
+    // Keeps the compiler from optimizing away the computation of value.
+    template <typename T>
+    static void doNotOptimize(const T& value)
+    {
+#if defined(__GNUC__)
+        asm volatile("" : : "g"(&value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+private:
+    static double measure(qint64 iterations, qint64& counter, Kernel& body, Kernel& setup);
+};
+
+#endif // BENCHMARK_H
@@ -0,0 +1,3 @@
+HEADERS += bench/Benchmark.h
+SOURCES += bench/Benchmark.cpp \
+    bench/main.cpp
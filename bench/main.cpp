@@ -0,0 +1,326 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include "Benchmark.h"
+#include "Pipeline.h"
+#include "blackboard/Config.h"
+#include "recording/Recording.h"
+#include "recording/SyntheticScene.h"
+#include "learner/OLS.h"
+#include "util/Statistics.h"
+#include "globals.h"
+
+// Microbenchmarks of the hot kernels of the pipeline. Every kernel runs in isolation
+// on inputs that were prepared by running the whole pipeline once per frame: the
+// frames of a recording and synthetic scenes with an increasing number of obstacles.
+//
+// polyperception-bench --output bench.json
+// polyperception-bench --filter "GridModel" --sizes 8,64,256 --compare bench.json
+
+// The frames of an input and the intermediate results of the pipeline for every frame.
+struct Input
+{
+    QString name;
+    Vector< Vector<Vec3> > points;
+    Vector<Sample> floors;
+    Vector<Transform3D> transforms;
+    Vector<GridModel> binnedGrids; // The occupancy grids after the binning.
+    Vector<GridModel> grids; // The occupancy grids after the dilation, ready for the extraction.
+    Vector< Vector<Polygon> > polygons;
+    Vector< Vector<Vec3> > floorPoints; // Points close to the floor plane in camera coordinates.
+    Vector< Vector<Vec2u> > sightLines; // Pairs of grid cells for the line of sight queries.
+    Vector< Vector<Vec2> > queryPoints; // Points for the distance queries.
+};
+
+// Runs the pipeline over the frames of the input and keeps the intermediate results.
+static void prepare(Input& input)
+{
+    SampleGrid sampleGrid;
+    sampleGrid.init(config);
+    GridModel gridModel;
+    gridModel.init(config);
+    Vector<Polygon> polygons;
+    PolygonSet polygonSet;
+    Sample floor;
+    Transform3D cameraTransform;
+    Profiler profiler; // Not reported, the benchmark times the kernels itself.
+
+    Statistics::setSeed(1);
+    for (int f = 0; f < input.points.size(); f++)
+    {
+        const Vec3* points = &input.points[f][0];
+        Pipeline::process(config, points, sampleGrid, gridModel, floor, cameraTransform, polygonSet, profiler);
+        polygonSet.toPolygons(polygons);
+
+        input.floors << floor;
+        input.transforms << cameraTransform;
+        input.grids << gridModel;
+        input.polygons << polygons;
+        Pipeline::binPoints(config, points, cameraTransform, gridModel);
+        input.binnedGrids << gridModel;
+
+        Vector<Vec3> nearFloor;
+        for (int i = 0; i < NUMBER_OF_POINTS && nearFloor.size() < 2048; i += 7)
+            if (!points[i].isNull() && fabs(floor.distance(points[i])) < 0.02)
+                nearFloor << points[i];
+        input.floorPoints << nearFloor;
+
+        Vector<Vec2u> cells;
+        for (int i = 0; i < 2*1024; i++)
+            cells << Vec2u(Statistics::randomInt(0, gridModel.getWidth()-1), Statistics::randomInt(0, gridModel.getHeight()-1));
+        input.sightLines << cells;
+
+        Vector<Vec2> queries;
+        for (int i = 0; i < 256; i++)
+            queries << Vec2(Statistics::uniformSample(0, config.gridX), Statistics::uniformSample(-config.gridY, config.gridY));
+        input.queryPoints << queries;
+    }
+}
+
+// Reads up to frames frames from a recording.
+static bool loadRecording(Input& input, QString fileName, int frames)
+{
+    Recording recording;
+    if (!recording.open(fileName) || recording.numPoints() != NUMBER_OF_POINTS)
+        return false;
+
+    Vector<Pixel> colors(NUMBER_OF_POINTS);
+    for (int f = 0; f < qMin(frames, recording.numFrames()); f++)
+    {
+        Vector<Vec3> points(NUMBER_OF_POINTS);
+        recording.readFrame(f, &points[0], &colors[0]);
+        input.points << points;
+    }
+    input.name = "recording";
+    return !input.points.isEmpty();
+}
+
+// Generates frames of a synthetic scene with the given number of obstacles.
+static void generateScene(Input& input, int obstacles, int frames)
+{
+    SyntheticScene scene(obstacles);
+    for (int f = 0; f < frames; f++)
+    {
+        Vector<Vec3> points(NUMBER_OF_POINTS);
+        scene.generate(f, &points[0]);
+        input.points << points;
+    }
+    input.name = "synthetic/" + QString::number(obstacles);
+}
+
+// Average number of polygons and of polygon pairs per frame of the input.
+static double polygonsPerFrame(const Input& input, bool pairs)
+{
+    double n = 0;
+    for (int f = 0; f < input.polygons.size(); f++)
+    {
+        int k = input.polygons[f].size();
+        n += pairs ? k*(k-1)/2 : k;
+    }
+    return n / qMax(1, input.polygons.size());
+}
+
+// Registers all kernels on one input.
+static void runKernels(Benchmark& benchmark, Input& input)
+{
+    const int frames = input.points.size();
+    SampleGrid sampleGrid;
+    sampleGrid.init(config);
+    GridModel gridModel;
+    gridModel.init(config);
+    PolygonSet polygonSet;
+    OLS ols;
+    Profiler profiler; // Not reported, the benchmark times the kernels itself.
+
+    benchmark.run("Transform3D::operator*", input.name, NUMBER_OF_POINTS, [&](qint64 i) {
+        const Vector<Vec3>& points = input.points[i % frames];
+        const Transform3D& t = input.transforms[i % frames];
+        Vec3 sum;
+        for (int k = 0; k < NUMBER_OF_POINTS; k++)
+            sum += t * points[k];
+        Benchmark::doNotOptimize(sum);
+    });
+
+    benchmark.run("Pipeline::binPoints", input.name, NUMBER_OF_POINTS, [&](qint64 i) {
+        Pipeline::binPoints(config, &input.points[i % frames][0], input.transforms[i % frames], gridModel);
+        Benchmark::doNotOptimize(gridModel);
+    });
+
+    benchmark.run("SampleGrid::update", input.name, 1, [&](qint64 i) {
+        sampleGrid.update(&input.points[i % frames][0]);
+        Benchmark::doNotOptimize(sampleGrid);
+    });
+
+    // findFloor() consumes the samples, so they are refreshed before every iteration.
+    benchmark.run("SampleGrid::findFloor", input.name, 1, [&](qint64 i) {
+        Sample floor = sampleGrid.findFloor(profiler);
+        Benchmark::doNotOptimize(floor);
+    }, [&](qint64 i) {
+        sampleGrid.update(&input.points[i % frames][0]);
+    });
+
+    // The fit needs at least three points in every frame.
+    int fitPoints = NUMBER_OF_POINTS;
+    double meanFitPoints = 0;
+    for (int f = 0; f < frames; f++)
+    {
+        fitPoints = qMin(fitPoints, input.floorPoints[f].size());
+        meanFitPoints += (double)input.floorPoints[f].size() / frames;
+    }
+    if (fitPoints >= 3)
+    {
+        benchmark.run("OLS::init", input.name, meanFitPoints, [&](qint64 i) {
+            ols.init();
+            Benchmark::doNotOptimize(ols);
+        }, [&](qint64 i) {
+            const Vector<Vec3>& points = input.floorPoints[i % frames];
+            ols.reset();
+            for (int k = 0; k < points.size(); k++)
+                ols.addDataPoint(points[k]);
+        });
+    }
+
+    // The dilation works in place, so the binned grid is restored before every iteration.
+    benchmark.run("GridModel::dilate", input.name, gridModel.getWidth()*gridModel.getHeight(), [&](qint64 i) {
+        gridModel.dilate(config.dilationRadius);
+        Benchmark::doNotOptimize(gridModel);
+    }, [&](qint64 i) {
+        gridModel = input.binnedGrids[i % frames];
+    });
+
+    benchmark.run("GridModel::extractPolygons", input.name, polygonsPerFrame(input, false), [&](qint64 i) {
+        input.grids[i % frames].extractPolygons(polygonSet, profiler);
+        Benchmark::doNotOptimize(polygonSet);
+    });
+
+    benchmark.run("GridModel::hasLineOfSight", input.name, 1024, [&](qint64 i) {
+        const GridModel& grid = input.grids[i % frames];
+        const Vector<Vec2u>& cells = input.sightLines[i % frames];
+        int visible = 0;
+        for (int k = 0; k < cells.size(); k += 2)
+            visible += grid.hasLineOfSight(cells[k], cells[k+1]);
+        Benchmark::doNotOptimize(visible);
+    });
+
+    if (polygonsPerFrame(input, false) < 1)
+        return;
+
+    benchmark.run("Polygon::intersects", input.name, polygonsPerFrame(input, true), [&](qint64 i) {
+        const Vector<Polygon>& pols = input.polygons[i % frames];
+        int intersections = 0;
+        for (int a = 0; a < pols.size(); a++)
+            for (int b = a+1; b < pols.size(); b++)
+                intersections += pols[a].intersects(pols[b]);
+        Benchmark::doNotOptimize(intersections);
+    });
+
+    benchmark.run("Polygon::distance", input.name, 256*polygonsPerFrame(input, false), [&](qint64 i) {
+        const Vector<Polygon>& pols = input.polygons[i % frames];
+        const Vector<Vec2>& queries = input.queryPoints[i % frames];
+        double sum = 0;
+        for (int a = 0; a < pols.size(); a++)
+            for (int k = 0; k < queries.size(); k++)
+                sum += pols[a].distance(queries[k]);
+        Benchmark::doNotOptimize(sum);
+    });
+
+    benchmark.run("Polygon::convexHull", input.name, polygonsPerFrame(input, false), [&](qint64 i) {
+        const Vector<Polygon>& pols = input.polygons[i % frames];
+        int vertices = 0;
+        for (int a = 0; a < pols.size(); a++)
+            vertices += pols[a].convexHull().size();
+        Benchmark::doNotOptimize(vertices);
+    });
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("polyperception-bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks the kernels of the polygonal perception pipeline and reports the results as JSON.");
+    parser.addHelpOption();
+    QCommandLineOption recordingOption("recording", "Use the frames of the recording <file>. data/statehistory.dat is converted if needed.", "file", "data/statehistory.rec");
+    QCommandLineOption framesOption("frames", "Use <n> frames per input.", "n", "16");
+    QCommandLineOption sizesOption("sizes", "Comma separated numbers of obstacles of the synthetic scenes.", "list", "8,32,128");
+    QCommandLineOption repetitionsOption("repetitions", "Time every kernel <n> times.", "n", "5");
+    QCommandLineOption minTimeOption("min-time", "Minimum duration of a repetition in seconds.", "seconds", "0.1");
+    QCommandLineOption warmupOption("warmup", "Run every kernel for <seconds> before timing it.", "seconds", "0.05");
+    QCommandLineOption filterOption("filter", "Only run the benchmarks whose name matches <regexp>.", "regexp");
+    QCommandLineOption compareOption("compare", "Compare the results with an earlier report <file>.", "file");
+    QCommandLineOption configOption("config", "Load the config from conf/<name>.conf.", "name", "config");
+    QCommandLineOption outputOption("output", "Write the report to <file> instead of stdout.", "file");
+    parser.addOption(recordingOption);
+    parser.addOption(framesOption);
+    parser.addOption(sizesOption);
+    parser.addOption(repetitionsOption);
+    parser.addOption(minTimeOption);
+    parser.addOption(warmupOption);
+    parser.addOption(filterOption);
+    parser.addOption(compareOption);
+    parser.addOption(configOption);
+    parser.addOption(outputOption);
+    parser.process(a);
+
+    config.init();
+    config.load(parser.value(configOption));
+
+    Benchmark benchmark;
+    benchmark.setRepetitions(parser.value(repetitionsOption).toInt());
+    benchmark.setMinTime(parser.value(minTimeOption).toDouble());
+    benchmark.setWarmupTime(parser.value(warmupOption).toDouble());
+    benchmark.setFilter(parser.value(filterOption));
+    if (parser.isSet(compareOption) && !benchmark.loadBaseline(parser.value(compareOption)))
+        QTextStream(stderr) << "Could not read the baseline " << parser.value(compareOption) << endl;
+
+    int frames = qMax(1, parser.value(framesOption).toInt());
+    QString recordingFile = parser.value(recordingOption);
+    if (!QFile::exists(recordingFile) && recordingFile == "data/statehistory.rec" && QFile::exists("data/statehistory.dat"))
+        Recording::convert("data/statehistory.dat", recordingFile);
+
+    Input recorded;
+    if (loadRecording(recorded, recordingFile, frames))
+    {
+        prepare(recorded);
+        runKernels(benchmark, recorded);
+    }
+    else
+    {
+        QTextStream(stderr) << "Could not open the recording " << recordingFile << ", using synthetic scenes only" << endl;
+    }
+
+    QStringList sizes = parser.value(sizesOption).split(",", QString::SkipEmptyParts);
+    for (int s = 0; s < sizes.size(); s++)
+    {
+        Input synthetic;
+        generateScene(synthetic, sizes[s].toInt(), frames);
+        prepare(synthetic);
+        runKernels(benchmark, synthetic);
+    }
+
+    QTextStream err(stderr);
+    benchmark.printTable(err);
+
+    QByteArray json = QJsonDocument(benchmark.report()).toJson(QJsonDocument::Indented);
+    if (parser.isSet(outputOption))
+    {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QFile::WriteOnly))
+        {
+            QTextStream(stderr) << "Could not write " << file.fileName() << endl;
+            return 1;
+        }
+        file.write(json);
+        file.close();
+    }
+    else
+    {
+        QTextStream(stdout) << json;
+    }
+
+    return 0;
+}
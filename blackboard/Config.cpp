@@ -38,6 +38,7 @@ Config::Config()
     gridX = 5.0;
     gridY = 2.5;
     douglasPeuckerEpsilon = 0.7;
+    topologyPreserving = 1;
     dilationRadius = 0.3;
     floor = 0.05;
     ceiling = 0.5;
@@ -50,6 +51,30 @@ Config::Config()
     floodThreshold = 0.01;
     mergeThreshold = 0.1;
 
+    mapResolution = 0.05;
+    mapRetireTime = 2.0;
+    mapMaxPolygons = 500;
+    mapDouglasPeuckerEpsilon = 0.05;
+
+    maxExtrapolationTime = 0.2;
+
+    stabilizationTolerance = 0.1;
+    stabilizationAppear = 2;
+    stabilizationDisappear = 3;
+
+    registrationIterations = 20;
+    registrationMaxDistance = 0.3;
+    registrationSampleStep = 0.1;
+
+    recordingCompression = 0;
+    recordingColor = 1;
+    recordingQueueSize = 8;
+    recordingBlockWhenFull = 0;
+    recordingGrid = 0;
+    playbackCacheSize = 16;
+    playbackPrefetch = 4;
+    telemetrySize = 72000;
+
     floorDz = 0;
     heightmapDz = 0;
     polygonsDz = 0;
@@ -70,6 +95,7 @@ void Config::init()
     registerMember("heightmap.gridX", &gridX, 10);
     registerMember("heightmap.gridY", &gridY, 10);
     registerMember("heightmap.epsilonDouglasPeucker", &douglasPeuckerEpsilon, 2.0);
+    registerMember("heightmap.topologyPreserving", &topologyPreserving, 1.0);
     registerMember("heightmap.dilationRadius", &dilationRadius, 1.0);
     registerMember("heightmap.floor", &floor, 0.1);
     registerMember("heightmap.ceiling", &ceiling, 2.00);
@@ -82,6 +108,30 @@ void Config::init()
     registerMember("floordetection.greedThreshold", &floodThreshold, 0.1);
     registerMember("floordetection.mergeThreshold", &mergeThreshold, 0.2);
 
+    registerMember("map.resolution", &mapResolution, 0.2);
+    registerMember("map.retireTime", &mapRetireTime, 10.0);
+    registerMember("map.maxPolygons", &mapMaxPolygons, 2000.0);
+    registerMember("map.epsilonDouglasPeucker", &mapDouglasPeuckerEpsilon, 0.5);
+
+    registerMember("odometry.maxExtrapolationTime", &maxExtrapolationTime, 1.0);
+
+    registerMember("stabilization.tolerance", &stabilizationTolerance, 0.5);
+    registerMember("stabilization.appear", &stabilizationAppear, 10.0);
+    registerMember("stabilization.disappear", &stabilizationDisappear, 10.0);
+
+    registerMember("registration.iterations", &registrationIterations, 100.0);
+    registerMember("registration.maxDistance", &registrationMaxDistance, 1.0);
+    registerMember("registration.sampleStep", &registrationSampleStep, 0.5);
+
+    registerMember("recording.compression", &recordingCompression, 1.0);
+    registerMember("recording.color", &recordingColor, 1.0);
+    registerMember("recording.queueSize", &recordingQueueSize, 64.0);
+    registerMember("recording.blockWhenFull", &recordingBlockWhenFull, 1.0);
+    registerMember("recording.grid", &recordingGrid, 1.0);
+    registerMember("playback.cacheSize", &playbackCacheSize, 100.0);
+    registerMember("playback.prefetch", &playbackPrefetch, 20.0);
+    registerMember("telemetry.size", &telemetrySize, 200000.0);
+
     registerMember("gui.floor", &floorDz, 0.2);
     registerMember("gui.heightmap_dz", &heightmapDz, 0.2);
     registerMember("gui.polygons_dz", &polygonsDz, 0.2);
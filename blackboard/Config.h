@@ -20,6 +20,7 @@ struct Config
     double gridY;
     double minimumSegmentSize;
     double douglasPeuckerEpsilon;
+    double topologyPreserving;
     double dilationRadius;
     double levelCount;
 
@@ -29,6 +30,30 @@ struct Config
     double floodThreshold;
     double mergeThreshold;
 
+    double mapResolution;
+    double mapRetireTime;
+    double mapMaxPolygons;
+    double mapDouglasPeuckerEpsilon;
+
+    double maxExtrapolationTime;
+
+    double stabilizationTolerance;
+    double stabilizationAppear;
+    double stabilizationDisappear;
+
+    double registrationIterations;
+    double registrationMaxDistance;
+    double registrationSampleStep;
+
+    double recordingCompression;
+    double recordingColor;
+    double recordingQueueSize;
+    double recordingBlockWhenFull;
+    double recordingGrid;
+    double playbackCacheSize;
+    double playbackPrefetch;
+    double telemetrySize;
+
     double floorDz;
     double heightmapDz;
     double polygonsDz;
@@ -0,0 +1,61 @@
+#include "Snapshot.h"
+#include "State.h"
+
+// The gui used to lock the state during the whole render, and the robot control loop
+// locked it during the whole step. A slow repaint delayed the control step and a long
+// step froze the gui. Now the control loop publishes the outputs of every step into the
+// SnapshotBuffer, and the gui draws the latest published snapshot. The snapshot copies
+// the grid, the samples and the polygons, which is about as much work as buffering the
+// state into the history. The point cloud buffers are shared copy-on-write and are not
+// copied at all.
+//
+// The epoch counts the publications. A consumer that remembers the epoch it has shown
+// can skip a frame when the epoch did not change.
+
+SnapshotBuffer snapshots;
+
+SnapshotBuffer::SnapshotBuffer()
+{
+    back = 0;
+    middle = 1;
+    front = 2;
+    published = 0;
+}
+
+// Copies the outputs of the state into the back slot and publishes them.
+// Must only be called from one thread at a time.
+void SnapshotBuffer::publish(const State& s)
+{
+    Snapshot& snapshot = slot[back];
+    snapshot.epoch = published.load(std::memory_order_relaxed) + 1;
+    snapshot.frameId = s.frameId;
+    snapshot.historySize = s.size();
+    snapshot.time = s.time;
+    snapshot.numPolygons = s.numPolygons;
+    snapshot.numVertices = s.numVertices;
+    snapshot.gridModel = s.gridModel;
+    snapshot.sampleGrid = s.sampleGrid;
+    snapshot.cameraTransform = s.cameraTransform;
+    snapshot.polygonSet = s.polygonSet;
+    snapshot.floor = s.floor;
+    snapshot.pointBuffer = s.pointBuffer;
+    snapshot.colorBuffer = s.colorBuffer;
+
+    back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+    published.store(snapshot.epoch, std::memory_order_release);
+}
+
+// Returns the most recently published snapshot. The snapshot stays valid and unchanged
+// until the next call of acquire(). Must only be called from one thread.
+const Snapshot& SnapshotBuffer::acquire()
+{
+    if (middle.load(std::memory_order_relaxed) & FRESH)
+        front = middle.exchange(front, std::memory_order_acq_rel) & ~FRESH;
+    return slot[front];
+}
+
+// Returns the number of published snapshots.
+quint64 SnapshotBuffer::epoch() const
+{
+    return published.load(std::memory_order_acquire);
+}
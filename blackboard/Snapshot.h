@@ -0,0 +1,60 @@
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <atomic>
+#include "util/Transform3D.h"
+#include "util/SharedBuffer.h"
+#include "util/ColorUtil.h"
+#include "GridModel.h"
+#include "SampleGrid.h"
+#include "geometry/PolygonSet.h"
+
+struct State;
+
+// The outputs of one pipeline step as they are shown by the gui.
+struct Snapshot
+{
+    quint64 epoch = 0; // Number of the publication. 0 means nothing was published yet.
+    int frameId = 0;
+    int historySize = 0;
+    double time = 0;
+    double numPolygons = 0;
+    double numVertices = 0;
+
+    GridModel gridModel;
+    SampleGrid sampleGrid;
+    Transform3D cameraTransform;
+    PolygonSet polygonSet;
+    Sample floor;
+    SharedBuffer<Vec3> pointBuffer;
+    SharedBuffer<Pixel> colorBuffer;
+};
+
+// Hands the outputs of the pipeline from the robot control thread to the gui thread
+// without a lock. There are three snapshot slots. The writer fills its back slot and
+// atomically exchanges it with the middle slot, and the reader exchanges its front slot
+// with the middle slot when a newer snapshot was published there. Neither side ever
+// waits for the other. There must be only one writing and one reading thread at a time.
+class SnapshotBuffer
+{
+    enum {FRESH = 4}; // Flag of the middle index that marks an unread snapshot.
+
+    Snapshot slot[3];
+    int back; // Owned by the writer.
+    int front; // Owned by the reader.
+    std::atomic<int> middle; // Index of the exchanged slot and the FRESH flag.
+    std::atomic<quint64> published;
+
+public:
+
+    SnapshotBuffer();
+    ~SnapshotBuffer(){}
+
+    void publish(const State& s);
+    const Snapshot& acquire();
+    quint64 epoch() const;
+};
+
+extern SnapshotBuffer snapshots;
+
+#endif /* SNAPSHOT_H_ */
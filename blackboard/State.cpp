@@ -6,6 +6,7 @@
 #include "globals.h"
 #include "util/ColorUtil.h"
 #include "blackboard/Config.h"
+#include "blackboard/Telemetry.h"
 
 /*
  * The State is a globally accessible, bufferable object with built in introspection
@@ -37,7 +38,11 @@
  * state[1].supportLegSign, which would tell you which leg the robot was standing on one
  * buffered state before the current one. The few private members the state object needs
  * for keeping the history and to implement the introspection features are static so that
- * they don't get copied when the state is buffered into history.
+ * they don't get copied when the state is buffered into history. The history is a ring of
+ * preallocated state slots. Buffering copies the state member-wise into the oldest slot, which
+ * reuses the memory the slot already holds. The large point and color buffers are shared
+ * copy-on-write between the state, the history and the frame source, so that buffering a
+ * state does not copy the point cloud.
  *
  * The state object has introspection capabilities. For a generic way of accessing state variables,
  * e.g. listing all state members in a for loop at runtime, a list of the state members needs to be
@@ -49,7 +54,9 @@
  * selector check boxes in the bottom left, and the state member graphs on the bottom right, without
  * having to change the GUI code each time the state object changes. The introspection interface and
  * the state history can be combined. For example, state[11]("fusedAngle.x") gives you the lateral
- * fused angle 11 cycles ago.
+ * fused angle 11 cycles ago. Each buffered state is also appended to the telemetry, which keeps
+ * the registered members in columns over a much longer time than the state history. The graphs
+ * read from the telemetry.
  */
 
 
@@ -57,9 +64,13 @@
 // These members are static so that buffering into history does not create copies.
 QMutex State::mutex;
 QStringList State::memberNames;
-QList<quint64> State::memberOffsets;
-QList<QString> State::memberTypes;
-QList<State> State::history;
+Vector<State::Member> State::members;
+QHash<QString, int> State::memberIds;
+Vector<State> State::history;
+int State::historyHead = -1;
+int State::historyCount = 0;
+AsyncRecorder State::recorder;
+QMutex State::recorderMutex;
 QMutex State::gMutex;
 
 // Ugly hack that makes sure ColorUtil is constructed before State.
@@ -78,9 +89,26 @@ State::State()
     rcIterationTime = 0;
     rcExecutionTime = 0;
     avgExecutionTime = 0;
+    captureTime = 0;
+    publishTime = 0;
+    latency = 0;
+    for (int s = 0; s < Profiler::NUMBER_OF_STAGES; s++)
+    {
+        stageP50[s] = 0;
+        stageP99[s] = 0;
+        stageMax[s] = 0;
+    }
 
     numPolygons = 0;
     numVertices = 0;
+    numMapPolygons = 0;
+    numChangedPolygons = 0;
+    registrationError = 0;
+    registrationInliers = 0;
+    recorderQueued = 0;
+    recorderDropped = 0;
+    recorderBlocked = 0;
+    recorderWritten = 0;
 }
 
 // The init() method should be called after construction of the state object.
@@ -90,6 +118,9 @@ State::State()
 // need to register it.
 void State::init()
 {
+    pointBuffer.resize(NUMBER_OF_POINTS);
+    colorBuffer.resize(NUMBER_OF_POINTS);
+
     registerMember("frameId", &frameId);
     registerMember("time", &time);
     registerMember("debug", &debug);
@@ -97,136 +128,240 @@ void State::init()
     registerMember("timing.rcIterationTime", &rcIterationTime);
     registerMember("timing.rcExecutionTime", &rcExecutionTime);
     registerMember("timing.avgExecutionTime", &avgExecutionTime);
+    registerMember("timing.latency", &latency);
+    for (int s = 0; s < Profiler::NUMBER_OF_STAGES; s++)
+    {
+        registerMember("timing." + Profiler::stageName(s) + ".p50", &stageP50[s]);
+        registerMember("timing." + Profiler::stageName(s) + ".p99", &stageP99[s]);
+        registerMember("timing." + Profiler::stageName(s) + ".max", &stageMax[s]);
+    }
 
     registerMember("polygons", &numPolygons);
     registerMember("vertices", &numVertices);
+    registerMember("changedPolygons", &numChangedPolygons);
+    registerMember("map.polygons", &numMapPolygons);
+
+    registerMember("registration.dx", &registrationDelta.x);
+    registerMember("registration.dy", &registrationDelta.y);
+    registerMember("registration.dtheta", &registrationDelta.z);
+    registerMember("registration.error", &registrationError);
+    registerMember("registration.inliers", &registrationInliers);
+
+    registerMember("recorder.queued", &recorderQueued);
+    registerMember("recorder.dropped", &recorderDropped);
+    registerMember("recorder.blocked", &recorderBlocked);
+    registerMember("recorder.written", &recorderWritten);
 }
 
 // Clears the state history.
 void State::clear()
 {
 	QMutexLocker locker(&mutex);
-	history.clear();
+    historyHead = -1;
+    historyCount = 0;
     frameId = 0;
     time = 0;
+    telemetry.clear();
+    profiler.reset();
 }
 
-// Saves the entire state history to a file.
+// Saves the entire state history to a recording file. The recording is written
+// to a temporary file that replaces the old recording only once it is complete,
+// so that a reader that has the old recording mapped keeps seeing intact data.
 void State::saveHistory() const
 {
 	QMutexLocker locker(&mutex);
 
-    QFile file("data/statehistory.dat");
-	file.open(QIODevice::WriteOnly);
-	QDataStream out(&file);
-    for (int i = history.size()-1; i >= 0; i--)
-    {
-        out << history[i].frameId;
-        out << history[i].time;
-        for (int j = 0; j < NUMBER_OF_POINTS; j++)
-        {
-            out << history[i].pointBuffer[j];
-            out << history[i].colorBuffer[j].r;
-            out << history[i].colorBuffer[j].g;
-            out << history[i].colorBuffer[j].b;
-        }
-    }
-	file.close();
-}
-
-// Loads the data file into the state history.
-void State::loadHistory(int maxLength)
-{
-    QMutexLocker locker(&mutex);
-
-    QFile file("data/statehistory.dat");
-    file.open(QIODevice::ReadOnly);
-    QDataStream in(&file);
-
-    //clear(); // can't call directly because mutex
-    history.clear();
-
-    int loadedFrames = 0;
-    while(!in.atEnd() && loadedFrames < maxLength)
-    {
-        in >> frameId;
-        in >> time;
-        for (int i = 0; i < NUMBER_OF_POINTS; i++)
-        {
-            in >> pointBuffer[i];
-            in >> colorBuffer[i].r;
-            in >> colorBuffer[i].g;
-            in >> colorBuffer[i].b;
-        }
-
-        //bufferAppend(maxLength); // can't call directly because mutex
-        history.push_front(*this);
-        loadedFrames++;
-    }
-    file.close();
-
-    // Rewrite the frame numbers and times.
-    for (int i = 0; i < history.size(); i++)
+    QString fileName = "data/statehistory.rec";
+    QString tmpFileName = fileName + ".tmp";
+    RecordingWriter writer;
+    if (!writer.open(tmpFileName, NUMBER_OF_POINTS))
+        return;
+    writer.setCompression(config.recordingCompression > 0, config.recordingColor > 0);
+    for (int i = historyCount-1; i >= 0; i--)
     {
-        history[i].frameId = history.size()-i;
-        history[i].time = history[i].frameId*config.rcIterationTime;
+        const State& s = historyAt(i);
+        RecordingChannels channels;
+        s.recordChannels(channels);
+        channels.compress(RecordingChannel::GRID, sizeof(RecordingGrid));
+        writer.appendFrame(s.frameId, s.time, s.pointBuffer.constData(), s.colorBuffer.constData(), &channels, false);
     }
+    writer.close();
 
-    restore(0);
+    QFile::remove(fileName);
+    if (!QFile::rename(tmpFileName, fileName))
+        qDebug() << "State::saveHistory(): could not replace" << fileName;
 }
 
 // Restores the state with the frameIndex from history into the current state.
+// The point and color buffers are shared with the history rather than copied.
 void State::restore(int frameIndex)
 {
-    frameId = history[frameIndex].frameId;
-    time = history[frameIndex].time;
-    for (int i = 0; i < NUMBER_OF_POINTS; i++)
-    {
-        pointBuffer[i] = history[frameIndex].pointBuffer[i];
-        colorBuffer[i] = history[frameIndex].colorBuffer[i];
-    }
+    if (frameIndex < 0 || frameIndex >= historyCount)
+        return;
+
+    const State& s = historyAt(frameIndex);
+    frameId = s.frameId;
+    time = s.time;
+    pointBuffer = s.pointBuffer;
+    colorBuffer = s.colorBuffer;
 }
 
 // Appends the current state to the state history.
+// The state is copied into the slot of the oldest state, which reuses the memory of the slot.
+// With maxLength = 0 the history grows without bounds.
 void State::bufferAppend(int maxLength)
 {
     QMutexLocker locker(&mutex);
-    history.push_front(*this);
-    while (maxLength > 0 && history.size() > maxLength)
-        history.pop_back();
+
+    if (maxLength > 0 && history.size() != maxLength)
+        setHistoryCapacity(maxLength);
+    else if (maxLength <= 0 && historyCount == history.size())
+        setHistoryCapacity(qMax(2*history.size(), 64));
+
+    historyHead = (historyHead+1) % history.size();
+    history[historyHead].copyBuffered(*this);
+    historyCount = qMin(historyCount+1, history.size());
+
+    // The telemetry is at least as long as the history, so that their indices match.
+    telemetry.append(*this, qMax((int)config.telemetrySize, history.size()));
 }
 
 // Overwrites a state in the history with the current state.
 void State::bufferOverwrite(int frameIndex)
 {
-    history[frameIndex] = *this;
+    historyAt(frameIndex).copyBuffered(*this);
+    telemetry.overwrite(frameIndex, *this);
 }
 
+// Copies the members that are kept in the state history from s: the registered
+// members, the point cloud, and the outputs that saveHistory() records. The grids,
+// the polygon vectors, and everything else are recomputed when a frame is restored,
+// so they are not copied.
+void State::copyBuffered(const State& s)
+{
+    for (int i = 0; i < members.size(); i++)
+        members[i].set((char*)this + members[i].offset, members[i].get((const char*)&s + members[i].offset));
+
+    captureTime = s.captureTime;
+    publishTime = s.publishTime;
+    floor = s.floor;
+    cameraTransform = s.cameraTransform;
+    polygonSet = s.polygonSet;
+    pointBuffer = s.pointBuffer;
+    colorBuffer = s.colorBuffer;
+    if (config.recordingGrid > 0)
+        gridModel = s.gridModel;
+}
+
+// Returns the ith most recent state in the history. i = 0 is the most recent one.
+State& State::historyAt(int i)
+{
+    int k = historyHead - i;
+    if (k < 0)
+        k += history.size();
+    return history[k];
+}
+
+// Reallocates the ring of history slots with the given capacity.
+// The most recent states are kept. This is expensive, but happens only when
+// the capacity changes.
+void State::setHistoryCapacity(int capacity)
+{
+    if (capacity < 1)
+        capacity = 1;
+    if (capacity == history.size())
+        return;
+
+    int count = qMin(historyCount, capacity);
+    Vector<State> ring(capacity);
+    for (int i = 0; i < count; i++)
+        ring[count-1-i] = historyAt(i);
+
+    history = ring;
+    historyHead = count-1;
+    historyCount = count;
+}
+
+// Hands the current point cloud to the background recorder, which appends it to the
+// recording file. Only references to the shared buffers are queued, so this is cheap
+// enough to be called from the control loop.
 void State::bufferToFile()
 {
-    QMutexLocker locker(&mutex);
+    QMutexLocker locker(&recorderMutex);
+
+    if (!recorder.isOpen()
+            && !recorder.open("data/statehistory.rec", NUMBER_OF_POINTS, config.recordingQueueSize,
+                              config.recordingBlockWhenFull > 0 ? AsyncRecorder::Block : AsyncRecorder::DropNewest,
+                              config.recordingCompression > 0, config.recordingColor > 0))
+        return;
+
+    static RecordingChannels channels;
+    recordChannels(channels);
+    recorder.enqueue(frameId, time, pointBuffer, colorBuffer, &channels);
+    recorderQueued = recorder.queued();
+    recorderDropped = recorder.dropped();
+    recorderBlocked = recorder.blocked();
+    recorderWritten = recorder.written();
+}
 
-    QFile file("data/statehistory.dat");
-    file.open(QFile::Append);
-    QDataStream out(&file);
-    out << frameId;
-    out << time;
-    for (int j = 0; j < NUMBER_OF_POINTS; j++)
+// Collects the outputs of the pipeline that are recorded along with the point cloud.
+// The grid snapshot is only included if recording.grid is set. Its cells are added
+// uncompressed, since this runs in the control step, and have to be compressed with
+// RecordingChannels::compress() before the channels are written.
+void State::recordChannels(RecordingChannels& channels) const
+{
+    channels.clear();
+
+    RecordingFloor f;
+    for (int d = 0; d < 3; d++)
     {
-        out << pointBuffer[j];
-        out << colorBuffer[j].r;
-        out << colorBuffer[j].g;
-        out << colorBuffer[j].b;
+        f.p[d] = floor.p[d];
+        f.n[d] = floor.n[d];
     }
+    channels.add(RecordingChannel::FLOOR, &f, sizeof(f));
+
+    channels.add(RecordingChannel::CAMERA_TRANSFORM, cameraTransform.data(), 16*sizeof(double));
+
+    int bytes = polygonSet.byteSize();
+    polygonSet.serialize(channels.add(RecordingChannel::POLYGONS, bytes), bytes);
 
-    file.close();
+    RecordingTimings t;
+    t.executionTime = rcExecutionTime;
+    t.captureTime = captureTime;
+    t.publishTime = publishTime;
+    t.latency = latency;
+    channels.add(RecordingChannel::TIMINGS, &t, sizeof(t));
+
+    if (config.recordingGrid > 0 && gridModel.data() != 0)
+    {
+        RecordingGrid g;
+        g.width = gridModel.getWidth();
+        g.height = gridModel.getHeight();
+        for (int d = 0; d < 2; d++)
+        {
+            g.min[d] = gridModel.getMin()[d];
+            g.max[d] = gridModel.getMax()[d];
+        }
+        int cells = g.width*g.height;
+        char* p = (char*)channels.add(RecordingChannel::GRID, sizeof(g) + cells);
+        memcpy(p, &g, sizeof(g));
+        memcpy(p + sizeof(g), gridModel.data(), cells);
+    }
+}
+
+// Writes the frames still queued in the background recorder and closes the recording file.
+void State::closeFile()
+{
+    QMutexLocker locker(&recorderMutex);
+    recorder.close();
 }
 
 // Returns the amount of buffered historical state objects.
 int State::size() const
 {
 	QMutexLocker locker(&mutex);
-	return history.size();
+	return historyCount;
 }
 
 // Returns a historical state object.
@@ -239,11 +374,11 @@ State& State::operator[](int i)
 {
 	QMutexLocker locker(&mutex);
 
-    if (i == 0 || history.empty())
+    if (i == 0 || historyCount == 0)
 		return *this;
 
-    i = qMin(qAbs(i), history.size()) - 1;
-	return history[i];
+    i = qMin(qAbs(i), historyCount) - 1;
+	return historyAt(i);
 }
 
 // Returns the value of the ith member of this object.
@@ -263,15 +398,7 @@ double State::operator()(QString key) const
 // Returns the value of the ith member of this object.
 double State::getMember(int i) const
 {
-	if (memberTypes[i].startsWith('i'))
-        return (double)(*((int*)((quint64)this+memberOffsets[i])));
-    if (memberTypes[i].startsWith('j'))
-        return (double)(*((unsigned int*)((quint64)this+memberOffsets[i])));
-	else if (memberTypes[i].startsWith('b'))
-        return (double)(*((bool*)((quint64)this+memberOffsets[i])));
-	else if (memberTypes[i].startsWith('f'))
-        return (double)(*((float*)((quint64)this+memberOffsets[i])));
-    return *((double*)((quint64)this+memberOffsets[i]));
+    return members[i].get((const char*)this + members[i].offset);
 }
 
 // Returns the value of the member that was registered with the given key.
@@ -279,31 +406,16 @@ double State::getMember(int i) const
 // Index based access is faster than key based access.
 double State::getMember(QString key) const
 {
-	int memberIndex = 0;
-	bool memberFound = false;
-    while (!memberFound)
-		if (memberNames[memberIndex++] == key)
-			memberFound = true;
-
-	if (memberFound)
-		return getMember(memberIndex-1);
-
-	return 0;
+    int i = memberId(key);
+    if (i < 0)
+        return 0;
+    return getMember(i);
 }
 
 // Sets the ith member to value v.
 void State::setMember(int i, double v)
 {
-//	QMutexLocker locker(&mutex);
-
-	if (memberTypes[i].startsWith('i'))
-      *((int*)((quint64)this+memberOffsets[i])) = (int)v;
-	else if (memberTypes[i].startsWith('b'))
-        *((bool*)((quint64)this+memberOffsets[i])) = (bool)v;
-	else if (memberTypes[i].startsWith('f'))
-        *((float*)((quint64)this+memberOffsets[i])) = (float)v;
-	else
-        *((double*)((quint64)this+memberOffsets[i])) = (double)v;
+    members[i].set((char*)this + members[i].offset, v);
 }
 
 // Sets the value of the member that was registered with the given key.
@@ -311,14 +423,17 @@ void State::setMember(int i, double v)
 // Index based access is faster than key based access.
 void State::setMember(QString key, double v)
 {
-	int memberIndex = 0;
-	bool memberFound = false;
-    while (!memberFound)
-		if (memberNames[memberIndex++] == key)
-			memberFound = true;
-
-	if (memberFound)
-		setMember(memberIndex-1, v);
-	else
+    int i = memberId(key);
+    if (i >= 0)
+        setMember(i, v);
+    else
         qDebug() << "Unable to find state member" << key;
 }
+
+// Returns the index of the member that was registered with the given key, or -1
+// if there is none. Resolve keys once with this and use the index based access
+// in loops.
+int State::memberId(QString key)
+{
+    return memberIds.value(key, -1);
+}
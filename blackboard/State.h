@@ -5,12 +5,16 @@
 #include <QList>
 #include <QStringList>
 #include <QMutex>
-#include <typeinfo>
+#include <QHash>
 #include "util/Vec3.h"
 #include "util/Transform3D.h"
 #include "util/ColorUtil.h"
 #include "GridModel.h"
 #include "SampleGrid.h"
+#include "geometry/PolygonSet.h"
+#include "util/SharedBuffer.h"
+#include "recording/AsyncRecorder.h"
+#include "Profiler.h"
 
 // Represents the current state of the robot and its perception of the world.
 struct State
@@ -22,17 +26,41 @@ struct State
     double rcIterationTime; // How long did the last RC iteration really take?
     double rcExecutionTime; // The execution time of the last RC iteration.
     double avgExecutionTime; // Running average of the execution time.
+    double captureTime; // System time at which the current point cloud was captured.
+    double publishTime; // System time at which the polygons of this frame were published.
+    double latency; // Time from the capture of the point cloud to the publication of the polygons.
+    double stageP50[Profiler::NUMBER_OF_STAGES]; // Median latency of every pipeline stage.
+    double stageP99[Profiler::NUMBER_OF_STAGES]; // 99th percentile latency of every pipeline stage.
+    double stageMax[Profiler::NUMBER_OF_STAGES]; // Maximum latency of every pipeline stage.
 
     GridModel gridModel;
     SampleGrid sampleGrid;
     Transform3D cameraTransform;
-    Vector<Polygon> polygons;
+    PolygonSet polygonSet; // The polygons extracted from the current frame in the robot frame.
     Sample floor;
     double numPolygons;
     double numVertices;
 
-    Vec3 pointBuffer[NUMBER_OF_POINTS];
-    Pixel colorBuffer[NUMBER_OF_POINTS];
+    Vec3 odometryPose; // Pose (x, y, theta) of the robot in the world frame at the capture time.
+    Vector<Polygon> stablePolygons; // The polygons after temporal stabilization.
+    Vector<int> stablePolygonIds; // A persistent id per stable polygon.
+    Vector<char> stablePolygonUnchanged; // Set for the stable polygons that did not change since the last frame.
+    double numChangedPolygons; // Number of stable polygons that changed or appeared.
+    Vector<Polygon> publishedPolygons; // The stable polygons in the robot frame at the publish time.
+    Vector<Polygon> mapPolygons; // Obstacle polygons fused over time in the world frame.
+    double numMapPolygons;
+    Vec3 registrationDelta; // Motion (x, y, theta) since the last frame estimated by polygon registration.
+    double registrationError; // Root mean square point to edge distance of the registration.
+    double registrationInliers; // Number of matched points of the registration.
+    double recorderQueued; // Frames waiting in the queue of the background recorder.
+    double recorderDropped; // Frames the background recorder dropped because its queue was full.
+    double recorderBlocked; // Frames for which the control loop waited for the background recorder.
+    double recorderWritten; // Frames the background recorder has written to file.
+
+    // The point cloud of the frame. The buffers are shared copy-on-write with the history
+    // and the frame source, so use data() to write into them.
+    SharedBuffer<Vec3> pointBuffer;
+    SharedBuffer<Pixel> colorBuffer;
 
     static QMutex gMutex;
 
@@ -46,8 +74,9 @@ struct State
     void bufferOverwrite(int frameIndex);
     void restore(int frameIndex);
     void bufferToFile();
+    void closeFile();
+    void recordChannels(RecordingChannels& channels) const;
     void saveHistory() const;
-    void loadHistory(int maxLength);
     int size() const;
     State& operator[](int i);
     double operator()(int i) const;
@@ -56,26 +85,54 @@ struct State
     double getMember(QString key) const;
     void setMember(int i, double v);
     void setMember(QString key, double v);
+    static int memberId(QString key);
 
     static QStringList memberNames; // Contains the names of the members in the right order.
 
 private:
 
+    // A registered member. The accessors are instantiated for the type of the
+    // member at registration and convert between the member and double.
+    struct Member
+    {
+        quint64 offset;
+        double (*get)(const char* address);
+        void (*set)(char* address, double v);
+    };
+
+    template <typename T>
+    static double getValue(const char* address) {return (double)*((const T*)address);}
+    template <typename T>
+    static void setValue(char* address, double v) {*((T*)address) = (T)v;}
+
     // Registers a member variable for index based access.
     template <typename T>
     void registerMember(QString name, T* member)
     {
+        Member m;
+        m.offset = (quint64)member - (quint64)this;
+        m.get = &getValue<T>;
+        m.set = &setValue<T>;
+        memberIds[name] = members.size();
         memberNames << name;
-        memberOffsets << (quint64)member - (quint64)this;
-        memberTypes << QString(typeid(*member).name());
-        //qDebug() << name << memberTypes.last();
+        members << m;
     }
 
     // These members are static so that buffering into history does not create copies.
-    static QList<quint64> memberOffsets;
-    static QList<QString> memberTypes;
+    static Vector<Member> members;
+    static QHash<QString, int> memberIds;
     static QMutex mutex;
-    static QList<State> history;
+
+    // The history is a ring of preallocated state slots. historyHead is the slot of the
+    // most recent state, historyCount the number of valid slots.
+    static Vector<State> history;
+    static int historyHead;
+    static int historyCount;
+    static AsyncRecorder recorder; // Appends the frames buffered to file in the background.
+    static QMutex recorderMutex;
+    static State& historyAt(int i);
+    static void setHistoryCapacity(int capacity);
+    void copyBuffered(const State& s);
 };
 
 extern State state;
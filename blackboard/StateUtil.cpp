@@ -1,52 +1,41 @@
 #include "StateUtil.h"
-#include "Config.h"
+#include "Telemetry.h"
 
 StateUtil stateUtil;
 
 StateUtil::StateUtil()
 {
-	stateIndexOffset = 0;
 }
 
 
-// Returns the floor state index for the given time t.
-// This is needed to find the state history index for a real time t.
+// Returns the floor telemetry index for the given time t.
+// This is needed to find the telemetry index for a real time t.
+// The samples are ordered by time, so a binary search finds the index.
 int StateUtil::findIndex(double t)
 {
-	int stateIndex = qBound(1, int( double(state.size()-1) - t/config.rcIterationTime + stateIndexOffset), state.size()-1);
-	while (stateIndex < state.size()-1 && state[stateIndex].time > t)
+	int lo = 1;
+	int hi = qMax(1, telemetry.size()-1);
+	while (lo < hi)
 	{
-		stateIndex++;
-		stateIndexOffset++;
-	}
-	while (stateIndex > 1 && state[stateIndex-1].time <= t)
-	{
-		stateIndex--;
-		stateIndexOffset--;
+		int mid = (lo+hi)/2;
+		if (telemetry.time(mid) > t)
+			lo = mid+1;
+		else
+			hi = mid;
 	}
 
-	return stateIndex;
+	return lo;
 }
 
-// Finds the minimum of all state members over the currently loaded state history.
-State StateUtil::minState()
+// Returns the minimum of a state member over the recorded telemetry.
+double StateUtil::minValue(int memberId)
 {
-	State min = state[0];
-	for (int i = state.size(); i > 0; i--)
-		for (int j = 0; j < state.memberNames.size(); j++)
-			if (min.getMember(j) > state[i].getMember(j))
-				min.setMember(j, state[i].getMember(j));
-	return min;
+	return telemetry.min(memberId);
 }
 
-// Finds the maximum of all state members over the currently loaded state history.
-State StateUtil::maxState()
+// Returns the maximum of a state member over the recorded telemetry.
+double StateUtil::maxValue(int memberId)
 {
-	State max = state[0];
-	for (int i = state.size(); i > 0; i--)
-		for (int j = 0; j < state.memberNames.size(); j++)
-			if (max.getMember(j) < state[i].getMember(j))
-				max.setMember(j, state[i].getMember(j));
-	return max;
+	return telemetry.max(memberId);
 }
 
@@ -5,14 +5,12 @@
 
 class StateUtil
 {
-	int stateIndexOffset;
-
 public:
 	StateUtil();
     ~StateUtil(){}
 	int findIndex(double t);
-	State minState();
-	State maxState();
+	double minValue(int memberId);
+	double maxValue(int memberId);
 };
 
 extern StateUtil stateUtil;
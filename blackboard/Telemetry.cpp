@@ -0,0 +1,189 @@
+#include "Telemetry.h"
+#include "State.h"
+#include <QMutexLocker>
+#include <limits>
+
+// The telemetry keeps the registered state members of every buffered state in one
+// ring buffer per member. A sample takes eight bytes per member, whereas a buffered
+// state carries the grid, the polygons and the point cloud. Therefore the telemetry
+// can be much longer than the state history, and the graphs can show hours of data
+// while the state history only holds the last seconds. Sample i of the telemetry
+// belongs to the state history entry i for as long as the history reaches back.
+//
+// Each column also tracks its minimum and maximum. They are updated when a sample
+// is stored. Only when the sample that leaves the ring was an extremum, the column
+// is marked dirty and rescanned on the next query.
+
+Telemetry telemetry;
+
+Telemetry::Telemetry()
+{
+    numColumns = 0;
+    capacity = 0;
+    head = -1;
+    count = 0;
+    timeColumn = -1;
+}
+
+// Removes all samples.
+void Telemetry::clear()
+{
+    QMutexLocker locker(&mutex);
+    head = -1;
+    count = 0;
+    for (int c = 0; c < numColumns; c++)
+    {
+        minimum[c] = std::numeric_limits<double>::max();
+        maximum[c] = -std::numeric_limits<double>::max();
+        dirty[c] = 0;
+    }
+}
+
+// Appends the registered members of the state s as the newest sample.
+// When the ring holds maxLength samples, the oldest one is replaced.
+void Telemetry::append(const State& s, int maxLength)
+{
+    QMutexLocker locker(&mutex);
+
+    if (numColumns != State::memberNames.size() || capacity != qMax(1, maxLength))
+        setCapacity(State::memberNames.size(), maxLength);
+
+    head = (head+1) % capacity;
+    store(head, count == capacity, s);
+    count = qMin(count+1, capacity);
+}
+
+// Replaces the ith most recent sample with the registered members of the state s.
+void Telemetry::overwrite(int i, const State& s)
+{
+    QMutexLocker locker(&mutex);
+    if (i < 0 || i >= count || numColumns != State::memberNames.size())
+        return;
+    store(slot(i), true, s);
+}
+
+// Returns the number of samples.
+int Telemetry::size() const
+{
+    QMutexLocker locker(&mutex);
+    return count;
+}
+
+// Returns the number of columns, which is the number of registered state members.
+int Telemetry::columns() const
+{
+    QMutexLocker locker(&mutex);
+    return numColumns;
+}
+
+// Returns the value of the given column in the ith most recent sample.
+// i = 0 is the newest sample. Indices beyond the oldest sample return the oldest sample.
+double Telemetry::value(int i, int column) const
+{
+    QMutexLocker locker(&mutex);
+    if (count == 0 || column < 0 || column >= numColumns)
+        return 0;
+    return data[column*capacity + slot(qBound(0, i, count-1))];
+}
+
+// Returns the time of the ith most recent sample.
+double Telemetry::time(int i) const
+{
+    return value(i, timeColumn);
+}
+
+// Returns the smallest value of the given column over all samples.
+// NaN values are ignored.
+double Telemetry::min(int column) const
+{
+    QMutexLocker locker(&mutex);
+    if (count == 0 || column < 0 || column >= numColumns)
+        return 0;
+    if (dirty[column])
+        rescan(column);
+    return minimum[column];
+}
+
+// Returns the largest value of the given column over all samples.
+// NaN values are ignored.
+double Telemetry::max(int column) const
+{
+    QMutexLocker locker(&mutex);
+    if (count == 0 || column < 0 || column >= numColumns)
+        return 0;
+    if (dirty[column])
+        rescan(column);
+    return maximum[column];
+}
+
+// Returns the slot of the ith most recent sample.
+int Telemetry::slot(int i) const
+{
+    int k = head - i;
+    if (k < 0)
+        k += capacity;
+    return k;
+}
+
+// Stores the registered members of s in a slot and maintains the extrema.
+// occupied tells if the slot holds a sample that is being replaced.
+void Telemetry::store(int slot, bool occupied, const State& s)
+{
+    for (int c = 0; c < numColumns; c++)
+    {
+        double& v = data[c*capacity + slot];
+        if (occupied && (v == minimum[c] || v == maximum[c]))
+            dirty[c] = 1;
+
+        v = s.getMember(c);
+        if (v == v)
+        {
+            minimum[c] = qMin(minimum[c], v);
+            maximum[c] = qMax(maximum[c], v);
+        }
+    }
+}
+
+// Reallocates the columns with the given capacity and keeps the most recent samples.
+// This happens only when the capacity or the set of registered members changes.
+void Telemetry::setCapacity(int columns, int capacity)
+{
+    capacity = qMax(1, capacity);
+    int n = (columns == numColumns) ? qMin(count, capacity) : 0;
+
+    Vector<double> ring(columns*capacity);
+    for (int c = 0; c < qMin(columns, numColumns); c++)
+        for (int i = 0; i < n; i++)
+            ring[c*capacity + n-1-i] = data[c*this->capacity + slot(i)];
+
+    data = ring;
+    minimum.resize(columns);
+    maximum.resize(columns);
+    dirty.resize(columns);
+    for (int c = 0; c < columns; c++)
+        dirty[c] = 1;
+    numColumns = columns;
+    this->capacity = capacity;
+    head = n-1;
+    count = n;
+    timeColumn = State::memberId("time");
+}
+
+// Recomputes the extrema of a column from the samples in the ring.
+void Telemetry::rescan(int column) const
+{
+    double mi = std::numeric_limits<double>::max();
+    double ma = -std::numeric_limits<double>::max();
+    const double* v = data.data() + column*capacity;
+    for (int i = 0; i < count; i++)
+    {
+        if (v[i] == v[i])
+        {
+            mi = qMin(mi, v[i]);
+            ma = qMax(ma, v[i]);
+        }
+    }
+    minimum[column] = mi;
+    maximum[column] = ma;
+    dirty[column] = 0;
+}
@@ -0,0 +1,49 @@
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <QMutex>
+#include "util/Vector.h"
+
+struct State;
+
+// Columnar store of the scalar state members over time.
+// Each registered state member has its own ring buffer, so that long telemetry
+// histories can be kept without keeping copies of the whole state.
+class Telemetry
+{
+    Vector<double> data; // Column c occupies the slots [c*capacity, (c+1)*capacity).
+    mutable Vector<double> minimum;
+    mutable Vector<double> maximum;
+    mutable Vector<char> dirty; // Set when the extremum of a column left the ring.
+    int numColumns;
+    int capacity;
+    int head; // Slot of the newest sample.
+    int count;
+    int timeColumn;
+    mutable QMutex mutex;
+
+public:
+
+    Telemetry();
+    ~Telemetry(){}
+
+    void clear();
+    void append(const State& s, int maxLength);
+    void overwrite(int i, const State& s);
+    int size() const;
+    int columns() const;
+    double value(int i, int column) const;
+    double time(int i) const;
+    double min(int column) const;
+    double max(int column) const;
+
+private:
+    int slot(int i) const;
+    void store(int slot, bool occupied, const State& s);
+    void setCapacity(int columns, int capacity);
+    void rescan(int column) const;
+};
+
+extern Telemetry telemetry;
+
+#endif /* TELEMETRY_H_ */
@@ -1,11 +1,15 @@
 HEADERS += blackboard/State.h \
     blackboard/Command.h \
     blackboard/StateUtil.h \
+    blackboard/Snapshot.h \
+    blackboard/Telemetry.h \
     blackboard/Config.h
 SOURCES += blackboard/Command.cpp \
     blackboard/Config.cpp \
     blackboard/State.cpp \
-    blackboard/StateUtil.cpp
+    blackboard/StateUtil.cpp \
+    blackboard/Snapshot.cpp \
+    blackboard/Telemetry.cpp
     
 
 
@@ -0,0 +1,231 @@
+#include "HeadlessRunner.h"
+#include "blackboard/State.h"
+#include "blackboard/Config.h"
+#include "util/StopWatch.h"
+#include "util/Statistics.h"
+#include "Profiler.h"
+#include "globals.h"
+#include <QJsonArray>
+
+// The HeadlessRunner drives the same RobotControl as the GUI, but the frames come
+// straight from a recording or from a SyntheticScene and are processed back to back.
+// Nothing is buffered into the state history or written to file. Every stage of a
+// step is timed, and the outputs of every frame are collected, so that report() can
+// summarize a run in a machine readable form.
+
+HeadlessRunner::HeadlessRunner()
+{
+    synthetic = false;
+    syntheticFrames = 0;
+    processedFrames = 0;
+    runTime = 0;
+    stages[LOAD].name = "load";
+    stages[SENSE].name = "sense";
+    stages[ACT].name = "act";
+    stages[FRAME].name = "frame";
+}
+
+// Initializes the state, the config and the robot control. The config is loaded
+// from conf/<configName>.conf.
+void HeadlessRunner::init(QString configName)
+{
+    state.init();
+    config.init();
+    config.load(configName);
+    robotControl.init();
+}
+
+// Uses the frames of a recording as the input.
+bool HeadlessRunner::openRecording(QString fileName)
+{
+    synthetic = false;
+    if (!recording.open(fileName))
+        return false;
+    if (recording.numPoints() != NUMBER_OF_POINTS)
+    {
+        qDebug() << "HeadlessRunner::openRecording(): the recording has" << recording.numPoints() << "points per frame instead of" << NUMBER_OF_POINTS;
+        recording.close();
+        return false;
+    }
+    source = fileName;
+    return true;
+}
+
+// Uses frames of a synthetic scene with the given number of obstacles as the input.
+void HeadlessRunner::useSyntheticScene(int frames, int obstacles)
+{
+    recording.close();
+    synthetic = true;
+    syntheticFrames = qMax(0, frames);
+    scene.setObstacles(obstacles);
+    source = "synthetic";
+}
+
+// Returns the number of frames of the input.
+int HeadlessRunner::numFrames() const
+{
+    return synthetic ? syntheticFrames : recording.numFrames();
+}
+
+// Processes the frames of the input. The first warmupFrames frames are processed,
+// but not measured. With maxFrames < 0 all frames are processed.
+void HeadlessRunner::run(int maxFrames, int warmupFrames)
+{
+    int n = numFrames();
+    if (maxFrames >= 0)
+        n = qMin(n, maxFrames + warmupFrames);
+
+    for (int s = 0; s < NUMBER_OF_STAGES; s++)
+        stages[s].latencies.clear();
+    polygons.clear();
+    vertices.clear();
+    changedPolygons.clear();
+    floorHeight.clear();
+    floorTilt.clear();
+    processedFrames = 0;
+
+    StopWatch total;
+    StopWatch stopWatch;
+    double t[NUMBER_OF_STAGES];
+    for (int i = 0; i < n; i++)
+    {
+        if (i == warmupFrames)
+        {
+            profiler.reset();
+            total.start();
+        }
+
+        stopWatch.start();
+        if (!loadFrame(i))
+            break;
+        t[LOAD] = stopWatch.elapsedTimeMs();
+
+        stopWatch.start();
+        state.captureTime = stopWatch.systemTime();
+        robotControl.sense();
+        t[SENSE] = stopWatch.elapsedTimeMs();
+
+        stopWatch.start();
+        robotControl.act();
+        t[ACT] = stopWatch.elapsedTimeMs();
+        t[FRAME] = t[LOAD] + t[SENSE] + t[ACT];
+
+        state.rcExecutionTime = 0.001*(t[SENSE] + t[ACT]);
+        state.frameId++;
+
+        if (i < warmupFrames)
+            continue;
+
+        for (int s = 0; s < NUMBER_OF_STAGES; s++)
+            stages[s].latencies << t[s];
+        polygons << state.numPolygons;
+        vertices << state.numVertices;
+        changedPolygons << state.numChangedPolygons;
+        floorHeight << state.floor.p.z;
+        floorTilt << acos(qBound(-1.0, state.floor.n.normalized()*Vec3(0,0,1), 1.0));
+        processedFrames++;
+    }
+
+    runTime = processedFrames > 0 ? total.elapsedTime() : 0;
+}
+
+// Puts frame i of the input into the state.
+bool HeadlessRunner::loadFrame(int i)
+{
+    if (synthetic)
+    {
+        scene.generate(i, state.pointBuffer.data(), state.colorBuffer.data());
+        state.time = i*config.rcIterationTime;
+        return true;
+    }
+
+    if (i >= recording.numFrames())
+        return false;
+    recording.readFrame(i, state.pointBuffer.data(), state.colorBuffer.data());
+    state.time = recording.time(i);
+    return true;
+}
+
+// Summarizes the results of the last run.
+QJsonObject HeadlessRunner::report() const
+{
+    QJsonObject input;
+    input["source"] = source;
+    input["frames"] = processedFrames;
+    if (synthetic)
+        input["obstacles"] = scene.numObstacles();
+
+    QJsonObject throughput;
+    throughput["runTime"] = runTime;
+    throughput["framesPerSecond"] = runTime > 0 ? processedFrames/runTime : 0.0;
+
+    QJsonObject latency;
+    for (int s = 0; s < NUMBER_OF_STAGES; s++)
+        latency[stages[s].name] = latencySummary(stages[s].latencies);
+    latency["stages"] = stageSummary(profiler);
+
+    QJsonObject outputs;
+    outputs["polygons"] = valueSummary(polygons);
+    outputs["vertices"] = valueSummary(vertices);
+    outputs["changedPolygons"] = valueSummary(changedPolygons);
+    outputs["floorHeight"] = valueSummary(floorHeight);
+    outputs["floorTilt"] = valueSummary(floorTilt);
+    outputs["mapPolygons"] = state.numMapPolygons;
+
+    QJsonObject conf;
+    foreach (QString key, config.memberNames)
+        conf[key] = config[key];
+
+    QJsonObject json;
+    json["input"] = input;
+    json["throughput"] = throughput;
+    json["latency"] = latency;
+    json["outputs"] = outputs;
+    json["config"] = conf;
+    return json;
+}
+
+// Returns the mean, the percentiles and the maximum of the latencies in milliseconds.
+QJsonObject HeadlessRunner::latencySummary(const Vector<double>& latencies)
+{
+    QJsonObject json;
+    if (latencies.isEmpty())
+        return json;
+    json["mean"] = Statistics::mean(latencies);
+    json["p50"] = Statistics::percentile(latencies, 50);
+    json["p90"] = Statistics::percentile(latencies, 90);
+    json["p99"] = Statistics::percentile(latencies, 99);
+    json["max"] = Statistics::max(latencies);
+    return json;
+}
+
+// Returns the mean, the percentiles and the maximum of the latencies of the pipeline
+// stages recorded by the profiler in milliseconds.
+QJsonObject HeadlessRunner::stageSummary(const Profiler& profiler)
+{
+    QJsonObject json;
+    for (int s = 0; s < Profiler::NUMBER_OF_STAGES; s++)
+    {
+        const LatencyHistogram& h = profiler.histogram(s);
+        QJsonObject stage;
+        stage["count"] = (double)h.count();
+        stage["mean"] = 1000.0 * h.mean();
+        stage["p50"] = 1000.0 * h.percentile(50);
+        stage["p99"] = 1000.0 * h.percentile(99);
+        stage["max"] = 1000.0 * h.max();
+        json[Profiler::stageName(s)] = stage;
+    }
+    return json;
+}
+
+// Returns the mean, the minimum and the maximum of the values.
+QJsonObject HeadlessRunner::valueSummary(const Vector<double>& values)
+{
+    QJsonObject json;
+    if (values.isEmpty())
+        return json;
+    json["mean"] = Statistics::mean(values);
+    json["min"] = Statistics::min(values);
+    json["max"] = Statistics::max(values);
+    return json;
+}
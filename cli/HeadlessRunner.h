@@ -0,0 +1,61 @@
+#ifndef HEADLESSRUNNER_H
+#define HEADLESSRUNNER_H
+#include <QString>
+#include <QJsonObject>
+#include "RobotControl.h"
+#include "recording/Recording.h"
+#include "recording/SyntheticScene.h"
+#include "util/Vector.h"
+#include "Profiler.h"
+
+// Runs the robot control on the frames of a recording or a synthetic scene
+// as fast as possible, without a GUI, and reports the throughput, the latency
+// of the stages and a summary of the outputs.
+class HeadlessRunner
+{
+    // The latencies of a stage in milliseconds, one per frame.
+    struct Stage
+    {
+        QString name;
+        Vector<double> latencies;
+    };
+
+    enum {LOAD, SENSE, ACT, FRAME, NUMBER_OF_STAGES};
+
+    RobotControl robotControl;
+    Recording recording;
+    SyntheticScene scene;
+    bool synthetic;
+    int syntheticFrames;
+    QString source;
+
+    Stage stages[NUMBER_OF_STAGES];
+    Vector<double> polygons;
+    Vector<double> vertices;
+    Vector<double> changedPolygons;
+    Vector<double> floorHeight;
+    Vector<double> floorTilt;
+    int processedFrames;
+    double runTime;
+
+public:
+
+    HeadlessRunner();
+    ~HeadlessRunner(){}
+
+    void init(QString configName = "");
+    bool openRecording(QString fileName);
+    void useSyntheticScene(int frames, int obstacles);
+    int numFrames() const;
+
+    void run(int maxFrames = -1, int warmupFrames = 0);
+    QJsonObject report() const;
+    static QJsonObject stageSummary(const Profiler& profiler);
+
+private:
+    bool loadFrame(int i);
+    static QJsonObject latencySummary(const Vector<double>& latencies);
+    static QJsonObject valueSummary(const Vector<double>& values);
+};
+
+#endif // HEADLESSRUNNER_H
@@ -0,0 +1,355 @@
+#include "ParameterSweep.h"
+#include "util/Statistics.h"
+#include "HeadlessRunner.h"
+#include "Profiler.h"
+#include "globals.h"
+#include <QJsonArray>
+#include <QDebug>
+#include <algorithm>
+
+// The ParameterSweep runs the BatchProcessor over the same frames of a recording
+// once per candidate setting of the swept parameters. Every candidate starts from a
+// copy of the base config, so the global config is never touched. The base config
+// itself is run first and serves as the reference for the quality metrics:
+//
+// - latency: the pipeline execution time per frame, measured while all cores run
+//   the pipeline, so that it reflects a loaded machine. The latencies of the
+//   individual stages are reported as well.
+// - iou: the polygons of a frame and of the reference frame are rasterized into the
+//   larger of the two grid bounds and the intersection over union of the covered
+//   cells is averaged over the frames. Two empty frames count as a perfect match.
+// - floorJitter and tiltJitter: the RMS change of the floor height under the camera
+//   and of the floor tilt between consecutive frames. A stable floor estimate keeps
+//   the polygons still.
+//
+// A candidate is on the Pareto front if no other candidate is at least as good in
+// latency, 1-iou and floor jitter and better in one of them.
+
+ParameterSweep::ParameterSweep()
+{
+    base = config;
+    first = 0;
+    count = -1;
+    resolution = 0.02;
+    extentX = 0;
+    extentY = 0;
+}
+
+// Opens the recording that is processed for every candidate.
+bool ParameterSweep::open(QString fileName)
+{
+    return batch.open(fileName);
+}
+
+// Sets the config that provides the values of all parameters that are not swept.
+void ParameterSweep::setBaseConfig(const Config& conf)
+{
+    base = conf;
+}
+
+// Restricts the evaluation to count frames starting at first. count < 0 means all frames.
+void ParameterSweep::setFrames(int first, int count)
+{
+    this->first = first;
+    this->count = count;
+}
+
+// Sets the number of worker threads. 0 uses one thread per core.
+void ParameterSweep::setThreads(int threads)
+{
+    batch.setThreads(threads);
+}
+
+// Adds a config parameter to the sweep. A grid search visits steps values evenly
+// spaced between min and max. Returns false if there is no such parameter.
+bool ParameterSweep::addParameter(QString name, double min, double max, int steps, bool integer)
+{
+    if (!base.memberNames.contains(name))
+    {
+        qDebug() << "ParameterSweep::addParameter(): unknown config parameter" << name;
+        return false;
+    }
+
+    Parameter p;
+    p.name = name;
+    p.min = qMin(min, max);
+    p.max = qMax(min, max);
+    p.steps = qMax(1, steps);
+    p.integer = integer;
+    parameters << p;
+    return true;
+}
+
+// Reads the parameters and the frame range from a sweep specification:
+// {"first": 0, "frames": 500, "threads": 0,
+//  "parameters": [{"name": "floordetection.greedThreshold", "min": 0.01, "max": 0.05, "steps": 5}, ...]}
+bool ParameterSweep::loadSpec(const QJsonObject& spec)
+{
+    parameters.clear();
+    setFrames(spec["first"].toInt(0), spec["frames"].toInt(-1));
+    setThreads(spec["threads"].toInt(0));
+
+    QJsonArray params = spec["parameters"].toArray();
+    for (int i = 0; i < params.size(); i++)
+    {
+        QJsonObject p = params[i].toObject();
+        if (!addParameter(p["name"].toString(), p["min"].toDouble(), p["max"].toDouble(),
+                          p["steps"].toInt(1), p["integer"].toBool(false)))
+            return false;
+    }
+
+    return !parameters.isEmpty();
+}
+
+// Evaluates all combinations of the parameter values.
+void ParameterSweep::gridSearch()
+{
+    candidates.clear();
+    evaluate(reference, true);
+
+    Vector<int> step(parameters.size());
+    for (int i = 0; i < step.size(); i++)
+        step[i] = 0;
+
+    bool done = parameters.isEmpty();
+    while (!done)
+    {
+        Candidate candidate;
+        for (int i = 0; i < parameters.size(); i++)
+        {
+            const Parameter& p = parameters[i];
+            double v = p.steps > 1 ? p.min + step[i] * (p.max - p.min) / (p.steps - 1) : p.min;
+            candidate.values << (p.integer ? qRound(v) : v);
+        }
+        evaluate(candidate);
+        candidates << candidate;
+
+        // Advance the steps like an odometer.
+        done = true;
+        for (int i = 0; i < parameters.size() && done; i++)
+        {
+            if (++step[i] < parameters[i].steps)
+                done = false;
+            else
+                step[i] = 0;
+        }
+    }
+
+    markParetoFront();
+}
+
+// Evaluates samples parameter settings drawn uniformly from the parameter ranges.
+// The same seed yields the same candidates.
+void ParameterSweep::randomSearch(int samples, quint32 seed)
+{
+    candidates.clear();
+    evaluate(reference, true);
+
+    Statistics::setSeed(seed);
+    for (int k = 0; k < samples; k++)
+    {
+        Candidate candidate;
+        for (int i = 0; i < parameters.size(); i++)
+        {
+            const Parameter& p = parameters[i];
+            double v = Statistics::uniformSample(p.min, p.max);
+            candidate.values << (p.integer ? qRound(v) : v);
+        }
+        evaluate(candidate);
+        candidates << candidate;
+    }
+
+    markParetoFront();
+}
+
+// Loads the spec and runs the search it asks for. "search" is "grid" or "random",
+// and a random search evaluates "samples" candidates drawn with "seed".
+bool ParameterSweep::runSpec(const QJsonObject& spec)
+{
+    if (!batch.isOpen() || !loadSpec(spec))
+        return false;
+
+    if (spec["search"].toString("grid") == "random")
+        randomSearch(spec["samples"].toInt(32), spec["seed"].toInt(1));
+    else
+        gridSearch();
+    return true;
+}
+
+// Runs the pipeline with the parameter values of the candidate and measures it.
+void ParameterSweep::evaluate(Candidate& candidate, bool isReference)
+{
+    Config conf = base;
+    for (int i = 0; i < candidate.values.size(); i++)
+        conf[parameters[i].name] = candidate.values[i];
+
+    batch.setConfig(conf);
+    batch.run(first, count);
+
+    // The masks cover the grids of both the candidate and the reference, so that
+    // no polygons are clipped when the grid extent is swept.
+    extentX = qMax(base.gridX, conf.gridX);
+    extentY = qMax(base.gridY, conf.gridY);
+    candidate.stages = HeadlessRunner::stageSummary(batch.getProfiler());
+    const Vector<BatchResult>& results = batch.getResults();
+    if (isReference)
+        referenceResults = results;
+
+    int n = results.size();
+    Vector<double> latencies(n);
+    double polygons = 0;
+    double vertices = 0;
+    double iouSum = 0;
+    double heightSum = 0;
+    double tiltSum = 0;
+    double lastHeight = 0;
+    double lastTilt = 0;
+    for (int i = 0; i < n; i++)
+    {
+        const BatchResult& r = results[i];
+        latencies[i] = 1000.0 * r.executionTime;
+        polygons += r.polygonSet.size();
+        vertices += r.polygonSet.numVertices();
+        iouSum += isReference ? 1.0 : iou(r.polygonSet, referenceResults[i].polygonSet);
+
+        double height = 1000.0 * r.floor.evaluateAt(Vec2(0, 0));
+        double tilt = acos(qBound(-1.0, r.floor.n.normalized() * Vec3(0, 0, 1), 1.0)) * 180.0 / PI;
+        if (i > 0)
+        {
+            heightSum += (height - lastHeight) * (height - lastHeight);
+            tiltSum += (tilt - lastTilt) * (tilt - lastTilt);
+        }
+        lastHeight = height;
+        lastTilt = tilt;
+    }
+
+    if (n == 0)
+        return;
+
+    candidate.latencyMean = Statistics::mean(latencies);
+    candidate.latencyP50 = Statistics::percentile(latencies, 50);
+    candidate.latencyP99 = Statistics::percentile(latencies, 99);
+    candidate.throughput = batch.getThroughput();
+    candidate.polygons = polygons / n;
+    candidate.vertices = vertices / n;
+    candidate.iou = iouSum / n;
+    candidate.floorJitter = n > 1 ? sqrt(heightSum / (n-1)) : 0;
+    candidate.tiltJitter = n > 1 ? sqrt(tiltSum / (n-1)) : 0;
+}
+
+// Returns the intersection over union of the areas covered by two polygon sets.
+double ParameterSweep::iou(const PolygonSet& a, const PolygonSet& b)
+{
+    if (a.size() == 0 && b.size() == 0)
+        return 1.0;
+
+    rasterize(a, maskA);
+    rasterize(b, maskB);
+    int intersection = cv::countNonZero(maskA & maskB);
+    int unification = cv::countNonZero(maskA | maskB);
+    return unification > 0 ? (double)intersection / unification : 1.0;
+}
+
+// Draws the polygons into a mask that covers the extent with cells of the resolution size.
+void ParameterSweep::rasterize(const PolygonSet& polygons, cv::Mat& mask) const
+{
+    int rows = qMax(1, (int)(2.0 * extentY / resolution));
+    int cols = qMax(1, (int)(extentX / resolution));
+    mask.create(rows, cols, CV_8UC1);
+    mask.setTo(cv::Scalar(0));
+
+    PolygonSetView view = polygons.view();
+    std::vector<std::vector<cv::Point> > contours(view.size());
+    for (int i = 0; i < view.size(); i++)
+    {
+        for (int j = 0; j < view.size(i); j++)
+        {
+            Vec2 v = view.vertex(i, j);
+            contours[i].push_back(cv::Point((int)(v.x / resolution), (int)((v.y + extentY) / resolution)));
+        }
+    }
+
+    // Polygons are filled one by one, so that overlapping polygons do not cancel out.
+    for (uint i = 0; i < contours.size(); i++)
+        if (!contours[i].empty())
+            cv::fillPoly(mask, std::vector<std::vector<cv::Point> >(1, contours[i]), cv::Scalar(255));
+}
+
+// Marks the candidates that are not dominated by another candidate.
+void ParameterSweep::markParetoFront()
+{
+    for (int i = 0; i < candidates.size(); i++)
+    {
+        const Candidate& a = candidates[i];
+        candidates[i].pareto = true;
+        for (int j = 0; j < candidates.size(); j++)
+        {
+            const Candidate& b = candidates[j];
+            bool noWorse = b.latencyMean <= a.latencyMean && b.iou >= a.iou && b.floorJitter <= a.floorJitter;
+            bool better = b.latencyMean < a.latencyMean || b.iou > a.iou || b.floorJitter < a.floorJitter;
+            if (j != i && noWorse && better)
+            {
+                candidates[i].pareto = false;
+                break;
+            }
+        }
+    }
+}
+
+// Returns the reference, all candidates and the indices of the Pareto optimal
+// candidates sorted by latency.
+QJsonObject ParameterSweep::report() const
+{
+    QJsonObject json;
+
+    QJsonArray names;
+    for (int i = 0; i < parameters.size(); i++)
+        names.append(parameters[i].name);
+    json["parameters"] = names;
+    json["frames"] = referenceResults.size();
+    json["reference"] = toJson(reference);
+
+    QJsonArray all;
+    Vector<int> front;
+    for (int i = 0; i < candidates.size(); i++)
+    {
+        all.append(toJson(candidates[i]));
+        if (candidates[i].pareto)
+            front << i;
+    }
+    json["candidates"] = all;
+
+    if (!front.isEmpty())
+        std::sort(&front[0], &front[0] + front.size(), [this](int a, int b) {
+            return candidates[a].latencyMean < candidates[b].latencyMean;
+        });
+    QJsonArray pareto;
+    for (int i = 0; i < front.size(); i++)
+        pareto.append(front[i]);
+    json["pareto"] = pareto;
+
+    return json;
+}
+
+// Returns the parameter values and the metrics of a candidate.
+QJsonObject ParameterSweep::toJson(const Candidate& candidate) const
+{
+    QJsonObject values;
+    for (int i = 0; i < candidate.values.size(); i++)
+        values[parameters[i].name] = candidate.values[i];
+
+    QJsonObject json;
+    json["values"] = values;
+    json["latencyMean"] = candidate.latencyMean;
+    json["latencyP50"] = candidate.latencyP50;
+    json["latencyP99"] = candidate.latencyP99;
+    json["throughput"] = candidate.throughput;
+    json["polygons"] = candidate.polygons;
+    json["vertices"] = candidate.vertices;
+    json["iou"] = candidate.iou;
+    json["floorJitter"] = candidate.floorJitter;
+    json["tiltJitter"] = candidate.tiltJitter;
+    json["stages"] = candidate.stages;
+    json["pareto"] = candidate.pareto;
+    return json;
+}
@@ -0,0 +1,79 @@
+#ifndef PARAMETERSWEEP_H
+#define PARAMETERSWEEP_H
+#include <QString>
+#include <QJsonObject>
+#include "BatchProcessor.h"
+#include "opencv2/imgproc/imgproc.hpp"
+
+// Evaluates the pipeline over a recording for many settings of selected config
+// parameters and finds the settings that trade latency against quality best.
+class ParameterSweep
+{
+    // A config parameter that is varied between min and max.
+    struct Parameter
+    {
+        QString name;
+        double min = 0;
+        double max = 0;
+        int steps = 1; // Number of values of a grid search.
+        bool integer = false; // Round the values.
+    };
+
+    // A setting of the parameters and the measured metrics.
+    struct Candidate
+    {
+        Vector<double> values; // One value per parameter.
+        double latencyMean = 0; // Pipeline execution time in ms.
+        double latencyP50 = 0;
+        double latencyP99 = 0;
+        double throughput = 0; // Frames per second with all cores.
+        double polygons = 0; // Mean number of polygons per frame.
+        double vertices = 0; // Mean number of vertices per frame.
+        double iou = 0; // Mean intersection over union of the polygons with the reference.
+        double floorJitter = 0; // RMS change of the floor height from frame to frame in mm.
+        double tiltJitter = 0; // RMS change of the floor tilt from frame to frame in degrees.
+        QJsonObject stages; // Latencies of the pipeline stages.
+        bool pareto = false;
+    };
+
+    Config base;
+    BatchProcessor batch;
+    Vector<Parameter> parameters;
+    Vector<Candidate> candidates;
+    Candidate reference;
+    Vector<BatchResult> referenceResults;
+    int first;
+    int count;
+    double resolution; // Cell size of the rasterization for the IoU.
+    double extentX; // Grid extent covered by the IoU masks.
+    double extentY;
+    cv::Mat maskA;
+    cv::Mat maskB;
+
+public:
+
+    ParameterSweep();
+    ~ParameterSweep(){}
+
+    bool open(QString fileName);
+    void setBaseConfig(const Config& conf);
+    void setFrames(int first, int count);
+    void setThreads(int threads);
+    bool addParameter(QString name, double min, double max, int steps = 1, bool integer = false);
+    bool loadSpec(const QJsonObject& spec);
+
+    void gridSearch();
+    void randomSearch(int samples, quint32 seed = 1);
+    bool runSpec(const QJsonObject& spec);
+
+    QJsonObject report() const;
+
+private:
+    void evaluate(Candidate& candidate, bool isReference = false);
+    double iou(const PolygonSet& a, const PolygonSet& b);
+    void rasterize(const PolygonSet& polygons, cv::Mat& mask) const;
+    void markParetoFront();
+    QJsonObject toJson(const Candidate& candidate) const;
+};
+
+#endif // PARAMETERSWEEP_H
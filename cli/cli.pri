@@ -0,0 +1,5 @@
+HEADERS += cli/HeadlessRunner.h \
+    cli/ParameterSweep.h
+SOURCES += cli/HeadlessRunner.cpp \
+    cli/ParameterSweep.cpp \
+    cli/main.cpp
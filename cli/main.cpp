@@ -0,0 +1,104 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QFile>
+#include <QTextStream>
+#include "HeadlessRunner.h"
+#include "ParameterSweep.h"
+#include "blackboard/Config.h"
+
+// Command line runner of the perception pipeline. Processes a recording or a
+// synthetic scene without a GUI and prints a JSON report to stdout.
+//
+// polyperception-cli --recording data/statehistory.rec --frames 1000
+// polyperception-cli --synthetic 500 --obstacles 20 --output report.json
+// polyperception-cli --recording data/statehistory.rec --sweep conf/sweep.json
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("polyperception-cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs the polygonal perception pipeline without a GUI and reports the results as JSON.");
+    parser.addHelpOption();
+    QCommandLineOption recordingOption("recording", "Process the frames of the recording <file>.", "file", "data/statehistory.rec");
+    QCommandLineOption syntheticOption("synthetic", "Process <n> frames of a synthetic scene instead of a recording.", "n");
+    QCommandLineOption obstaclesOption("obstacles", "Number of obstacles in the synthetic scene.", "n", "8");
+    QCommandLineOption framesOption("frames", "Process at most <n> frames.", "n", "-1");
+    QCommandLineOption warmupOption("warmup", "Process <n> frames before measuring.", "n", "0");
+    QCommandLineOption configOption("config", "Load the config from conf/<name>.conf.", "name", "config");
+    QCommandLineOption outputOption("output", "Write the report to <file> instead of stdout.", "file");
+    QCommandLineOption sweepOption("sweep", "Sweep the config parameters listed in <spec> over the recording and report the Pareto front.", "spec");
+    parser.addOption(recordingOption);
+    parser.addOption(syntheticOption);
+    parser.addOption(obstaclesOption);
+    parser.addOption(framesOption);
+    parser.addOption(warmupOption);
+    parser.addOption(configOption);
+    parser.addOption(outputOption);
+    parser.addOption(sweepOption);
+    parser.process(a);
+
+    HeadlessRunner runner;
+    runner.init(parser.value(configOption));
+
+    QByteArray json;
+    if (parser.isSet(sweepOption))
+    {
+        QFile specFile(parser.value(sweepOption));
+        if (!specFile.open(QFile::ReadOnly))
+        {
+            QTextStream(stderr) << "Could not read the sweep spec " << specFile.fileName() << endl;
+            return 1;
+        }
+        QJsonObject spec = QJsonDocument::fromJson(specFile.readAll()).object();
+        specFile.close();
+
+        ParameterSweep sweep;
+        sweep.setBaseConfig(config);
+        if (!sweep.open(parser.value(recordingOption)))
+        {
+            QTextStream(stderr) << "Could not open the recording " << parser.value(recordingOption) << endl;
+            return 1;
+        }
+        if (!sweep.runSpec(spec))
+        {
+            QTextStream(stderr) << "Invalid sweep spec " << specFile.fileName() << endl;
+            return 1;
+        }
+        json = QJsonDocument(sweep.report()).toJson(QJsonDocument::Indented);
+    }
+    else
+    {
+        if (parser.isSet(syntheticOption))
+        {
+            runner.useSyntheticScene(parser.value(syntheticOption).toInt(), parser.value(obstaclesOption).toInt());
+        }
+        else if (!runner.openRecording(parser.value(recordingOption)))
+        {
+            QTextStream(stderr) << "Could not open the recording " << parser.value(recordingOption) << endl;
+            return 1;
+        }
+
+        runner.run(parser.value(framesOption).toInt(), parser.value(warmupOption).toInt());
+        json = QJsonDocument(runner.report()).toJson(QJsonDocument::Indented);
+    }
+
+    if (parser.isSet(outputOption))
+    {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QFile::WriteOnly))
+        {
+            QTextStream(stderr) << "Could not write " << file.fileName() << endl;
+            return 1;
+        }
+        file.write(json);
+        file.close();
+    }
+    else
+    {
+        QTextStream(stdout) << json;
+    }
+
+    return 0;
+}
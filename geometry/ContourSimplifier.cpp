@@ -0,0 +1,390 @@
+#include "ContourSimplifier.h"
+#include "SegmentSet.h"
+#include "GeometryUtil.h"
+#include "globals.h"
+
+// The ContourSimplifier simplifies a set of closed contours jointly with a
+// topology preserving variant of the Douglas Peucker algorithm. Simplifying
+// each contour independently, as cv::approxPolyDP() does, can make a contour
+// intersect itself or a neighbouring contour, and it can swallow a small
+// contour that lies in a concave bay of a larger one. The ContourSimplifier
+// guarantees that the simplified contours are simple and pairwise disjoint,
+// as long as the input contours are. Note that the contours cv::findContours()
+// extracts from a binary image are not always simple: the contour of a one pixel
+// wide part of a region runs along it twice and touches itself. Such contours
+// stay self-touching after the simplification, but they do not get any new
+// crossings.
+//
+// The algorithm works in two stages. First, every contour is simplified with
+// the Douglas Peucker recursion, but a shortcut from point i to point j is only
+// accepted if, in addition to the epsilon criterion, no foreign point lies in
+// the region that is enclosed by the original chain from i to j and the shortcut
+// (Saalfeld's criterion). Foreign points are the points of all other contours
+// and the points of the same contour outside of the chain. This keeps the
+// sidedness of all points with respect to the contours. Second, all simplified
+// edges are tested against each other for crossings, and crossing edges are
+// refined by inserting their farthest original point until no crossings remain.
+// The refinement terminates, since an edge without interior points is an edge
+// of the input.
+//
+// The contour points are integer pixel coordinates, so all orientation tests
+// are exact.
+//
+// Usage:
+//
+// ContourSimplifier simplifier; // keep as a member, the buffers are reused
+// simplifier.simplify(contours, polygons, epsilon);
+
+ContourSimplifier::ContourSimplifier()
+{
+    cellSize = 8;
+    minX = minY = 0;
+    cellsX = cellsY = 0;
+}
+
+// Simplifies the closed contours with the given epsilon (in pixels) and writes
+// the simplified polygons into polygons. The ith polygon is the simplification
+// of the ith contour, and the points are in the same order as in the contour.
+void ContourSimplifier::simplify(const std::vector<std::vector<cv::Point> > &contours, std::vector<std::vector<cv::Point> > &polygons, double epsilon)
+{
+    // Gather the contour points in one array.
+    points.clear();
+    offsets.clear();
+    for (uint c = 0; c < contours.size(); c++)
+    {
+        offsets << points.size();
+        for (uint i = 0; i < contours[c].size(); i++)
+            points << contours[c][i];
+    }
+    offsets << points.size();
+
+    keep.resize(points.size());
+    keep.fill(0);
+
+    buildGrid();
+
+    for (uint c = 0; c < contours.size(); c++)
+        simplifyContour(c, epsilon);
+
+    repairCrossings();
+
+    polygons.resize(contours.size());
+    for (uint c = 0; c < contours.size(); c++)
+    {
+        polygons[c].clear();
+        for (int i = offsets[c]; i < offsets[c+1]; i++)
+            if (keep[i])
+                polygons[c].push_back(points[i]);
+    }
+}
+
+// Sorts the points into a bucket grid for the region queries.
+void ContourSimplifier::buildGrid()
+{
+    if (points.isEmpty())
+    {
+        cellsX = cellsY = 0;
+        return;
+    }
+
+    minX = points[0].x;
+    minY = points[0].y;
+    int maxX = minX;
+    int maxY = minY;
+    for (int i = 1; i < points.size(); i++)
+    {
+        minX = min(minX, points[i].x);
+        minY = min(minY, points[i].y);
+        maxX = max(maxX, points[i].x);
+        maxY = max(maxY, points[i].y);
+    }
+    cellsX = (maxX-minX)/cellSize+1;
+    cellsY = (maxY-minY)/cellSize+1;
+
+    // Counting sort of the point indices by cell.
+    cellStart.resize(cellsX*cellsY+1);
+    cellStart.fill(0);
+    for (int i = 0; i < points.size(); i++)
+        cellStart[((points[i].y-minY)/cellSize)*cellsX+(points[i].x-minX)/cellSize+1]++;
+    for (int i = 1; i < cellStart.size(); i++)
+        cellStart[i] += cellStart[i-1];
+    cellPoints.resize(points.size());
+    for (int i = 0; i < points.size(); i++)
+    {
+        int cell = ((points[i].y-minY)/cellSize)*cellsX+(points[i].x-minX)/cellSize;
+        cellPoints[cellStart[cell]++] = i;
+    }
+    for (int i = cellStart.size()-1; i > 0; i--)
+        cellStart[i] = cellStart[i-1];
+    cellStart[0] = 0;
+}
+
+// Returns the point at position pos of contour c. Positions wrap around.
+const cv::Point &ContourSimplifier::at(int c, int pos) const
+{
+    int n = offsets[c+1]-offsets[c];
+    return points[offsets[c]+pos%n];
+}
+
+// Simplifies contour c with the constrained Douglas Peucker recursion.
+void ContourSimplifier::simplifyContour(int c, double epsilon)
+{
+    int n = offsets[c+1]-offsets[c];
+    if (n <= 3)
+    {
+        for (int i = offsets[c]; i < offsets[c+1]; i++)
+            keep[i] = 1;
+        return;
+    }
+
+    // Split the closed contour at the first point and the point farthest from it.
+    const cv::Point& p0 = points[offsets[c]];
+    int far = 1;
+    qint64 dmax = 0;
+    for (int i = 1; i < n; i++)
+    {
+        const cv::Point& p = points[offsets[c]+i];
+        qint64 d = (qint64)(p.x-p0.x)*(p.x-p0.x)+(qint64)(p.y-p0.y)*(p.y-p0.y);
+        if (d > dmax)
+        {
+            dmax = d;
+            far = i;
+        }
+    }
+
+    keep[offsets[c]] = 1;
+    keep[offsets[c]+far] = 1;
+
+    stack.clear();
+    stack << 0 << far;
+    stack << far << n;
+    while (!stack.isEmpty())
+    {
+        int j = stack.last();
+        int i = stack[stack.size()-2];
+        stack.resize(stack.size()-2);
+        if (j-i < 2)
+            continue;
+
+        double dist = 0;
+        int k = farthestPoint(c, i, j, dist);
+        if (dist > epsilon || !isSafeShortcut(c, i, j))
+        {
+            keep[offsets[c]+k%n] = 1;
+            stack << i << k;
+            stack << k << j;
+        }
+    }
+
+    // Make sure the result is a polygon and not just a line.
+    int count = 0;
+    for (int i = offsets[c]; i < offsets[c+1]; i++)
+        count += keep[i];
+    if (count < 3)
+    {
+        double dist = 0;
+        int k = farthestPoint(c, far, n, dist);
+        if (dist == 0)
+            k = farthestPoint(c, 0, far, dist);
+        keep[offsets[c]+k%n] = 1;
+    }
+}
+
+// Returns the position of the point of contour c between positions i and j
+// that is farthest from the segment between them. The distance is written into dist.
+int ContourSimplifier::farthestPoint(int c, int i, int j, double &dist) const
+{
+    const cv::Point& a = at(c, i);
+    const cv::Point& b = at(c, j);
+    double dx = b.x-a.x;
+    double dy = b.y-a.y;
+    double l2 = dx*dx+dy*dy;
+
+    int best = i+1;
+    dist = -1;
+    for (int k = i+1; k < j; k++)
+    {
+        const cv::Point& p = at(c, k);
+        double t = (l2 > 0) ? bound(0.0, ((p.x-a.x)*dx+(p.y-a.y)*dy)/l2, 1.0) : 0.0;
+        double ex = a.x+t*dx-p.x;
+        double ey = a.y+t*dy-p.y;
+        double d = ex*ex+ey*ey;
+        if (d > dist)
+        {
+            dist = d;
+            best = k;
+        }
+    }
+
+    dist = sqrt(max(dist, 0.0));
+    return best;
+}
+
+// Returns true if the chain of contour c from position i to position j can be
+// replaced by the shortcut from i to j without changing the topology, i.e. no
+// foreign point lies inside the region enclosed by the chain and the shortcut,
+// or on the shortcut itself.
+bool ContourSimplifier::isSafeShortcut(int c, int i, int j) const
+{
+    int n = offsets[c+1]-offsets[c];
+    const cv::Point& a = at(c, i);
+    const cv::Point& b = at(c, j);
+
+    // The bounding box of the chain.
+    int l = a.x, r = a.x, t = a.y, bt = a.y;
+    for (int k = i+1; k <= j; k++)
+    {
+        const cv::Point& p = at(c, k);
+        l = min(l, p.x);
+        r = max(r, p.x);
+        t = min(t, p.y);
+        bt = max(bt, p.y);
+    }
+
+    int cx0 = (l-minX)/cellSize;
+    int cx1 = (r-minX)/cellSize;
+    int cy0 = (t-minY)/cellSize;
+    int cy1 = (bt-minY)/cellSize;
+    for (int cy = cy0; cy <= cy1; cy++)
+    {
+        for (int cx = cx0; cx <= cx1; cx++)
+        {
+            int cell = cy*cellsX+cx;
+            for (int m = cellStart[cell]; m < cellStart[cell+1]; m++)
+            {
+                int g = cellPoints[m];
+                const cv::Point& p = points[g];
+                if (p.x < l || p.x > r || p.y < t || p.y > bt)
+                    continue;
+
+                // Skip the points of the chain itself.
+                if (g >= offsets[c] && g < offsets[c+1] && ((g-offsets[c])-i%n+n)%n <= j-i)
+                    continue;
+
+                // A point on the shortcut.
+                if (orientation(a, b, p) == 0
+                        && p.x >= min(a.x, b.x) && p.x <= max(a.x, b.x)
+                        && p.y >= min(a.y, b.y) && p.y <= max(a.y, b.y))
+                    return false;
+
+                // A point inside the region. Even-odd rule with an upward ray.
+                int crossings = 0;
+                for (int k = i; k <= j; k++)
+                {
+                    const cv::Point& u = at(c, k);
+                    const cv::Point& v = (k < j) ? at(c, k+1) : a;
+                    if ((u.x <= p.x) != (v.x <= p.x))
+                    {
+                        qint64 o = orientation(u, v, p);
+                        if ((v.x > u.x) ? (o < 0) : (o > 0))
+                            crossings++;
+                    }
+                }
+                if (crossings % 2 == 1)
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Tests all simplified edges against each other and refines the edges that
+// cross by keeping their farthest interior point. Repeats until no crossings
+// are left. Returns the number of refined edges.
+int ContourSimplifier::repairCrossings()
+{
+    int refined = 0;
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+
+        // Collect the edges of the simplified contours.
+        ax.clear();
+        ay.clear();
+        bx.clear();
+        by.clear();
+        edgeContour.clear();
+        edgeFrom.clear();
+        edgeTo.clear();
+        for (int c = 0; c < offsets.size()-1; c++)
+        {
+            int n = offsets[c+1]-offsets[c];
+            int first = -1;
+            int last = -1;
+            for (int i = 0; i < n; i++)
+            {
+                if (!keep[offsets[c]+i])
+                    continue;
+                if (first < 0)
+                    first = i;
+                else
+                {
+                    edgeContour << c;
+                    edgeFrom << last;
+                    edgeTo << i;
+                }
+                last = i;
+            }
+            if (first >= 0 && last != first)
+            {
+                edgeContour << c;
+                edgeFrom << last;
+                edgeTo << first+n;
+            }
+        }
+        for (int e = 0; e < edgeContour.size(); e++)
+        {
+            const cv::Point& a = at(edgeContour[e], edgeFrom[e]);
+            const cv::Point& b = at(edgeContour[e], edgeTo[e]);
+            ax << a.x;
+            ay << a.y;
+            bx << b.x;
+            by << b.y;
+        }
+
+        int m = edgeContour.size();
+        hits.resize(m);
+        params.resize(m);
+        for (int e = 0; e < m; e++)
+        {
+            // Only test against the later edges. Every pair is tested once.
+            int k = SegmentSet::intersect(ax.data()+e+1, ay.data()+e+1, bx.data()+e+1, by.data()+e+1, m-e-1,
+                                          ax[e], ay[e], bx[e], by[e], &hits[0], &params[0]);
+            if (k == 0)
+                continue;
+
+            for (int f = e+1; f < m; f++)
+            {
+                if (!hits[f-e-1])
+                    continue;
+
+                // Neighbouring edges of the same contour share an end point.
+                int c = edgeContour[e];
+                int n = offsets[c+1]-offsets[c];
+                if (edgeContour[f] == c && (edgeTo[e]%n == edgeFrom[f]%n || edgeTo[f]%n == edgeFrom[e]%n))
+                    continue;
+
+                int ids[2] = {e, f};
+                for (int q = 0; q < 2; q++)
+                {
+                    int g = ids[q];
+                    if (edgeTo[g]-edgeFrom[g] < 2)
+                        continue;
+                    double dist = 0;
+                    int p = farthestPoint(edgeContour[g], edgeFrom[g], edgeTo[g], dist);
+                    int idx = offsets[edgeContour[g]]+p%(offsets[edgeContour[g]+1]-offsets[edgeContour[g]]);
+                    if (!keep[idx])
+                    {
+                        keep[idx] = 1;
+                        changed = true;
+                        refined++;
+                    }
+                }
+            }
+        }
+    }
+
+    return refined;
+}
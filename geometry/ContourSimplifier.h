@@ -0,0 +1,41 @@
+#ifndef CONTOURSIMPLIFIER_H_
+#define CONTOURSIMPLIFIER_H_
+#include "util/Vector.h"
+#include "opencv2/imgproc/imgproc.hpp"
+
+class ContourSimplifier
+{
+    Vector<cv::Point> points; // The points of all contours.
+    Vector<int> offsets; // Index of the first point of every contour plus the end index.
+    Vector<char> keep; // Marks the points that are kept.
+    Vector<int> stack; // Work stack of the Douglas Peucker recursion.
+
+    // A bucket grid over all points for the region queries.
+    int cellSize;
+    int minX, minY, cellsX, cellsY;
+    Vector<int> cellStart;
+    Vector<int> cellPoints;
+
+    // The edges of the simplified contours.
+    Vector<double> ax, ay, bx, by;
+    Vector<int> edgeContour, edgeFrom, edgeTo;
+    Vector<uchar> hits;
+    Vector<double> params;
+
+public:
+
+    ContourSimplifier();
+    ~ContourSimplifier(){}
+
+    void simplify(const std::vector<std::vector<cv::Point> >& contours, std::vector<std::vector<cv::Point> >& polygons, double epsilon);
+
+private:
+    void buildGrid();
+    void simplifyContour(int c, double epsilon);
+    int farthestPoint(int c, int i, int j, double& dist) const;
+    bool isSafeShortcut(int c, int i, int j) const;
+    int repairCrossings();
+    const cv::Point& at(int c, int pos) const;
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef GEOMETRYUTIL_H_
+#define GEOMETRYUTIL_H_
+#include "util/Vec2.h"
+#include "globals.h"
+#include "opencv2/imgproc/imgproc.hpp"
+
+// Small geometric predicates that are shared by the geometry classes.
+
+// Returns the orientation of c with respect to the line from a to b, which is the
+// signed area of the parallelogram spanned by b-a and c-a. It is positive if c is
+// left of the line.
+inline double orientation(const Vec2& a, const Vec2& b, const Vec2& c)
+{
+    return (b.x-a.x)*(c.y-a.y)-(b.y-a.y)*(c.x-a.x);
+}
+
+// The orientation of integer pixel coordinates. It is computed in 64 bit and is exact.
+inline qint64 orientation(const cv::Point& a, const cv::Point& b, const cv::Point& c)
+{
+    return (qint64)(b.x-a.x)*(c.y-a.y)-(qint64)(b.y-a.y)*(c.x-a.x);
+}
+
+// Returns the distance of the point p to the segment ab.
+inline double pointSegmentDistance(const Vec2& p, const Vec2& a, const Vec2& b)
+{
+    double dx = b.x-a.x;
+    double dy = b.y-a.y;
+    double l2 = dx*dx+dy*dy;
+    double t = 0;
+    if (l2 > EPSILON*EPSILON)
+        t = bound(0.0, ((p.x-a.x)*dx+(p.y-a.y)*dy)/l2, 1.0);
+    double ex = a.x+t*dx-p.x;
+    double ey = a.y+t*dy-p.y;
+    return sqrt(ex*ex+ey*ey);
+}
+
+#endif
@@ -0,0 +1,285 @@
+#include "Hull.h"
+#include "GeometryUtil.h"
+#include "globals.h"
+
+// The Hull class computes convex and concave hulls of point sets without any
+// heap allocation in steady state. The points are given in a contiguous Vector
+// and the hull is written into a caller provided Vector, whose memory is reused
+// from call to call. The internal scratch buffers of a Hull object are reused
+// as well, so keep a Hull object around rather than creating one per call.
+//
+// The convex hull is computed with Andrew's monotone chain algorithm in
+// O(n log n). It works in double precision and returns the hull in ccw order
+// without duplicate or collinear points.
+//
+// The concave hull is computed with the "digging" algorithm of Park and Oh
+// (A New Concave Hull Algorithm and Concaveness Measure for n-dimensional
+// Datasets, 2012). It starts with the convex hull and repeatedly replaces an
+// edge (a,b) with the two edges (a,p) and (p,b), where p is the inner point
+// closest to the edge, as long as the edge is long compared to the distance
+// of p to the edge end points. The concavity parameter is the threshold for
+// this ratio. Large values produce a hull close to the convex hull, values
+// around 1 produce a tight hull. Digging only happens if the result remains
+// a simple polygon that contains all points, so the output is always valid.
+//
+// Usage:
+//
+// Hull hullEngine; // keep as a member
+// Vector<Vec2> hull; // keep as a member
+// hullEngine.convexHull(points, hull);
+
+Hull::Hull()
+{
+
+}
+
+// Computes the convex hull of the points and writes it into hull in ccw order.
+void Hull::convexHull(const Vector<Vec2> &points, Vector<Vec2> &hull)
+{
+    hull.clear();
+    int k = convexHullIndices(points);
+    for (int i = 0; i < k; i++)
+        hull << points[chain[i]];
+}
+
+// Computes the concave hull of the points and writes it into hull in ccw order.
+// The concavity threshold controls how deep the hull digs into the point set.
+void Hull::concaveHull(const Vector<Vec2> &points, Vector<Vec2> &hull, double concavity)
+{
+    hull.clear();
+    int n = points.size();
+    int k = convexHullIndices(points);
+    if (k < 3)
+    {
+        for (int i = 0; i < k; i++)
+            hull << points[chain[i]];
+        return;
+    }
+
+    // Link the convex hull points into a ccw loop.
+    // All other points are inner points with next = -1.
+    next.resize(n);
+    next.fill(-1);
+    edges.clear();
+    for (int i = 0; i < k; i++)
+        next[chain[i]] = chain[(i+1)%k];
+
+    // Points that lie on a convex hull edge are part of the boundary.
+    // They are linked into the loop in the order of their projection
+    // onto the edge. This is common for outlines sampled on a grid.
+    for (int i = 0; i < k; i++)
+    {
+        int a = chain[i];
+        int b = chain[(i+1)%k];
+        const Vec2& pa = points[a];
+        const Vec2& pb = points[b];
+        Vec2 d = pb-pa;
+        double l2 = d.norm2();
+        order.clear();
+        for (int j = 0; j < n; j++)
+        {
+            if (next[j] >= 0 || fabs(orientation(pa, pb, points[j])) > EPSILON*sqrt(l2))
+                continue;
+            double t = (points[j]-pa)*d;
+            if (t > EPSILON && t < l2-EPSILON)
+                order << j;
+        }
+        if (order.size() > 1)
+        {
+            std::sort(&order[0], &order[0]+order.size(), [&points, &pa](int u, int v)
+            {
+                return (points[u]-pa).norm2() < (points[v]-pa).norm2();
+            });
+        }
+        int last = a;
+        for (int j = 0; j < order.size(); j++)
+        {
+            next[last] = order[j];
+            last = order[j];
+        }
+        next[last] = b;
+    }
+
+    for (int i = 0; i < n; i++)
+        if (next[i] >= 0)
+            edges << i;
+
+    // Process the edges until none can be dug into any more.
+    while (!edges.isEmpty())
+    {
+        int a = edges.last();
+        edges.resize(edges.size()-1);
+        int b = next[a];
+        const Vec2& pa = points[a];
+        const Vec2& pb = points[b];
+
+        // Find the inner point closest to the edge. Only points
+        // inside the hull (left of the edge) are candidates.
+        int p = -1;
+        double dmin = std::numeric_limits<double>::max();
+        for (int i = 0; i < n; i++)
+        {
+            if (next[i] >= 0 || orientation(pa, pb, points[i]) <= 0)
+                continue;
+            double d = pointSegmentDistance(points[i], pa, pb);
+            if (d < dmin)
+            {
+                dmin = d;
+                p = i;
+            }
+        }
+
+        if (p < 0)
+            continue;
+
+        // The decision distance is the distance of the point to the closer edge end point.
+        double eh = (pb-pa).norm();
+        double dd = min((points[p]-pa).norm(), (points[p]-pb).norm());
+        if (dd < EPSILON || eh/dd <= concavity)
+            continue;
+
+        // The new edges must not cross the hull and no inner point
+        // must be left outside of the hull.
+        if (crossesHull(points, a, b, p))
+            continue;
+
+        next[a] = p;
+        next[p] = b;
+        edges << a;
+        edges << p;
+    }
+
+    // Walk the loop to output the hull.
+    int start = chain[0];
+    int i = start;
+    do
+    {
+        hull << points[i];
+        i = next[i];
+    } while (i != start);
+}
+
+// Computes the convex hull of n points with the monotone chain algorithm.
+// The points are sorted in place. The hull is written into the hull array,
+// which must have room for n+1 points. The number of hull points is returned.
+// This is the raw kernel for callers that manage their own arrays.
+int Hull::convexHull(Vec2 *points, int n, Vec2 *hull)
+{
+    if (n < 3)
+    {
+        for (int i = 0; i < n; i++)
+            hull[i] = points[i];
+        return n;
+    }
+
+    std::sort(points, points+n, [](const Vec2& a, const Vec2& b) {return (a.x < b.x) || (a.x == b.x && a.y < b.y);});
+
+    int k = 0;
+
+    // Lower hull.
+    for (int i = 0; i < n; i++)
+    {
+        while (k >= 2 && orientation(hull[k-2], hull[k-1], points[i]) <= 0)
+            k--;
+        hull[k++] = points[i];
+    }
+
+    // Upper hull.
+    int lower = k+1;
+    for (int i = n-2; i >= 0; i--)
+    {
+        while (k >= lower && orientation(hull[k-2], hull[k-1], points[i]) <= 0)
+            k--;
+        hull[k++] = points[i];
+    }
+
+    return k-1; // The last point is the same as the first one.
+}
+
+// Computes the convex hull with the monotone chain algorithm on point indices.
+// The ccw hull is written into the chain buffer. Returns the number of hull points.
+int Hull::convexHullIndices(const Vector<Vec2> &points)
+{
+    int n = points.size();
+    order.resize(n);
+    for (int i = 0; i < n; i++)
+        order[i] = i;
+    chain.resize(n+1);
+
+    if (n < 3)
+    {
+        for (int i = 0; i < n; i++)
+            chain[i] = i;
+        return n;
+    }
+
+    std::sort(&order[0], &order[0]+n, [&points](int a, int b)
+    {
+        return (points[a].x < points[b].x) || (points[a].x == points[b].x && points[a].y < points[b].y);
+    });
+
+    int k = 0;
+
+    // Lower hull.
+    for (int i = 0; i < n; i++)
+    {
+        while (k >= 2 && orientation(points[chain[k-2]], points[chain[k-1]], points[order[i]]) <= 0)
+            k--;
+        chain[k++] = order[i];
+    }
+
+    // Upper hull.
+    int lower = k+1;
+    for (int i = n-2; i >= 0; i--)
+    {
+        while (k >= lower && orientation(points[chain[k-2]], points[chain[k-1]], points[order[i]]) <= 0)
+            k--;
+        chain[k++] = order[i];
+    }
+
+    return k-1; // The last point is the same as the first one.
+}
+
+// Returns true if replacing the hull edge (a,b) by the edges (a,p) and (p,b)
+// would make the hull self intersecting or would leave an inner point outside.
+bool Hull::crossesHull(const Vector<Vec2> &points, int a, int b, int p) const
+{
+    const Vec2& pa = points[a];
+    const Vec2& pb = points[b];
+    const Vec2& pp = points[p];
+
+    // Inner points in the triangle (a,p,b) would end up outside or on the
+    // new edges. Points that coincide with a corner of the triangle are fine.
+    for (int i = 0; i < points.size(); i++)
+    {
+        if (next[i] >= 0 || i == p)
+            continue;
+        const Vec2& v = points[i];
+        if ((v-pa).norm2() < EPSILON*EPSILON || (v-pb).norm2() < EPSILON*EPSILON || (v-pp).norm2() < EPSILON*EPSILON)
+            continue;
+        if (orientation(pa, pp, v) <= 0 && orientation(pp, pb, v) <= 0 && orientation(pb, pa, v) <= 0)
+            return true;
+    }
+
+    // Crossings of the new edges with the other hull edges.
+    int i = b;
+    while (next[i] != a)
+    {
+        const Vec2& c = points[i];
+        const Vec2& d = points[next[i]];
+        for (int e = 0; e < 2; e++)
+        {
+            const Vec2& s = (e == 0) ? pa : pp;
+            const Vec2& t = (e == 0) ? pp : pb;
+            double o1 = orientation(s, t, c);
+            double o2 = orientation(s, t, d);
+            double o3 = orientation(c, d, s);
+            double o4 = orientation(c, d, t);
+            if (o1*o2 < 0 && o3*o4 < 0)
+                return true;
+        }
+        i = next[i];
+    }
+
+    return false;
+}
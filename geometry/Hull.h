@@ -0,0 +1,29 @@
+#ifndef HULL_H_
+#define HULL_H_
+#include "util/Vec2.h"
+#include "util/Vector.h"
+
+class Hull
+{
+    // Scratch buffers that are reused from call to call.
+    Vector<int> order; // Point indices sorted by coordinates.
+    Vector<int> chain; // Point indices of the hull.
+    Vector<int> next; // Successor of every hull point in the ccw hull loop, -1 for inner points.
+    Vector<int> edges; // Work list of hull edges given by their start point.
+
+public:
+
+    Hull();
+    ~Hull(){}
+
+    void convexHull(const Vector<Vec2>& points, Vector<Vec2>& hull);
+    void concaveHull(const Vector<Vec2>& points, Vector<Vec2>& hull, double concavity = 2.0);
+
+    static int convexHull(Vec2* points, int n, Vec2* hull);
+
+private:
+    int convexHullIndices(const Vector<Vec2>& points);
+    bool crossesHull(const Vector<Vec2>& points, int a, int b, int p) const;
+};
+
+#endif
@@ -3,9 +3,12 @@
 #include "blackboard/Config.h"
 #include "blackboard/State.h"
 #include "Box.h"
+#include "SegmentSet.h"
+#include "Hull.h"
 #include "util/ColorUtil.h"
-#include "opencv2/imgproc/imgproc.hpp"
+#ifndef HEADLESS
 #include <GL/glu.h>
+#endif
 
 // The Polygon class is a general purpose polygon that consists of a number
 // of vertices and a 2D transform given by a translation (x,y) and a rotation
@@ -302,91 +305,51 @@ Polygon Polygon::convexHull() const
     if (vertices.isEmpty())
         return Polygon();
 
-    std::vector<cv::Point2f> pol;
+    static thread_local Hull hull;
+    static thread_local Vector<Vec2> points;
+    static thread_local Vector<Vec2> chPoints;
+    points.clear();
     ListIterator<Vec2> it = vertices.begin();
     while (it.hasNext())
-    {
-        Vec2& v = it.next();
-        pol.push_back(cv::Point2f(v.x, v.y));
-    }
+        points << it.next();
 
-    std::vector<cv::Point2f> chPoints;
-    cv::convexHull(pol, chPoints);
+    hull.convexHull(points, chPoints);
 
     Polygon ch;
     for (int i = 0; i < chPoints.size(); i++)
-        ch << Vec2(chPoints[i].x, chPoints[i].y);
+        ch << chPoints[i];
     ch.setPos(pos());
     ch.setRotation(rotation());
 
     return ch;
 }
 
-// Computes and returns the non-convex hull of this polygon.
+// Computes and returns the non-convex (concave) hull of this polygon.
 // The points do not have to be in a counter clockwise order to
 // compute the non-convex hull, but the returned non-convex hull
-// is a valid polygon in ccw order. The non-convex hull is given
-// in local coordinates (untransformed), and it has the same
-// transform as this polygon.
-Polygon Polygon::nonConvexHull() const
+// is a valid polygon in ccw order. The concavity parameter controls
+// how deep the hull follows the points into concave regions. See
+// the Hull class for details. The non-convex hull is given in local
+// coordinates (untransformed), and it has the same transform as
+// this polygon.
+Polygon Polygon::nonConvexHull(double concavity) const
 {
     if (vertices.isEmpty())
         return Polygon();
 
-    // Find the leftmost and rightmost points in x direction.
-    ListIterator<Vec2> it = vertexIterator();
-    Vec2 min = it.next();
-    Vec2 max = min;
+    static thread_local Hull hull;
+    static thread_local Vector<Vec2> points;
+    static thread_local Vector<Vec2> chPoints;
+    points.clear();
+    ListIterator<Vec2> it = vertices.begin();
     while (it.hasNext())
-    {
-        Vec2& v = it.next();
-        if (v.x < min.x)
-            min = v;
-        if (v.x > max.x)
-            max = v;
-    }
-
-    // The max-min vector will divide the set of vertices into an upper and lower half.
-    Vec2 divider = max-min;
-
-    // Sort the vertices by their x coordinate.
-    LinkedList<Vec2> V = getVertices();
-    V.sort();
-
-    // Iterate through the sorted points and add them to the upper or lower chain.
-    double thresh = PI2;
-    LinkedList<Vec2> upper;
-    LinkedList<Vec2> lower;
-    while (V.hasNext())
-    {
-        Vec2& v = V.next();
-        if (v.isLeftOf(divider))
-        {
-            Vec2 v1 = upper.end().prev();
-            Vec2 v2 = upper.last();
-            Vec2 v3 = v;
-            if ((v2-v1).angleTo(v3-v2) > thresh)
-                upper.pop();
-            upper << v;
-        }
-        else
-        {
-            Vec2 v1 = lower.end().prev();
-            Vec2 v2 = lower.last();
-            Vec2 v3 = v;
-            if ((v2-v1).angleTo(v3-v2) < -thresh)
-                lower.pop();
-            lower << v;
-        }
-    }
+        points << it.next();
 
-    upper.reverse();
+    hull.concaveHull(points, chPoints, concavity);
 
     Polygon p;
-    while (upper.hasNext())
-        p << upper.next();
-    while (lower.hasNext())
-        p << lower.next();
+    for (int i = 0; i < chPoints.size(); i++)
+        p << chPoints[i];
     p.setPos(pos());
     p.setRotation(rotation());
     return p;
@@ -651,6 +614,7 @@ bool Polygon::intersects(const Polygon &p) const
 // This is an edge intersection test only that will not detect containment.
 // There are no requirements on the polygon. It does not have to be convex.
 // The vertex order is not relevant, and it can be transformed or untransformed.
+// A line that touches an edge or passes through a vertex counts as intersecting.
 bool Polygon::intersects(Line l) const
 {
     //qDebug() << "-------- Collision Checking Line" << l << "with:" << *this;
@@ -663,22 +627,33 @@ bool Polygon::intersects(Line l) const
     l.translate(-pos());
     l.rotate(-theta);
 
-    // full edge check.
-    Line edge;
+    // Gather the edges in SoA layout and run the segment intersection kernel.
+    int n = size();
+    if (n == 0)
+        return false;
+    static thread_local Vector<double> ax, ay, bx, by, t;
+    static thread_local Vector<uchar> hits;
+    ax.resize(n);
+    ay.resize(n);
+    bx.resize(n);
+    by.resize(n);
+    t.resize(n);
+    hits.resize(n);
+    int i = 0;
     ListIterator<Vec2> it = vertices.begin();
     while (it.hasNext())
     {
         Vec2& v1 = it.peekCur();
         Vec2& v2 = it.peekNext();
         it.next();
-
-        edge.set(v1.x, v1.y, v2.x, v2.y);
-        //qDebug() << edge.intersects(l) << edge;
-        if (edge.intersects(l))
-            return true;
+        ax[i] = v1.x;
+        ay[i] = v1.y;
+        bx[i] = v2.x;
+        by[i] = v2.y;
+        i++;
     }
 
-    return false;
+    return (SegmentSet::intersect(&ax[0], &ay[0], &bx[0], &by[0], n, l.x1, l.y1, l.x2, l.y2, &hits[0], &t[0]) > 0);
 }
 
 // Returns true if the polygon contains the point. It will return true for a point
@@ -723,27 +698,31 @@ bool Polygon::intersects(Vec2 v) const
         // A point intersection test with a non-convex polygon is just as easy.
         // Take a random half-line starting at the point and intersect it with every edge
         // of the polygon. Is the number of intersections odd, then the point lies inside
-        // the polygon. Otherwise it lies outside.
-
-        // Create a vertical half line starting at the point v.
-        Line vertical;
-        vertical.set(v.x, v.y, v.x, std::numeric_limits<double>::max());
-
-        // Count the number of intersections.
-        Line l;
-        int ctr = 0;
+        // the polygon. Otherwise it lies outside. We use a vertical half line and count
+        // the crossings with the crossing number kernel of the SegmentSet.
+        int n = size();
+        if (n == 0)
+            return false;
+        static thread_local Vector<double> ax, ay, bx, by;
+        ax.resize(n);
+        ay.resize(n);
+        bx.resize(n);
+        by.resize(n);
+        int i = 0;
         ListIterator<Vec2> it = vertices.begin();
         while (it.hasNext())
         {
             Vec2& v1 = it.peekCur();
             Vec2& v2 = it.peekNext();
-            l.set(v1, v2);
-            if (l.intersects(vertical)) // strict
-                ctr++;
             it.next();
+            ax[i] = v1.x;
+            ay[i] = v1.y;
+            bx[i] = v2.x;
+            by[i] = v2.y;
+            i++;
         }
 
-        return (ctr%2);
+        return (SegmentSet::crossings(&ax[0], &ay[0], &bx[0], &by[0], n, v.x, v.y)%2);
     }
 
     return true;
@@ -762,6 +741,7 @@ void Polygon::draw(QPainter *painter) const
 // Draws the polygon in an OpenGL context.
 void Polygon::draw() const
 {
+#ifndef HEADLESS
     glBegin(GL_LINE_LOOP);
     ListIterator<Vec2> it2 = vertexIterator();
     while (it2.hasNext())
@@ -770,6 +750,7 @@ void Polygon::draw() const
         glVertex3f(v.x, v.y, 0.005);
     }
     glEnd();
+#endif
 }
 
 // This method is used by the Qt graphics view framework.
@@ -58,7 +58,7 @@ public:
     ListIterator<Vec2> vertexIterator() const;
     virtual const Box& boundingBox() const;
     Polygon convexHull() const;
-    Polygon nonConvexHull() const;
+    Polygon nonConvexHull(double concavity = 2.0) const;
     LinkedList<Polygon> triangulate() const;
 
     double diameter() const;
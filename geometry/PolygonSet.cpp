@@ -0,0 +1,400 @@
+#include "PolygonSet.h"
+#include "globals.h"
+#include <cstring>
+
+// The PolygonSet is a flat container for a set of polygons in world coordinates.
+// Instead of one heap allocated linked list per polygon, all vertices are stored
+// in one contiguous array of interleaved x,y coordinates. An offsets array marks
+// where each polygon begins, and a bounds array holds the bounding box of every
+// polygon. Clearing and refilling the set does not allocate memory once the
+// arrays have grown to their working size, and copying the set copies three
+// arrays rather than thousands of list nodes.
+//
+// The vertices are stored in ccw order, just like the vertices of a Polygon.
+// There is no transform, all coordinates are world coordinates.
+//
+// The set can be serialized into a stable binary layout that is suitable for
+// shared memory or files:
+//
+// PolygonSetHeader                  16 bytes
+// quint32 offsets[numPolygons+1]    padded to a multiple of 8 bytes
+// PolygonBounds bounds[numPolygons] 4 doubles t,l,b,r each
+// double vertices[2*numVertices]    interleaved x,y
+//
+// All values are in host byte order. A PolygonSetView can be created on top of
+// such a buffer with PolygonSetView::fromBuffer() without copying anything.
+//
+// Usage:
+//
+// PolygonSet set;
+// set.beginPolygon();
+// set.addVertex(0, 0);
+// set.addVertex(1, 0);
+// set.addVertex(0, 1);
+// set.endPolygon();
+// PolygonSetView view = set.view();
+// for (int i = 0; i < view.size(); i++)
+//     for (int j = 0; j < view.size(i); j++)
+//         Vec2 v = view.vertex(i, j);
+
+// Returns the size in bytes of the offsets section including the padding.
+static inline int offsetsBytes(int numPolygons)
+{
+    return (((numPolygons+1)*sizeof(quint32)+7)/8)*8;
+}
+
+PolygonSetView::PolygonSetView()
+{
+    offs = 0;
+    bnds = 0;
+    verts = 0;
+    np = 0;
+}
+
+PolygonSetView::PolygonSetView(const quint32 *offsets, const PolygonBounds *bounds, const double *vertices, int numPolygons)
+{
+    offs = offsets;
+    bnds = bounds;
+    verts = vertices;
+    np = numPolygons;
+}
+
+// Returns true if the view points to a polygon set.
+bool PolygonSetView::isValid() const
+{
+    return (offs != 0);
+}
+
+// Returns the number of polygons.
+int PolygonSetView::size() const
+{
+    return np;
+}
+
+// Returns the total number of vertices of all polygons.
+int PolygonSetView::numVertices() const
+{
+    return (offs == 0) ? 0 : offs[np];
+}
+
+// Returns the number of vertices of the ith polygon.
+int PolygonSetView::size(int i) const
+{
+    return offs[i+1]-offs[i];
+}
+
+// Returns a pointer to the interleaved x,y coordinates of the ith polygon.
+const double *PolygonSetView::vertices(int i) const
+{
+    return verts+2*offs[i];
+}
+
+// Returns the jth vertex of the ith polygon.
+Vec2 PolygonSetView::vertex(int i, int j) const
+{
+    const double* v = verts+2*(offs[i]+j);
+    return Vec2(v[0], v[1]);
+}
+
+// Returns the bounding box of the ith polygon.
+const PolygonBounds &PolygonSetView::bounds(int i) const
+{
+    return bnds[i];
+}
+
+// Returns the offsets array (numPolygons+1 entries).
+const quint32 *PolygonSetView::offsets() const
+{
+    return offs;
+}
+
+// Returns the interleaved x,y coordinates of all vertices.
+const double *PolygonSetView::vertices() const
+{
+    return verts;
+}
+
+// Converts the ith polygon into a Polygon object.
+Polygon PolygonSetView::polygon(int i) const
+{
+    Polygon pol;
+    const double* v = vertices(i);
+    for (int j = 0; j < size(i); j++)
+        pol << Vec2(v[2*j], v[2*j+1]);
+    return pol;
+}
+
+// Creates a view on top of a serialized polygon set, for example in shared memory.
+// The buffer must be 8 byte aligned and must stay alive as long as the view is used.
+// If the buffer does not contain a valid polygon set, an invalid view is returned.
+PolygonSetView PolygonSetView::fromBuffer(const void *buffer, int bytes)
+{
+    if (buffer == 0 || bytes < (int)sizeof(PolygonSetHeader) || ((quint64)buffer)%8 != 0)
+        return PolygonSetView();
+
+    const PolygonSetHeader* header = (const PolygonSetHeader*)buffer;
+    if (header->magic != PolygonSet::MAGIC || header->version != PolygonSet::VERSION)
+    {
+        qDebug() << "PolygonSetView::fromBuffer(): invalid header" << header->magic << header->version;
+        return PolygonSetView();
+    }
+
+    // The counts come from untrusted data, so the required size is computed in 64 bit.
+    // It cannot overflow, since both counts are 32 bit.
+    quint64 np = header->numPolygons;
+    quint64 nv = header->numVertices;
+    quint64 required = sizeof(PolygonSetHeader) + (((np+1)*sizeof(quint32)+7)/8)*8
+            + np*sizeof(PolygonBounds) + 2*nv*sizeof(double);
+    if ((quint64)bytes < required)
+    {
+        qDebug() << "PolygonSetView::fromBuffer(): buffer too small" << bytes << "<" << required;
+        return PolygonSetView();
+    }
+
+    const char* p = (const char*)buffer + sizeof(PolygonSetHeader);
+    const quint32* offsets = (const quint32*)p;
+    p += offsetsBytes(np);
+
+    // The offsets must start at 0, must not decrease, and must end at the number of
+    // vertices, or the accessors would read outside of the buffer.
+    if (offsets[0] != 0 || offsets[np] != nv)
+    {
+        qDebug() << "PolygonSetView::fromBuffer(): invalid offsets" << offsets[0] << offsets[np] << nv;
+        return PolygonSetView();
+    }
+    for (quint64 i = 0; i < np; i++)
+    {
+        if (offsets[i] > offsets[i+1])
+        {
+            qDebug() << "PolygonSetView::fromBuffer(): decreasing offsets at polygon" << i;
+            return PolygonSetView();
+        }
+    }
+    const PolygonBounds* bounds = (const PolygonBounds*)p;
+    p += np*sizeof(PolygonBounds);
+    const double* vertices = (const double*)p;
+
+    return PolygonSetView(offsets, bounds, vertices, np);
+}
+
+PolygonSet::PolygonSet()
+{
+    offsets << 0;
+}
+
+// Removes all polygons. Allocated memory is preserved.
+void PolygonSet::clear()
+{
+    vertices.clear();
+    offsets.clear();
+    bounds.clear();
+    offsets << 0;
+}
+
+// Reserves memory for the given number of polygons and vertices.
+void PolygonSet::reserve(int numPolygons, int numVertices)
+{
+    vertices.reserve(2*numVertices);
+    offsets.reserve(numPolygons+1);
+    bounds.reserve(numPolygons);
+}
+
+// Returns the number of polygons.
+int PolygonSet::size() const
+{
+    return bounds.size();
+}
+
+// Returns the total number of vertices of all polygons.
+int PolygonSet::numVertices() const
+{
+    return vertices.size()/2;
+}
+
+// Starts a new polygon. Add the vertices with addVertex() in ccw order
+// and finish the polygon with endPolygon().
+void PolygonSet::beginPolygon()
+{
+    PolygonBounds b;
+    b.t = -std::numeric_limits<double>::max();
+    b.l = std::numeric_limits<double>::max();
+    b.b = std::numeric_limits<double>::max();
+    b.r = -std::numeric_limits<double>::max();
+    bounds << b;
+}
+
+// Adds a vertex to the current polygon.
+void PolygonSet::addVertex(double x, double y)
+{
+    vertices << x;
+    vertices << y;
+    PolygonBounds& b = bounds.last();
+    b.t = max(b.t, y);
+    b.l = min(b.l, x);
+    b.b = min(b.b, y);
+    b.r = max(b.r, x);
+}
+
+// Finishes the current polygon.
+void PolygonSet::endPolygon()
+{
+    offsets << vertices.size()/2;
+}
+
+// Adds a polygon. The transform of the polygon is applied to the vertices.
+void PolygonSet::add(const Polygon &pol)
+{
+    double c = cos(pol.theta);
+    double s = sin(pol.theta);
+    beginPolygon();
+    ListIterator<Vec2> it = pol.vertexIterator();
+    while (it.hasNext())
+    {
+        const Vec2& v = it.next();
+        addVertex(pol.x + c*v.x - s*v.y, pol.y + s*v.x + c*v.y);
+    }
+    endPolygon();
+}
+
+// Adds all polygons.
+void PolygonSet::add(const Vector<Polygon> &pols)
+{
+    for (int i = 0; i < pols.size(); i++)
+        add(pols[i]);
+}
+
+// Returns a read only view of the polygon set. The view is invalidated
+// when polygons are added to the set.
+PolygonSetView PolygonSet::view() const
+{
+    if (bounds.isEmpty())
+        return PolygonSetView(offsets.data(), 0, 0, 0);
+    return PolygonSetView(offsets.data(), bounds.data(), vertices.data(), size());
+}
+
+// Converts the ith polygon into a Polygon object.
+Polygon PolygonSet::polygon(int i) const
+{
+    return view().polygon(i);
+}
+
+// Converts all polygons into Polygon objects.
+void PolygonSet::toPolygons(Vector<Polygon> &pols) const
+{
+    pols.clear();
+    for (int i = 0; i < size(); i++)
+        pols << polygon(i);
+}
+
+// Returns the number of bytes needed to serialize the polygon set.
+int PolygonSet::byteSize() const
+{
+    return sizeof(PolygonSetHeader) + offsetsBytes(size()) + size()*sizeof(PolygonBounds) + vertices.size()*sizeof(double);
+}
+
+// Writes the polygon set into the buffer in the binary layout described above.
+// The buffer must be 8 byte aligned and at least byteSize() bytes large.
+// Returns the number of bytes written, or 0 if the buffer is too small.
+int PolygonSet::serialize(void *buffer, int bytes) const
+{
+    int required = byteSize();
+    if (bytes < required)
+    {
+        qDebug() << "PolygonSet::serialize(): buffer too small" << bytes << "<" << required;
+        return 0;
+    }
+
+    char* p = (char*)buffer;
+    PolygonSetHeader* header = (PolygonSetHeader*)p;
+    header->magic = MAGIC;
+    header->version = VERSION;
+    header->numPolygons = size();
+    header->numVertices = numVertices();
+    p += sizeof(PolygonSetHeader);
+
+    memset(p, 0, offsetsBytes(size()));
+    memcpy(p, offsets.data(), offsets.size()*sizeof(quint32));
+    p += offsetsBytes(size());
+
+    if (size() > 0)
+    {
+        memcpy(p, bounds.data(), size()*sizeof(PolygonBounds));
+        p += size()*sizeof(PolygonBounds);
+        memcpy(p, vertices.data(), vertices.size()*sizeof(double));
+    }
+
+    return required;
+}
+
+// Reads the polygon set from a buffer that was written with serialize().
+// Returns false if the buffer does not contain a valid polygon set.
+bool PolygonSet::deserialize(const void *buffer, int bytes)
+{
+    PolygonSetView v = PolygonSetView::fromBuffer(buffer, bytes);
+    if (!v.isValid())
+        return false;
+
+    int np = v.size();
+    int nv = v.numVertices();
+    offsets.resize(np+1);
+    bounds.resize(np);
+    vertices.resize(2*nv);
+    memcpy(&offsets[0], v.offsets(), (np+1)*sizeof(quint32));
+    if (np > 0)
+    {
+        memcpy(&bounds[0], &v.bounds(0), np*sizeof(PolygonBounds));
+        memcpy(&vertices[0], v.vertices(), 2*nv*sizeof(double));
+    }
+
+    return true;
+}
+
+// Writes the polygon set into a data stream in the binary layout.
+void PolygonSet::streamOut(QDataStream &out) const
+{
+    int bytes = byteSize();
+    Vector<quint64> buffer((bytes+7)/8); // 8 byte aligned
+    serialize(&buffer[0], bytes);
+    out << (qint32)bytes;
+    out.writeRawData((const char*)buffer.data(), bytes);
+}
+
+// Reads the polygon set from a data stream.
+void PolygonSet::streamIn(QDataStream &in)
+{
+    qint32 bytes = 0;
+    in >> bytes;
+    if (bytes <= 0)
+    {
+        clear();
+        return;
+    }
+    Vector<quint64> buffer((bytes+7)/8); // 8 byte aligned
+    if (in.readRawData((char*)&buffer[0], bytes) != bytes || !deserialize(buffer.data(), bytes))
+        clear();
+}
+
+QDataStream& operator<<(QDataStream& out, const PolygonSet &o)
+{
+    o.streamOut(out);
+    return out;
+}
+
+QDataStream& operator>>(QDataStream& in, PolygonSet &o)
+{
+    o.streamIn(in);
+    return in;
+}
+
+QDebug operator<<(QDebug dbg, const PolygonSet &o)
+{
+    PolygonSetView v = o.view();
+    dbg << "polygons:" << v.size() << "vertices:" << v.numVertices();
+    for (int i = 0; i < v.size(); i++)
+    {
+        dbg << "\n[" << i << "]";
+        for (int j = 0; j < v.size(i); j++)
+            dbg << v.vertex(i, j);
+    }
+    return dbg;
+}
@@ -0,0 +1,93 @@
+#ifndef POLYGONSET_H_
+#define POLYGONSET_H_
+#include "util/Vec2.h"
+#include "util/Vector.h"
+#include "geometry/Polygon.h"
+
+// The binary header of a serialized PolygonSet.
+struct PolygonSetHeader
+{
+    quint32 magic;
+    quint32 version;
+    quint32 numPolygons;
+    quint32 numVertices;
+};
+
+// The axis aligned bounding box of a polygon in world coordinates.
+struct PolygonBounds
+{
+    double t, l, b, r;
+};
+
+// A read only view of a flat polygon set. It does not own the memory it
+// points to. It can point into a PolygonSet or into a serialized buffer,
+// for example in shared memory.
+class PolygonSetView
+{
+    const quint32* offs;
+    const PolygonBounds* bnds;
+    const double* verts;
+    int np;
+
+public:
+
+    PolygonSetView();
+    PolygonSetView(const quint32* offsets, const PolygonBounds* bounds, const double* vertices, int numPolygons);
+    ~PolygonSetView(){}
+
+    bool isValid() const;
+    int size() const;
+    int numVertices() const;
+    int size(int i) const;
+    const double* vertices(int i) const;
+    Vec2 vertex(int i, int j) const;
+    const PolygonBounds& bounds(int i) const;
+    const quint32* offsets() const;
+    const double* vertices() const;
+    Polygon polygon(int i) const;
+
+    static PolygonSetView fromBuffer(const void* buffer, int bytes);
+};
+
+class PolygonSet
+{
+    Vector<double> vertices; // Interleaved x,y vertex coordinates of all polygons.
+    Vector<quint32> offsets; // Index of the first vertex of every polygon plus the end index.
+    Vector<PolygonBounds> bounds; // The bounding box of every polygon.
+
+public:
+
+    static const quint32 MAGIC = 0x534c4f50; // "POLS"
+    static const quint32 VERSION = 1;
+
+    PolygonSet();
+    ~PolygonSet(){}
+
+    void clear();
+    void reserve(int numPolygons, int numVertices);
+    int size() const;
+    int numVertices() const;
+
+    void beginPolygon();
+    void addVertex(double x, double y);
+    void endPolygon();
+    void add(const Polygon& pol);
+    void add(const Vector<Polygon>& pols);
+
+    PolygonSetView view() const;
+    Polygon polygon(int i) const;
+    void toPolygons(Vector<Polygon>& pols) const;
+
+    int byteSize() const;
+    int serialize(void* buffer, int bytes) const;
+    bool deserialize(const void* buffer, int bytes);
+
+    void streamOut(QDataStream& out) const;
+    void streamIn(QDataStream& in);
+};
+
+QDebug operator<<(QDebug dbg, const PolygonSet &o);
+QDataStream& operator<<(QDataStream& out, const PolygonSet &o);
+QDataStream& operator>>(QDataStream& in, PolygonSet &o);
+
+#endif
@@ -0,0 +1,251 @@
+#include "SegmentSet.h"
+#include "globals.h"
+
+// The SegmentSet holds a batch of line segments in a structure of arrays layout,
+// i.e. one contiguous array per end point coordinate, and intersects them all at
+// once with a query segment. This is the workhorse for ray casting against the
+// polygon set and for edge crossing tests. The kernel loops are free of branches
+// so that the compiler can vectorize them, and the intersection test is based on
+// orientation (cross product) signs rather than on the slope and offset form of
+// the Line class, which needs special cases for vertical lines and becomes
+// numerically fragile close to them.
+//
+// The kernels are static functions that work on plain arrays, so that they can
+// be used on any SoA data. The member functions wrap them for the data held in
+// the SegmentSet. Usage:
+//
+// SegmentSet segments;
+// segments.add(state.stablePolygons);
+// int k = segments.intersect(a, b); // k segments are hit
+// const Vector<uchar>& mask = segments.hitMask(); // which ones
+// const Vector<double>& t = segments.hitParams(); // where along ab
+// double d = segments.castRay(p, dir, 5.0); // distance to the first hit
+
+SegmentSet::SegmentSet()
+{
+
+}
+
+// Removes all segments. Allocated memory is preserved.
+void SegmentSet::clear()
+{
+    ax.clear();
+    ay.clear();
+    bx.clear();
+    by.clear();
+    ids.clear();
+}
+
+// Reserves memory for n segments.
+void SegmentSet::reserve(int n)
+{
+    ax.reserve(n);
+    ay.reserve(n);
+    bx.reserve(n);
+    by.reserve(n);
+    ids.reserve(n);
+    hits.reserve(n);
+    params.reserve(n);
+}
+
+// Returns the number of segments in the set.
+int SegmentSet::size() const
+{
+    return ax.size();
+}
+
+// Adds the segment from a to b with an optional id.
+void SegmentSet::add(const Vec2 &a, const Vec2 &b, int id)
+{
+    ax << a.x;
+    ay << a.y;
+    bx << b.x;
+    by << b.y;
+    ids << id;
+}
+
+// Adds the edges of the polygon in world coordinates.
+// All edges receive the given id.
+void SegmentSet::add(const Polygon &pol, int id)
+{
+    if (pol.size() < 2)
+        return;
+
+    double c = cos(pol.theta);
+    double s = sin(pol.theta);
+    ListIterator<Vec2> it = pol.vertexIterator();
+    while (it.hasNext())
+    {
+        const Vec2& v1 = it.peekCur();
+        const Vec2& v2 = it.peekNext();
+        it.next();
+        ax << pol.x + c*v1.x - s*v1.y;
+        ay << pol.y + s*v1.x + c*v1.y;
+        bx << pol.x + c*v2.x - s*v2.y;
+        by << pol.y + s*v2.x + c*v2.y;
+        ids << id;
+    }
+}
+
+// Adds the edges of all polygons. The id of an edge is the index of its polygon.
+void SegmentSet::add(const Vector<Polygon> &pols)
+{
+    for (int i = 0; i < pols.size(); i++)
+        add(pols[i], i);
+}
+
+// Returns the first end point of segment i.
+Vec2 SegmentSet::p1(int i) const
+{
+    return Vec2(ax[i], ay[i]);
+}
+
+// Returns the second end point of segment i.
+Vec2 SegmentSet::p2(int i) const
+{
+    return Vec2(bx[i], by[i]);
+}
+
+// Returns the id of segment i.
+int SegmentSet::id(int i) const
+{
+    return ids[i];
+}
+
+// Intersects the segment from a to b with all segments of the set and returns
+// the number of segments that are hit. The hit mask and the intersection
+// parameters along ab are available with hitMask() and hitParams() afterwards.
+int SegmentSet::intersect(const Vec2 &a, const Vec2 &b) const
+{
+    int n = size();
+    hits.resize(n);
+    params.resize(n);
+    if (n == 0)
+        return 0;
+    return intersect(ax.data(), ay.data(), bx.data(), by.data(), n, a.x, a.y, b.x, b.y, &hits[0], &params[0]);
+}
+
+// Returns the hit mask of the last intersect() call.
+// hitMask()[i] is 1 if segment i was hit and 0 otherwise.
+const Vector<uchar> &SegmentSet::hitMask() const
+{
+    return hits;
+}
+
+// Returns the intersection parameters of the last intersect() call.
+// For a hit segment i, a+hitParams()[i]*(b-a) is the intersection point.
+const Vector<double> &SegmentSet::hitParams() const
+{
+    return params;
+}
+
+// Returns true if the segment from a to b touches any segment of the set.
+bool SegmentSet::intersects(const Vec2 &a, const Vec2 &b) const
+{
+    return (intersect(a, b) > 0);
+}
+
+// Casts a ray from the origin into the given direction and returns the distance
+// to the first segment that is hit, or -1 if no segment is hit within the range.
+// If hitId is given, the id of the hit segment is written into it.
+double SegmentSet::castRay(const Vec2 &origin, const Vec2 &direction, double range, int* hitId) const
+{
+    Vec2 d = direction;
+    d.normalize(range);
+    if (intersect(origin, origin+d) == 0)
+        return -1;
+
+    double tmin = 2;
+    int imin = -1;
+    for (int i = 0; i < hits.size(); i++)
+    {
+        if (hits[i] && params[i] < tmin)
+        {
+            tmin = params[i];
+            imin = i;
+        }
+    }
+
+    if (hitId != 0)
+        *hitId = ids[imin];
+    return tmin*range;
+}
+
+// Returns the number of segments that are crossed by a vertical half line that
+// starts at p and extends upwards. The point is inside a closed polygon, whose
+// edges are in this set, if the number is odd.
+int SegmentSet::crossings(const Vec2 &p) const
+{
+    if (size() == 0)
+        return 0;
+    return crossings(ax.data(), ay.data(), bx.data(), by.data(), size(), p.x, p.y);
+}
+
+// The segment intersection kernel. It intersects the query segment q from (qax,qay)
+// to (qbx,qby) with the n segments given by the arrays ax, ay, bx, by and writes a
+// hit mask into hits and the intersection parameter along the query into t.
+// Segments that only touch the query count as hits. Collinear segments hit if they
+// overlap. For those, t is the first point of the overlap. The number of hits is returned.
+int SegmentSet::intersect(const double* __restrict ax, const double* __restrict ay,
+                          const double* __restrict bx, const double* __restrict by, int n,
+                          double qax, double qay, double qbx, double qby,
+                          uchar* __restrict hits, double* __restrict t)
+{
+    double qdx = qbx-qax;
+    double qdy = qby-qay;
+    double qminx = min(qax, qbx);
+    double qmaxx = max(qax, qbx);
+    double qminy = min(qay, qby);
+    double qmaxy = max(qay, qby);
+    double qlen2 = max(qdx*qdx+qdy*qdy, EPSILON*EPSILON);
+
+    int count = 0;
+    for (int i = 0; i < n; i++)
+    {
+        double sdx = bx[i]-ax[i];
+        double sdy = by[i]-ay[i];
+
+        // Orientations of the segment end points with respect to the query
+        // and of the query end points with respect to the segment.
+        double o1 = qdx*(ay[i]-qay) - qdy*(ax[i]-qax);
+        double o2 = qdx*(by[i]-qay) - qdy*(bx[i]-qax);
+        double o3 = sdx*(qay-ay[i]) - sdy*(qax-ax[i]);
+        double o4 = sdx*(qby-ay[i]) - sdy*(qbx-ax[i]);
+
+        // The bounding box overlap only matters for collinear segments.
+        bool overlap = (min(ax[i], bx[i]) <= qmaxx) & (max(ax[i], bx[i]) >= qminx)
+                     & (min(ay[i], by[i]) <= qmaxy) & (max(ay[i], by[i]) >= qminy);
+        bool hit = (o1*o2 <= 0) & (o3*o4 <= 0) & overlap;
+
+        // The orientation with respect to the segment changes linearly along the
+        // query, which gives the intersection parameter. Collinear segments are
+        // projected onto the query instead.
+        double den = o3-o4;
+        double ta = ((ax[i]-qax)*qdx + (ay[i]-qay)*qdy)/qlen2;
+        double tb = ((bx[i]-qax)*qdx + (by[i]-qay)*qdy)/qlen2;
+        hits[i] = hit;
+        t[i] = (den != 0) ? o3/den : max(0.0, min(ta, tb));
+        count += hit;
+    }
+
+    return count;
+}
+
+// The crossing number kernel. It counts how many of the n segments given by the
+// arrays ax, ay, bx, by are crossed by the vertical half line that starts at
+// (px,py) and extends upwards. The half open rule (ax <= px < bx) makes sure that
+// the half line passing exactly through a vertex is counted only once.
+int SegmentSet::crossings(const double* __restrict ax, const double* __restrict ay,
+                          const double* __restrict bx, const double* __restrict by, int n,
+                          double px, double py)
+{
+    int count = 0;
+    for (int i = 0; i < n; i++)
+    {
+        bool spans = (ax[i] > px) != (bx[i] > px);
+        double o = (bx[i]-ax[i])*(py-ay[i]) - (by[i]-ay[i])*(px-ax[i]);
+        bool above = (o < 0) == (ax[i] < bx[i]); // The edge passes above p.
+        count += spans & above;
+    }
+    return count;
+}
@@ -0,0 +1,47 @@
+#ifndef SEGMENTSET_H_
+#define SEGMENTSET_H_
+#include "util/Vec2.h"
+#include "util/Vector.h"
+#include "geometry/Polygon.h"
+
+class SegmentSet
+{
+    // The end points of the segments in structure of arrays layout.
+    Vector<double> ax, ay, bx, by;
+    Vector<int> ids; // A user defined id per segment, e.g. the index of the polygon.
+
+    // Output buffers of the kernel.
+    mutable Vector<uchar> hits;
+    mutable Vector<double> params;
+
+public:
+
+    SegmentSet();
+    ~SegmentSet(){}
+
+    void clear();
+    void reserve(int n);
+    int size() const;
+
+    void add(const Vec2& a, const Vec2& b, int id = -1);
+    void add(const Polygon& pol, int id = -1);
+    void add(const Vector<Polygon>& pols);
+
+    Vec2 p1(int i) const;
+    Vec2 p2(int i) const;
+    int id(int i) const;
+
+    int intersect(const Vec2& a, const Vec2& b) const;
+    const Vector<uchar>& hitMask() const;
+    const Vector<double>& hitParams() const;
+    bool intersects(const Vec2& a, const Vec2& b) const;
+    double castRay(const Vec2& origin, const Vec2& direction, double range, int* hitId = 0) const;
+    int crossings(const Vec2& p) const;
+
+    static int intersect(const double* ax, const double* ay, const double* bx, const double* by, int n,
+                         double qax, double qay, double qbx, double qby, uchar* hits, double* t);
+    static int crossings(const double* ax, const double* ay, const double* bx, const double* by, int n,
+                         double px, double py);
+};
+
+#endif
@@ -0,0 +1,220 @@
+#include "SweepAndPrune.h"
+#include "globals.h"
+
+// The SweepAndPrune class is a broadphase for collision checks between two
+// sets of polygons, for example a set of candidate robot footprints (group 0)
+// and the obstacles (group 1). Rather than testing all N*M pairs, the bounding
+// boxes of both groups are projected onto the x axis and the sorted interval
+// end points are swept from left to right. Only boxes whose x intervals overlap
+// are tested for y overlap, and only pairs that overlap in both are reported
+// as candidates for the narrow phase, e.g. Polygon::intersects().
+//
+// The end point list is kept across calls. Since the boxes typically move only
+// a little from one frame to the next, the list is nearly sorted and an insertion
+// sort restores the order in close to linear time. The sweep itself is linear in
+// the number of boxes plus the number of overlapping intervals.
+//
+// The boxes are addressed by their group (0 or 1) and their index in the group.
+// Usage:
+//
+// SweepAndPrune sap; // keep as a member
+// sap.setBoxes(0, footprints);
+// sap.setBoxes(1, state.stablePolygons);
+// const Vector<SweepAndPrune::Pair>& pairs = sap.findPairs();
+// for (int i = 0; i < pairs.size(); i++)
+//     footprints[pairs[i].a].intersects(state.stablePolygons[pairs[i].b]);
+//
+// or let findCollisions() run the narrow phase as well.
+
+SweepAndPrune::SweepAndPrune()
+{
+    removed = false;
+}
+
+// Removes all boxes.
+void SweepAndPrune::clear()
+{
+    objects.clear();
+    freeObjects.clear();
+    groupObjects[0].clear();
+    groupObjects[1].clear();
+    endpoints.clear();
+    removed = false;
+}
+
+// Sets the number of boxes in the group. New boxes are empty at the origin
+// until they are set with setBox(). Boxes beyond n are removed.
+void SweepAndPrune::resize(int group, int n)
+{
+    Vector<int>& go = groupObjects[group];
+
+    // Remove surplus objects.
+    while (go.size() > n)
+    {
+        int o = go.last();
+        objects[o].group = -1;
+        freeObjects << o;
+        go.resize(go.size()-1);
+        removed = true;
+    }
+
+    // The end points of removed objects have to be dropped before their slots
+    // are handed out again, otherwise a reused slot would have four end points.
+    if (go.size() < n)
+        compactEndpoints();
+
+    // Add new objects.
+    while (go.size() < n)
+    {
+        int o;
+        if (freeObjects.isEmpty())
+        {
+            o = objects.size();
+            objects << Object();
+        }
+        else
+        {
+            o = freeObjects.last();
+            freeObjects.resize(freeObjects.size()-1);
+        }
+
+        Object& obj = objects[o];
+        obj.l = obj.r = obj.b = obj.t = 0;
+        obj.group = group;
+        obj.index = go.size();
+        obj.activeIdx = -1;
+        go << o;
+
+        Endpoint e;
+        e.value = 0;
+        e.object = o;
+        e.isMin = true;
+        endpoints << e;
+        e.isMin = false;
+        endpoints << e;
+    }
+}
+
+// Returns the number of boxes in the group.
+int SweepAndPrune::size(int group) const
+{
+    return groupObjects[group].size();
+}
+
+// Sets the box with the given index in the group.
+void SweepAndPrune::setBox(int group, int index, const Box &box)
+{
+    Object& obj = objects[groupObjects[group][index]];
+    obj.l = box.left();
+    obj.r = box.right();
+    obj.b = box.bottom();
+    obj.t = box.top();
+}
+
+// Sets the boxes of a group to the bounding boxes of the polygons.
+void SweepAndPrune::setBoxes(int group, const Vector<Polygon> &pols)
+{
+    resize(group, pols.size());
+    for (int i = 0; i < pols.size(); i++)
+        setBox(group, i, pols[i].boundingBox());
+}
+
+// Drops the end points of removed objects from the list.
+void SweepAndPrune::compactEndpoints()
+{
+    if (!removed)
+        return;
+
+    int k = 0;
+    for (int i = 0; i < endpoints.size(); i++)
+        if (objects[endpoints[i].object].group >= 0)
+            endpoints[k++] = endpoints[i];
+    endpoints.resize(k);
+    removed = false;
+}
+
+// Updates the end point values and restores their order with an insertion sort.
+// Removed objects are dropped from the list first.
+void SweepAndPrune::sortEndpoints()
+{
+    compactEndpoints();
+
+    for (int i = 0; i < endpoints.size(); i++)
+    {
+        const Object& obj = objects[endpoints[i].object];
+        endpoints[i].value = endpoints[i].isMin ? obj.l : obj.r;
+    }
+
+    // Insertion sort. Nearly linear for coherent motion.
+    for (int i = 1; i < endpoints.size(); i++)
+    {
+        Endpoint e = endpoints[i];
+        int j = i-1;
+        while (j >= 0 && e < endpoints[j])
+        {
+            endpoints[j+1] = endpoints[j];
+            j--;
+        }
+        endpoints[j+1] = e;
+    }
+}
+
+// Computes the pairs of boxes of group 0 and group 1 that overlap.
+// Touching boxes count as overlapping.
+const Vector<SweepAndPrune::Pair> &SweepAndPrune::findPairs()
+{
+    sortEndpoints();
+
+    pairs.clear();
+    active.clear();
+    for (int i = 0; i < endpoints.size(); i++)
+    {
+        const Endpoint& e = endpoints[i];
+        Object& obj = objects[e.object];
+
+        if (!e.isMin)
+        {
+            // Remove the object from the active list.
+            int last = active.last();
+            active[obj.activeIdx] = last;
+            objects[last].activeIdx = obj.activeIdx;
+            active.resize(active.size()-1);
+            obj.activeIdx = -1;
+            continue;
+        }
+
+        // Test against the active objects of the other group.
+        for (int j = 0; j < active.size(); j++)
+        {
+            const Object& o = objects[active[j]];
+            if (o.group == obj.group || o.t < obj.b || o.b > obj.t)
+                continue;
+            Pair p;
+            p.a = (obj.group == 0) ? obj.index : o.index;
+            p.b = (obj.group == 0) ? o.index : obj.index;
+            pairs << p;
+        }
+
+        obj.activeIdx = active.size();
+        active << e.object;
+    }
+
+    return pairs;
+}
+
+// Computes the pairs of polygons of a and b that intersect. The bounding boxes
+// are updated, the broadphase finds the candidate pairs, and the narrow phase
+// tests the candidates with Polygon::intersects().
+const Vector<SweepAndPrune::Pair> &SweepAndPrune::findCollisions(const Vector<Polygon> &a, const Vector<Polygon> &b)
+{
+    setBoxes(0, a);
+    setBoxes(1, b);
+    findPairs();
+
+    collisions.clear();
+    for (int i = 0; i < pairs.size(); i++)
+        if (a[pairs[i].a].intersects(b[pairs[i].b]))
+            collisions << pairs[i];
+
+    return collisions;
+}
@@ -0,0 +1,67 @@
+#ifndef SWEEPANDPRUNE_H_
+#define SWEEPANDPRUNE_H_
+#include "util/Vector.h"
+#include "geometry/Box.h"
+#include "geometry/Polygon.h"
+
+class SweepAndPrune
+{
+public:
+
+    // A candidate pair given by the index of a box in group 0 and in group 1.
+    struct Pair
+    {
+        int a;
+        int b;
+    };
+
+private:
+
+    // An end point of a box interval on the x axis.
+    struct Endpoint
+    {
+        double value;
+        int object;
+        bool isMin;
+        bool operator<(const Endpoint& o) const {return value < o.value || (value == o.value && isMin && !o.isMin);}
+    };
+
+    // A box that takes part in the sweep.
+    struct Object
+    {
+        double l, r, b, t;
+        int group = -1; // -1 marks an unused object slot.
+        int index = 0; // The index of the box in its group.
+        int activeIdx = -1; // Position in the active list during the sweep.
+    };
+
+    Vector<Object> objects; // Object slots.
+    Vector<int> freeObjects; // Indices of unused object slots.
+    Vector<int> groupObjects[2]; // The object slot of every box of a group.
+    Vector<Endpoint> endpoints; // The interval end points sorted along x.
+    bool removed; // Some objects were removed since the last sweep.
+
+    Vector<int> active; // Objects whose interval contains the sweep position.
+    Vector<Pair> pairs;
+    Vector<Pair> collisions;
+
+public:
+
+    SweepAndPrune();
+    ~SweepAndPrune(){}
+
+    void clear();
+    void resize(int group, int n);
+    int size(int group) const;
+    void setBox(int group, int index, const Box& box);
+    void setBoxes(int group, const Vector<Polygon>& pols);
+
+    const Vector<Pair>& findPairs();
+    const Vector<Pair>& findCollisions(const Vector<Polygon>& a, const Vector<Polygon>& b);
+
+private:
+    void compactEndpoints();
+    void sortEndpoints();
+};
+
+#endif
@@ -0,0 +1,292 @@
+#include "SweptFootprint.h"
+#include "GeometryUtil.h"
+#include "globals.h"
+
+// The SweptFootprint implements continuous collision checking of a moving robot
+// footprint against a set of polygonal obstacles, typically state.stablePolygons.
+// Instead of placing the footprint at a number of discrete poses along a trajectory
+// and testing each pose with Polygon::intersects(), the footprint is swept along
+// the trajectory and the time of first contact is computed. This replaces dozens
+// of static checks per trajectory and it cannot tunnel through thin obstacles.
+//
+// The footprint is a convex polygon given in robot coordinates. The motion is a
+// constant body frame velocity (vx, vy, w) applied for a duration, starting from
+// a pose (x, y, theta). With vy = 0 this is the unicycle motion of a differential
+// drive robot, which is an arc, or a straight line segment if w = 0.
+//
+// The time of contact is computed with conservative advancement. No point of the
+// footprint moves faster than |(vx,vy)| + |w|*radius, where radius is the largest
+// distance of a footprint vertex from the robot origin. If the footprint is at a
+// distance d from the obstacle at time t, it cannot touch the obstacle before
+// t + d/speed, so the time can safely be advanced by this amount. The iteration
+// stops when the distance drops below the tolerance or the time exceeds the
+// duration of the motion. A swept bounding box culls obstacles that are far away
+// from the trajectory before any distance is computed.
+//
+// Usage:
+//
+// SweptFootprint sweep;
+// sweep.setFootprint(Polygon(0, 0, 0.3, 0.2));
+// sweep.setMotion(0, 0, 0, v, w, 1.0);
+// double t = sweep.timeOfContact(state.stablePolygons); // -1 if collision free
+
+// Returns the distance between the segments ab and cd. It is 0 if they cross.
+static inline double segmentDistance(const Vec2& a, const Vec2& b, const Vec2& c, const Vec2& d)
+{
+    double o1 = orientation(a, b, c);
+    double o2 = orientation(a, b, d);
+    double o3 = orientation(c, d, a);
+    double o4 = orientation(c, d, b);
+    if (((o1 > 0 && o2 < 0) || (o1 < 0 && o2 > 0)) && ((o3 > 0 && o4 < 0) || (o3 < 0 && o4 > 0)))
+        return 0;
+
+    return min(min(pointSegmentDistance(a, c, d), pointSegmentDistance(b, c, d)),
+               min(pointSegmentDistance(c, a, b), pointSegmentDistance(d, a, b)));
+}
+
+SweptFootprint::SweptFootprint()
+{
+    radius = 0;
+    tolerance = 0.001;
+    maxIterations = 64;
+    x0 = 0;
+    y0 = 0;
+    theta0 = 0;
+    vx = 0;
+    vy = 0;
+    w = 0;
+    duration = 0;
+}
+
+// Sets the footprint of the robot. The footprint must be convex. It is given
+// in robot coordinates, i.e. relative to the point the motion refers to.
+// The transformation of the polygon, if any, is applied.
+void SweptFootprint::setFootprint(const Polygon &pol)
+{
+    Polygon p = pol;
+    p.transform();
+    if (p.area() < 0)
+        p.reverseOrder();
+
+    footprint.clear();
+    radius = 0;
+    ListIterator<Vec2> it = p.vertexIterator();
+    while (it.hasNext())
+    {
+        Vec2& v = it.next();
+        footprint << v;
+        radius = max(radius, v.norm());
+    }
+    vertices.resize(footprint.size());
+}
+
+// Sets the distance at which the footprint and an obstacle are considered to be in contact.
+void SweptFootprint::setTolerance(double tolerance)
+{
+    this->tolerance = tolerance;
+}
+
+// Sets a unicycle motion with forward velocity v and angular velocity w
+// that starts in the pose (x, y, theta) and lasts for the given duration.
+void SweptFootprint::setMotion(double x, double y, double theta, double v, double w, double duration)
+{
+    setMotion(x, y, theta, v, 0, w, duration);
+}
+
+// Sets a holonomic motion with the body frame velocities (vx, vy, w)
+// that starts in the pose (x, y, theta) and lasts for the given duration.
+void SweptFootprint::setMotion(double x, double y, double theta, double vx, double vy, double w, double duration)
+{
+    x0 = x;
+    y0 = y;
+    theta0 = theta;
+    this->vx = vx;
+    this->vy = vy;
+    this->w = w;
+    this->duration = duration;
+}
+
+// Computes the pose of the robot at time t of the motion.
+// The body frame velocity is integrated in closed form.
+void SweptFootprint::poseAt(double t, double &x, double &y, double &theta) const
+{
+    double dx, dy;
+    if (fabs(w) < EPSILON)
+    {
+        dx = vx*t;
+        dy = vy*t;
+    }
+    else
+    {
+        double s = sin(w*t)/w;
+        double c = (1.0-cos(w*t))/w;
+        dx = s*vx - c*vy;
+        dy = c*vx + s*vy;
+    }
+
+    double c0 = cos(theta0);
+    double s0 = sin(theta0);
+    x = x0 + c0*dx - s0*dy;
+    y = y0 + s0*dx + c0*dy;
+    theta = theta0 + w*t;
+}
+
+// Returns the footprint at time t of the motion in world coordinates.
+Polygon SweptFootprint::footprintAt(double t) const
+{
+    computeVertices(t);
+    Polygon p;
+    for (int i = 0; i < vertices.size(); i++)
+        p << vertices[i];
+    return p;
+}
+
+// Returns a bounding box of the volume that is swept by the footprint
+// during the motion. The bounding box of the path of the robot origin
+// is grown by the radius of the footprint (Minkowski sum).
+Box SweptFootprint::sweptBoundingBox() const
+{
+    double xs, ys, ts, xe, ye, te;
+    poseAt(0, xs, ys, ts);
+    poseAt(duration, xe, ye, te);
+
+    // An arc deviates from its chord by at most the sagitta, as long as the
+    // arc angle is smaller than PI. Longer arcs stay within the diameter.
+    double margin = radius;
+    if (fabs(w) > EPSILON)
+    {
+        double r = sqrt(vx*vx+vy*vy)/fabs(w);
+        double phi = fabs(w)*duration;
+        margin += (phi < PI) ? r*(1.0-cos(0.5*phi)) : 2.0*r;
+    }
+
+    Box box;
+    box.set(max(ys, ye), min(xs, xe), min(ys, ye), max(xs, xe));
+    Box m;
+    m.set(0, 0, margin, -margin, -margin, margin);
+    box += m;
+    return box;
+}
+
+// Computes the time of first contact of the moving footprint with the obstacle.
+// The obstacle does not need to be convex. If the footprint does not touch the
+// obstacle during the motion, -1 is returned.
+double SweptFootprint::timeOfContact(const Polygon &obstacle) const
+{
+    if (!sweptBoundingBox().intersects(obstacle.boundingBox()))
+        return -1;
+    return timeOfContact(obstacle, duration);
+}
+
+// Computes the time of first contact of the moving footprint with any of the
+// obstacles. If the motion is collision free, -1 is returned.
+double SweptFootprint::timeOfContact(const Vector<Polygon> &obstacles) const
+{
+    Box box = sweptBoundingBox();
+    double tmin = duration;
+    bool contact = false;
+    for (int i = 0; i < obstacles.size(); i++)
+    {
+        if (!box.intersects(obstacles[i].boundingBox()))
+            continue;
+
+        // Obstacles that cannot be reached before the earliest contact found
+        // so far are advanced only up to that time.
+        double t = timeOfContact(obstacles[i], tmin);
+        if (t >= 0 && t <= tmin)
+        {
+            tmin = t;
+            contact = true;
+        }
+    }
+
+    return contact ? tmin : -1;
+}
+
+// Returns true if the footprint touches any of the obstacles during the motion.
+bool SweptFootprint::intersects(const Vector<Polygon> &obstacles) const
+{
+    return (timeOfContact(obstacles) >= 0);
+}
+
+// Computes the distance between the footprint at time t of the motion and the
+// obstacle. The distance is 0 if they overlap. The obstacle may be non-convex.
+double SweptFootprint::distance(double t, const Polygon &obstacle) const
+{
+    if (obstacle.x != 0 || obstacle.y != 0 || obstacle.theta != 0)
+    {
+        Polygon o = obstacle;
+        o.transform();
+        return distance(t, o);
+    }
+
+    computeVertices(t);
+    int n = vertices.size();
+
+    // Containment of a footprint vertex in the obstacle.
+    if (obstacle.intersects(vertices[0]))
+        return 0;
+
+    double d = std::numeric_limits<double>::max();
+    ListIterator<Vec2> it = obstacle.vertexIterator();
+    while (it.hasNext())
+    {
+        const Vec2& c = it.peekCur();
+        const Vec2& e = it.peekNext();
+        it.next();
+
+        // Containment of an obstacle vertex in the convex footprint.
+        bool inside = true;
+        for (int i = 0; i < n && inside; i++)
+            if (orientation(vertices[i], vertices[(i+1)%n], c) < 0)
+                inside = false;
+        if (inside)
+            return 0;
+
+        for (int i = 0; i < n; i++)
+            d = min(d, segmentDistance(vertices[i], vertices[(i+1)%n], c, e));
+        if (d <= 0)
+            return 0;
+    }
+
+    return d;
+}
+
+// Transforms the footprint vertices into the world frame at time t of the motion.
+void SweptFootprint::computeVertices(double t) const
+{
+    double x, y, theta;
+    poseAt(t, x, y, theta);
+    double c = cos(theta);
+    double s = sin(theta);
+    for (int i = 0; i < footprint.size(); i++)
+    {
+        vertices[i].x = x + c*footprint[i].x - s*footprint[i].y;
+        vertices[i].y = y + s*footprint[i].x + c*footprint[i].y;
+    }
+}
+
+// Conservative advancement up to time tmax.
+double SweptFootprint::timeOfContact(const Polygon &obstacle, double tmax) const
+{
+    if (footprint.size() < 3)
+        return -1;
+
+    double speed = sqrt(vx*vx+vy*vy) + fabs(w)*radius;
+    double t = 0;
+    for (int i = 0; i < maxIterations; i++)
+    {
+        double d = distance(t, obstacle);
+        if (d <= tolerance)
+            return t;
+        if (speed < EPSILON)
+            return -1;
+        t += d/speed;
+        if (t > tmax)
+            return -1;
+    }
+
+    // The advancement has not converged, which happens when the footprint
+    // slides along the obstacle. Report contact to be on the safe side.
+    return t;
+}
@@ -0,0 +1,48 @@
+#ifndef SWEPTFOOTPRINT_H_
+#define SWEPTFOOTPRINT_H_
+#include "util/Vec2.h"
+#include "util/Vector.h"
+#include "geometry/Box.h"
+#include "geometry/Polygon.h"
+
+class SweptFootprint
+{
+    Vector<Vec2> footprint; // Convex footprint in robot coordinates (ccw).
+    double radius; // Largest distance of a footprint vertex from the robot origin.
+    double tolerance; // Distance at which contact is reported.
+    int maxIterations; // Bound on the conservative advancement steps per obstacle.
+
+    // The motion: start pose and body frame velocities.
+    double x0, y0, theta0;
+    double vx, vy, w;
+    double duration;
+
+    mutable Vector<Vec2> vertices; // Temporary footprint vertices in world coordinates.
+
+public:
+
+    SweptFootprint();
+    ~SweptFootprint(){}
+
+    void setFootprint(const Polygon& footprint);
+    void setTolerance(double tolerance);
+
+    void setMotion(double x, double y, double theta, double v, double w, double duration);
+    void setMotion(double x, double y, double theta, double vx, double vy, double w, double duration);
+
+    void poseAt(double t, double& x, double& y, double& theta) const;
+    Polygon footprintAt(double t) const;
+    Box sweptBoundingBox() const;
+
+    double timeOfContact(const Polygon& obstacle) const;
+    double timeOfContact(const Vector<Polygon>& obstacles) const;
+    bool intersects(const Vector<Polygon>& obstacles) const;
+
+    double distance(double t, const Polygon& obstacle) const;
+
+private:
+    void computeVertices(double t) const;
+    double timeOfContact(const Polygon& obstacle, double tmax) const;
+};
+
+#endif
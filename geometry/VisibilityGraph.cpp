@@ -0,0 +1,510 @@
+#include "VisibilityGraph.h"
+#include "GeometryUtil.h"
+#include "globals.h"
+#include "util/PriorityQueue.h"
+#ifndef HEADLESS
+#include <GL/gl.h>
+#endif
+
+// The VisibilityGraph is a planning structure for any-angle shortest paths
+// among the polygonal obstacles computed by the perception pipeline. The
+// nodes of the graph are the convex vertices of the polygons and an edge
+// connects two nodes if they can see each other, i.e. if the line between
+// them does not cross any polygon. Reflex (non-convex) vertices are never
+// part of a shortest path and are therefore left out.
+//
+// The edges are stored in a bit-packed AdjacencyMatrix. Rather than rebuilding
+// the graph in O(n^2 log n) every frame, the graph is maintained incrementally.
+// Polygons can be added, removed, and updated individually, and update() diffs
+// a new set of polygons against the current one so that only the polygons that
+// have actually changed are touched. Adding a polygon invalidates only those
+// existing edges that pass through its bounding box, and removing a polygon
+// re-tests only the node pairs whose line passes through its bounding box.
+//
+// shortestPath() connects a start and a goal point to the graph on the fly and
+// runs an A* search with the Euclidean distance as heuristic.
+//
+// All polygons are expected to be simple. They are stored in transformed state
+// and in counter clockwise order, which is enforced when they are added.
+
+// Returns true if the segments ab and cd cross each other in a single point
+// that is interior to both. Touching in an endpoint is not a proper intersection.
+static inline bool properlyIntersect(const Vec2& a, const Vec2& b, const Vec2& c, const Vec2& d)
+{
+    double o1 = orientation(a, b, c);
+    double o2 = orientation(a, b, d);
+    double o3 = orientation(c, d, a);
+    double o4 = orientation(c, d, b);
+    return ((o1 > 0 && o2 < 0) || (o1 < 0 && o2 > 0)) && ((o3 > 0 && o4 < 0) || (o3 < 0 && o4 > 0));
+}
+
+// Returns true if the bounding box of the segment ab overlaps with the box.
+static inline bool segmentBoxOverlap(const Vec2& a, const Vec2& b, const Box& box)
+{
+    return !(qMax(a.x, b.x) < box.left() || qMin(a.x, b.x) > box.right()
+             || qMax(a.y, b.y) < box.bottom() || qMin(a.y, b.y) > box.top());
+}
+
+VisibilityGraph::VisibilityGraph()
+{
+    edgeCount = 0;
+}
+
+// Removes all polygons and edges from the graph.
+void VisibilityGraph::clear()
+{
+    polygons.clear();
+    polygonUsed.clear();
+    polygonNodes.clear();
+    nodes.clear();
+    freeNodes.clear();
+    adjacency.clear();
+    edgeCount = 0;
+}
+
+// Brings the graph up to date with the given set of polygons, for example
+// state.stablePolygons. Polygons that have not changed since the last update are
+// kept along with their edges. Polygons that have disappeared are removed,
+// and new or changed polygons are added.
+void VisibilityGraph::update(const Vector<Polygon> &pols)
+{
+    Vector<char> matched(pols.size());
+    matched.fill(0);
+
+    // Remove the polygons that have no identical counterpart in the new set.
+    for (int id = 0; id < polygons.size(); id++)
+    {
+        if (!polygonUsed[id])
+            continue;
+
+        bool keep = false;
+        for (int j = 0; j < pols.size() && !keep; j++)
+        {
+            if (!matched[j] && sameShape(polygons[id], pols[j]))
+            {
+                matched[j] = 1;
+                keep = true;
+            }
+        }
+
+        if (!keep)
+            removePolygon(id);
+    }
+
+    // Add the new ones.
+    for (int j = 0; j < pols.size(); j++)
+        if (!matched[j])
+            addPolygon(pols[j]);
+}
+
+// Adds a polygon to the graph and returns its id. The id can be used
+// to remove or update the polygon later. Polygons with less than three
+// vertices are ignored and -1 is returned.
+int VisibilityGraph::addPolygon(const Polygon &pol)
+{
+    if (pol.size() < 3)
+        return -1;
+
+    // Find a free polygon slot.
+    int id = 0;
+    while (id < polygons.size() && polygonUsed[id])
+        id++;
+    if (id == polygons.size())
+    {
+        polygons << Polygon();
+        polygonUsed << char(0);
+        polygonNodes << Vector<int>();
+    }
+
+    Polygon& p = polygons[id];
+    p = pol;
+    p.transform();
+    if (p.area() < 0)
+        p.reverseOrder();
+    polygonUsed[id] = 1;
+    polygonNodes[id].clear();
+
+    // Invalidate the existing edges that are blocked by the new polygon.
+    const Box& box = p.boundingBox();
+    for (int i = 0; i < nodes.size(); i++)
+    {
+        if (nodes[i].polygonId < 0)
+            continue;
+
+        int j = adjacency.nextNeighbour(i, i);
+        while (j >= 0)
+        {
+            if (segmentBoxOverlap(nodes[i].p, nodes[j].p, box)
+                    && blocks(id, nodes[i].p, nodes[j].p, &nodes[i], &nodes[j]))
+            {
+                adjacency.unset(i, j);
+                edgeCount--;
+            }
+            j = adjacency.nextNeighbour(i, j);
+        }
+    }
+
+    // Create a node for every convex vertex.
+    ListIterator<Vec2> it = p.vertexIterator();
+    while (it.hasNext())
+    {
+        const Vec2& v1 = it.peekPrev();
+        const Vec2& v2 = it.peekCur();
+        const Vec2& v3 = it.peekNext();
+        it.next();
+
+        if (orientation(v1, v2, v3) <= 0) // Only left turns are convex vertices.
+            continue;
+
+        int i;
+        if (freeNodes.isEmpty())
+        {
+            i = nodes.size();
+            nodes << Node();
+        }
+        else
+        {
+            i = freeNodes.last();
+            freeNodes.resize(freeNodes.size()-1);
+        }
+
+        Node& node = nodes[i];
+        node.p = v2;
+        node.prev = v1;
+        node.next = v3;
+        node.polygonId = id;
+        polygonNodes[id] << i;
+    }
+
+    adjacency.resize(nodes.size());
+
+    // Connect the new nodes to the graph.
+    for (int k = 0; k < polygonNodes[id].size(); k++)
+        connectNode(polygonNodes[id][k]);
+
+    return id;
+}
+
+// Removes the polygon with the given id from the graph.
+void VisibilityGraph::removePolygon(int id)
+{
+    if (id < 0 || id >= polygons.size() || !polygonUsed[id])
+        return;
+
+    // Disconnect and free the nodes of the polygon.
+    for (int k = 0; k < polygonNodes[id].size(); k++)
+    {
+        int i = polygonNodes[id][k];
+        edgeCount -= adjacency.degree(i);
+        adjacency.unsetAll(i);
+        nodes[i].polygonId = -1;
+        freeNodes << i;
+    }
+    polygonNodes[id].clear();
+    polygonUsed[id] = 0;
+
+    // Only the node pairs whose line passes through the bounding box of the
+    // removed polygon can have become visible.
+    Box box = polygons[id].boundingBox();
+    for (int i = 0; i < nodes.size(); i++)
+    {
+        if (nodes[i].polygonId < 0)
+            continue;
+
+        for (int j = i+1; j < nodes.size(); j++)
+        {
+            if (nodes[j].polygonId < 0 || adjacency.isSet(i, j))
+                continue;
+
+            if (segmentBoxOverlap(nodes[i].p, nodes[j].p, box) && isVisible(nodes[i], nodes[j]))
+            {
+                adjacency.set(i, j);
+                edgeCount++;
+            }
+        }
+    }
+}
+
+// Replaces the polygon with the given id with a new shape.
+// The polygon may receive a different id. The new id is returned.
+int VisibilityGraph::updatePolygon(int id, const Polygon &pol)
+{
+    removePolygon(id);
+    return addPolygon(pol);
+}
+
+// Returns the number of polygons in the graph.
+int VisibilityGraph::numPolygons() const
+{
+    int n = 0;
+    for (int id = 0; id < polygonUsed.size(); id++)
+        if (polygonUsed[id])
+            n++;
+    return n;
+}
+
+// Returns the number of nodes (convex vertices) in the graph.
+int VisibilityGraph::numNodes() const
+{
+    return nodes.size()-freeNodes.size();
+}
+
+// Returns the number of edges in the graph.
+int VisibilityGraph::numEdges() const
+{
+    return edgeCount;
+}
+
+// Returns true if the line between the points a and b does not
+// cross any of the polygons in the graph.
+bool VisibilityGraph::isVisible(const Vec2 &a, const Vec2 &b) const
+{
+    return isVisible(a, b, 0, 0);
+}
+
+// Computes the shortest path from "from" to "to" around the polygons.
+// The path includes the start and the goal point. If there is no path,
+// the returned path is empty. The path is also available with getPath().
+const Vector<Vec2> &VisibilityGraph::shortestPath(const Vec2 &from, const Vec2 &to)
+{
+    path.clear();
+
+    // Trivial case of a direct line of sight.
+    if (isVisible(from, to))
+    {
+        path << from << to;
+        return path;
+    }
+
+    // Reset the search data.
+    for (int i = 0; i < nodes.size(); i++)
+    {
+        nodes[i].g = std::numeric_limits<double>::max();
+        nodes[i].parent = 0;
+        nodes[i].pqIdx = 0;
+        nodes[i].closed = false;
+    }
+    startNode.p = from;
+    startNode.g = 0;
+    startNode.parent = 0;
+    goalNode.p = to;
+    goalNode.g = std::numeric_limits<double>::max();
+    goalNode.parent = 0;
+    goalNode.pqIdx = 0;
+
+    // Connect the start point to the graph.
+    PriorityQueue<Node*> q;
+    for (int i = 0; i < nodes.size(); i++)
+    {
+        Node& n = nodes[i];
+        if (n.polygonId < 0 || !isVisible(from, n.p, 0, &n))
+            continue;
+        n.g = (n.p-from).norm();
+        n.f = n.g + (to-n.p).norm();
+        n.parent = &startNode;
+        q.push(&n);
+    }
+
+    // A* search. The goal is connected lazily whenever a node is expanded.
+    while (!q.isEmpty())
+    {
+        Node* n = q.top();
+        q.pop();
+
+        if (n == &goalNode)
+            break;
+
+        n->closed = true;
+
+        if (isVisible(n->p, to, n, 0))
+        {
+            double g = n->g + (to-n->p).norm();
+            if (g < goalNode.g)
+            {
+                goalNode.g = g;
+                goalNode.f = g;
+                goalNode.parent = n;
+                q.push(&goalNode);
+            }
+        }
+
+        int i = n - &nodes[0];
+        int j = adjacency.nextNeighbour(i);
+        while (j >= 0)
+        {
+            Node& m = nodes[j];
+            if (!m.closed)
+            {
+                double g = n->g + (m.p-n->p).norm();
+                if (g < m.g)
+                {
+                    m.g = g;
+                    m.f = g + (to-m.p).norm();
+                    m.parent = n;
+                    q.push(&m);
+                }
+            }
+            j = adjacency.nextNeighbour(i, j);
+        }
+    }
+
+    // Extract the path by backtracking from the goal.
+    if (goalNode.parent != 0)
+    {
+        Node* n = &goalNode;
+        while (n != 0)
+        {
+            path << n->p;
+            n = n->parent;
+        }
+
+        for (int k = 0; k < path.size()/2; k++)
+            path.swap(k, path.size()-1-k);
+    }
+
+    return path;
+}
+
+// Returns the path computed by the last call of shortestPath().
+const Vector<Vec2> &VisibilityGraph::getPath() const
+{
+    return path;
+}
+
+// Draws the edges of the graph and the last computed path in an OpenGL context.
+void VisibilityGraph::draw() const
+{
+#ifndef HEADLESS
+    glLineWidth(1);
+    glColor3f(0.6, 0.6, 0.6);
+    glBegin(GL_LINES);
+    for (int i = 0; i < nodes.size(); i++)
+    {
+        if (nodes[i].polygonId < 0)
+            continue;
+
+        int j = adjacency.nextNeighbour(i, i);
+        while (j >= 0)
+        {
+            glVertex3f(nodes[i].p.x, nodes[i].p.y, 0.01);
+            glVertex3f(nodes[j].p.x, nodes[j].p.y, 0.01);
+            j = adjacency.nextNeighbour(i, j);
+        }
+    }
+    glEnd();
+
+    glLineWidth(3);
+    glColor3f(0.0, 0.0, 1.0);
+    glBegin(GL_LINE_STRIP);
+    for (int i = 0; i < path.size(); i++)
+        glVertex3f(path[i].x, path[i].y, 0.015);
+    glEnd();
+#endif
+}
+
+// Returns true if the two nodes a and b can see each other.
+bool VisibilityGraph::isVisible(const Node &a, const Node &b) const
+{
+    return isVisible(a.p, b.p, &a, &b);
+}
+
+// Returns true if the line between a and b does not cross any polygon.
+// If a or b are nodes of the graph, na and nb point to the nodes so that
+// lines that leave a vertex into the interior of its own polygon can be
+// rejected. Otherwise na and nb are 0.
+bool VisibilityGraph::isVisible(const Vec2 &a, const Vec2 &b, const Node *na, const Node *nb) const
+{
+    // The line must not leave a convex vertex into the interior of its polygon.
+    // For a ccw polygon the interior is the cone spanned from the next to the
+    // previous vertex.
+    if (na != 0)
+    {
+        Vec2 d = b-na->p;
+        if (orientation(Vec2(), na->next-na->p, d) > 0 && orientation(Vec2(), d, na->prev-na->p) > 0)
+            return false;
+    }
+    if (nb != 0)
+    {
+        Vec2 d = a-nb->p;
+        if (orientation(Vec2(), nb->next-nb->p, d) > 0 && orientation(Vec2(), d, nb->prev-nb->p) > 0)
+            return false;
+    }
+
+    for (int id = 0; id < polygons.size(); id++)
+        if (polygonUsed[id] && blocks(id, a, b, na, nb))
+            return false;
+
+    return true;
+}
+
+// Returns true if the polygon with the given id blocks the line from a to b.
+bool VisibilityGraph::blocks(int id, const Vec2 &a, const Vec2 &b, const Node *na, const Node *nb) const
+{
+    const Polygon& pol = polygons[id];
+    if (!segmentBoxOverlap(a, b, pol.boundingBox()))
+        return false;
+
+    // Edge crossing test.
+    ListIterator<Vec2> it = pol.vertexIterator();
+    while (it.hasNext())
+    {
+        const Vec2& v1 = it.peekCur();
+        const Vec2& v2 = it.peekNext();
+        it.next();
+        if (properlyIntersect(a, b, v1, v2))
+            return true;
+    }
+
+    // A line that touches the polygon only in vertices can still run through
+    // its interior, for example a diagonal. The midpoint test catches this case.
+    // The edges of the polygon itself are excluded since their midpoint lies on
+    // the boundary.
+    if (na != 0 && nb != 0 && na->polygonId == id && nb->polygonId == id
+            && ((na->next-nb->p).norm2() < EPSILON || (nb->next-na->p).norm2() < EPSILON))
+        return false;
+
+    return pol.intersects(Vec2(0.5*(a+b)));
+}
+
+// Returns true if the polygons p1 and p2 have the same vertices in world coordinates.
+bool VisibilityGraph::sameShape(const Polygon &p1, const Polygon &p2) const
+{
+    if (p1.size() != p2.size())
+        return false;
+
+    const Box& b1 = p1.boundingBox();
+    const Box& b2 = p2.boundingBox();
+    if (fabs(b1.left()-b2.left()) > EPSILON || fabs(b1.right()-b2.right()) > EPSILON
+            || fabs(b1.top()-b2.top()) > EPSILON || fabs(b1.bottom()-b2.bottom()) > EPSILON)
+        return false;
+
+    // Compare the vertices. p1 is stored in ccw order, p2 may be in any order.
+    Polygon q = p2;
+    q.transform();
+    if (q.area() < 0)
+        q.reverseOrder();
+
+    ListIterator<Vec2> it1 = p1.vertexIterator();
+    ListIterator<Vec2> it2 = q.vertexIterator();
+    while (it1.hasNext())
+        if ((it1.next()-it2.next()).norm2() > EPSILON)
+            return false;
+
+    return true;
+}
+
+// Connects the node i to all nodes it can see.
+void VisibilityGraph::connectNode(int i)
+{
+    for (int j = 0; j < nodes.size(); j++)
+    {
+        if (j == i || nodes[j].polygonId < 0 || adjacency.isSet(i, j))
+            continue;
+
+        if (isVisible(nodes[i], nodes[j]))
+        {
+            adjacency.set(i, j);
+            edgeCount++;
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef VISIBILITYGRAPH_H_
+#define VISIBILITYGRAPH_H_
+#include "util/Vec2.h"
+#include "util/Vector.h"
+#include "util/AdjacencyMatrix.h"
+#include "geometry/Polygon.h"
+
+class VisibilityGraph
+{
+    // A node of the graph is a convex vertex of one of the polygons.
+    // The node also knows the neighbouring vertices of the polygon,
+    // which are needed to reject lines of sight into the polygon.
+    struct Node
+    {
+        Vec2 p; // Position of the vertex in world coordinates.
+        Vec2 prev; // The previous vertex of the polygon (ccw order).
+        Vec2 next; // The next vertex of the polygon (ccw order).
+        int polygonId = -1; // -1 marks an unused node slot.
+
+        // Search data.
+        double g = 0;
+        double f = 0;
+        Node* parent = 0;
+        uint pqIdx = 0;
+        bool closed = false;
+        bool cmp(const Node* o) const {return f < o->f;}
+        void setIdx(uint i) {pqIdx = i;}
+        uint getIdx() const {return pqIdx;}
+    };
+
+    Vector<Polygon> polygons; // Polygon slots indexed by polygon id.
+    Vector<char> polygonUsed; // Marks which polygon slots are in use.
+    Vector<Vector<int> > polygonNodes; // The node indices of every polygon.
+    Vector<Node> nodes; // Node slots. The index of a node is its index in the adjacency matrix.
+    Vector<int> freeNodes; // Indices of unused node slots.
+    AdjacencyMatrix adjacency;
+    int edgeCount;
+
+    Node startNode;
+    Node goalNode;
+    Vector<Vec2> path;
+
+public:
+
+    VisibilityGraph();
+    ~VisibilityGraph(){}
+
+    void clear();
+    void update(const Vector<Polygon>& polygons);
+    int addPolygon(const Polygon& pol);
+    void removePolygon(int id);
+    int updatePolygon(int id, const Polygon& pol);
+
+    int numPolygons() const;
+    int numNodes() const;
+    int numEdges() const;
+
+    bool isVisible(const Vec2& a, const Vec2& b) const;
+    const Vector<Vec2>& shortestPath(const Vec2& from, const Vec2& to);
+    const Vector<Vec2>& getPath() const;
+
+    void draw() const;
+
+private:
+    bool isVisible(const Node& a, const Node& b) const;
+    bool isVisible(const Vec2& a, const Vec2& b, const Node* na, const Node* nb) const;
+    bool blocks(int polygonId, const Vec2& a, const Vec2& b, const Node* na, const Node* nb) const;
+    bool sameShape(const Polygon& p1, const Polygon& p2) const;
+    void connectNode(int i);
+};
+
+#endif
@@ -1,8 +1,23 @@
 HEADERS += geometry/Line.h \
     geometry/Box.h \
-    geometry/Polygon.h
+    geometry/Polygon.h \
+    geometry/VisibilityGraph.h \
+    geometry/SweptFootprint.h \
+    geometry/SegmentSet.h \
+    geometry/Hull.h \
+    geometry/PolygonSet.h \
+    geometry/ContourSimplifier.h \
+    geometry/SweepAndPrune.h \
+    geometry/GeometryUtil.h
 SOURCES += geometry/Line.cpp \
     geometry/Box.cpp \
-    geometry/Polygon.cpp
+    geometry/Polygon.cpp \
+    geometry/VisibilityGraph.cpp \
+    geometry/SweptFootprint.cpp \
+    geometry/SegmentSet.cpp \
+    geometry/Hull.cpp \
+    geometry/PolygonSet.cpp \
+    geometry/ContourSimplifier.cpp \
+    geometry/SweepAndPrune.cpp
 
 
@@ -2,6 +2,7 @@
 #include "blackboard/Config.h"
 #include "blackboard/State.h"
 #include "blackboard/Command.h"
+#include "blackboard/Snapshot.h"
 #include "globals.h"
 #include "util/ColorUtil.h"
 
@@ -10,6 +11,7 @@ CameraViewWidget::CameraViewWidget(QWidget *parent)
 {
     showPolygons = false;
     showFloorDetection = false;
+    shownEpoch = 0;
 
     setMinimumWidth(IMAGE_WIDTH);
     setMaximumWidth(IMAGE_WIDTH);
@@ -23,8 +25,9 @@ void CameraViewWidget::init()
 
 void CameraViewWidget::frameIndexChangedIn(int cfi)
 {
-    // Construct a new QImage from the raw data buffer in the state.
-    image = QImage((uchar*)state.colorBuffer, IMAGE_WIDTH, IMAGE_HEIGHT, QImage::Format_RGB888);
+    // Repaint only when a new snapshot was published.
+    if (snapshots.epoch() == shownEpoch)
+        return;
     update();
 }
 
@@ -42,17 +45,23 @@ void CameraViewWidget::toggleFloorDetection()
 
 void CameraViewWidget::paintEvent(QPaintEvent*)
 {
-    // Mutex against the robot control loop.
-    QMutexLocker locker(&state.gMutex);
+    // Draw the latest outputs of the robot control loop without locking the state.
+    const Snapshot& s = snapshots.acquire();
+    shownEpoch = s.epoch;
 
     // Instantiate a QPainter.
     QPainter painter(this);
 
-    // Draw the camera image onto the widget.
-    painter.drawImage(QPoint(), image);
+    // Draw the camera image onto the widget. The image wraps the color buffer of the
+    // snapshot, which stays unchanged while it is drawn.
+    if (s.colorBuffer.size() >= IMAGE_WIDTH*IMAGE_HEIGHT)
+    {
+        QImage image((const uchar*)s.colorBuffer.constData(), IMAGE_WIDTH, IMAGE_HEIGHT, QImage::Format_RGB888);
+        painter.drawImage(QPoint(), image);
+    }
 
     // Draw the floor detection visualization onto the camera image.
     if (showFloorDetection)
-        state.sampleGrid.drawSamples(&painter);
+        s.sampleGrid.drawSamples(&painter);
 }
 
@@ -8,7 +8,7 @@ class CameraViewWidget : public QWidget
 {
     Q_OBJECT
 
-    QImage image;
+    quint64 shownEpoch; // The epoch of the snapshot shown last.
 
 public:
     bool showPolygons;
@@ -3,6 +3,7 @@
 #include "blackboard/State.h"
 #include "blackboard/Config.h"
 #include "blackboard/StateUtil.h"
+#include "blackboard/Telemetry.h"
 #include "globals.h"
 
 Curve::Curve()
@@ -19,7 +20,7 @@ Curve::Curve()
 double Curve::valueAt(double t)
 {
 	int nearestIndex = findIndex(t - transform.dx());
-	return state[nearestIndex](stateMemberId);
+	return telemetry.value(nearestIndex, stateMemberId);
 }
 
 // Returns the transformed curve value at time mark t. The time t is given in seconds relative
@@ -41,10 +42,10 @@ double Curve::interpolatedValueAt(double t)
 {
 	int nearestIndex = findIndex(t - transform.dx());
 
-	double x1 = state[nearestIndex].time;
-	double x2 = state[nearestIndex-1].time;
-	double y1 = state[nearestIndex](stateMemberId);
-	double y2 = state[nearestIndex-1](stateMemberId);
+	double x1 = telemetry.time(nearestIndex);
+	double x2 = telemetry.time(nearestIndex-1);
+	double y1 = telemetry.value(nearestIndex, stateMemberId);
+	double y2 = telemetry.value(nearestIndex-1, stateMemberId);
 	double x = qBound(x1, t, x2);
 	double y = y1 + (y2-y1)*(x-x1)/(x2-x1);
 
@@ -66,7 +67,7 @@ double Curve::interpolatedTransformedValueAt(double t)
 	return y*transform.m22() + transform.dy();
 }
 
-// Returns the floor state index for the given time t.
+// Returns the floor telemetry index for the given time t.
 int Curve::findIndex(double t)
 {
 	return stateUtil.findIndex(t);
@@ -155,7 +156,7 @@ void Curve::draw(QPainter* painter)
 
     // When the view is zoomed out, multiple states map to the same pixel and there is no point
     // drawing all of them. To avoid excessive plotting, determine the stride to step through
-    // the state history.
+    // the telemetry.
 	int stride = 1;
 	stride = qMax(1, qFloor(1.0/(painter->transform().m11()*config.rcIterationTime)));
     indices.clear();
@@ -171,14 +172,14 @@ void Curve::draw(QPainter* painter)
 
 	// Draw the actual curve.
 	double x1,y1,x2,y2;
-	x2 = state[indices[0]].time;
-	y2 = state[indices[0]](stateMemberId);
+	x2 = telemetry.time(indices[0]);
+	y2 = telemetry.value(indices[0], stateMemberId);
 	for (int i = 1; i < indices.size(); i++)
 	{
 		x1 = x2;
 		y1 = y2;
-		x2 = state[indices[i]].time;
-		y2 = state[indices[i]](stateMemberId);
+		x2 = telemetry.time(indices[i]);
+		y2 = telemetry.value(indices[i], stateMemberId);
         if (x1 == x1 && x2 == x2 && y1 == y1 && y2 == y2) // check for nan
 			painter->drawLine(QPointF(x1, y1), QPointF(x2, y2));
 	}
@@ -1,5 +1,6 @@
 #include "GraphWidget.h"
 #include "blackboard/StateUtil.h"
+#include "blackboard/Telemetry.h"
 #include <math.h>
 
 GraphWidget::GraphWidget(QWidget *parent)
@@ -130,7 +131,7 @@ void GraphWidget::exportData()
 	for (int t = startIndex; t > endIndex; t--)
 	{
 		foreach (int id, idsOfTheCurvesToShow)
-			out << state[t](id) << " ";
+			out << telemetry.value(t, id) << " ";
 		out << "\n";
 	}
 
@@ -140,10 +141,15 @@ void GraphWidget::exportData()
 }
 
 // Sets the time offset t that defines what value in the time stream state.time
-// corresponds to the 0 value of the x axis.
+// corresponds to the 0 value of the x axis. The frame index cfi is also the index
+// of the frame in the telemetry. Frames that are not buffered, such as the frames
+// of a recording during playback, are at the time of the current state.
 void GraphWidget::frameIndexChangedIn(int cfi)
 {
-    this->t = state[cfi].time;
+    if (cfi > 0 && cfi < telemetry.size())
+        this->t = telemetry.time(cfi);
+    else
+        this->t = state.time;
 	update();
 }
 
@@ -433,7 +439,7 @@ void GraphWidget::paintEvent(QPaintEvent*)
 	}
 
 	// No data guard.
-	if (state.size() == 0)
+	if (telemetry.size() == 0)
 		return;
 
 	// Offset by t before drawing the curves.
@@ -450,7 +456,7 @@ void GraphWidget::paintEvent(QPaintEvent*)
 	{
         pen.setColor(QColor("grey"));
         painter.setPen(pen);
-		x = qBound(state[state.size()-1].time, mappedMouse.x()+t, state.time);
+		x = qBound(telemetry.time(telemetry.size()-1), mappedMouse.x()+t, state.time);
         painter.drawLine(QPointF(x, boundingBox.bottom()), QPointF(x, boundingBox.top()));
 	}
 
@@ -464,7 +470,7 @@ void GraphWidget::paintEvent(QPaintEvent*)
 		// Draw the mouse marker on the curve.
 		if (mousePresent)
 		{
-			x = qBound(state[state.size()-1].time, mappedMouse.x()+t, state.time);
+			x = qBound(telemetry.time(telemetry.size()-1), mappedMouse.x()+t, state.time);
 			y = qBound(boundingBox.bottom(), curves[id].transformedValueAt(x), boundingBox.top());
 			painter.drawEllipse(QPointF(x,y), (4.0+2.0*curves[id].highlight)*screenScale.x(), (4.0+2.0*curves[id].highlight)*screenScale.y());
 		}
@@ -488,7 +494,7 @@ void GraphWidget::paintEvent(QPaintEvent*)
 		// Draw the mouse marker value.
 		if (mousePresent)
 		{
-			x = qBound(state[state.size()-1].time-t, mappedMouse.x(), state.time-t);
+			x = qBound(telemetry.time(telemetry.size()-1)-t, mappedMouse.x(), state.time-t);
 			y = curves[id].transformedValueAt(mappedMouse.x()+t);
 			mp = screenTransform.map(QPointF(x, y)) + QPointF(10,-4);
 			mp.ry() = qBound((double)(fontHeight), mp.y(), (double)(height()-1));
@@ -506,7 +512,7 @@ void GraphWidget::paintEvent(QPaintEvent*)
 	// Show the current time on the bottom.
 	if (mousePresent)
 	{
-		x = qBound(state[state.size()-1].time-t, mappedMouse.x(), state.time-t);
+		x = qBound(telemetry.time(telemetry.size()-1)-t, mappedMouse.x(), state.time-t);
 		y = -height();
 		mp = screenTransform.map(QPointF(x, y)) + QPointF(10,0);
 		mp.ry() = qBound((double)(fontHeight), mp.y(), (double)(height()-4));
@@ -121,26 +121,26 @@ void OpenGLWidget::toggleFloorDetection()
 
 void OpenGLWidget::draw()
 {
-    // Mutex against the step of robot control loop.
-    QMutexLocker locker(&state.gMutex);
+    // Draw the latest outputs of the robot control loop without locking the state.
+    const Snapshot& s = snapshots.acquire();
 
     if (showFloor)
         drawFloor();
 
     if (showCameraTransform)
-        drawCameraTransform();
+        drawCameraTransform(s);
 
     if (showPointCloud)
-        drawPoints();
+        drawPoints(s);
 
     if(showFloorDetection)
-        drawFloorDetection();
+        drawFloorDetection(s);
 
     if (showOccupancyMap)
-        drawOccupancyMap();
+        drawOccupancyMap(s);
 
     if (showPolygons)
-        drawPolygons();
+        drawPolygons(s);
 
 	// Show recording state.
 	if (recording)
@@ -158,19 +158,19 @@ void OpenGLWidget::draw()
 
     // On the bottom: show the frame id and debug information.
 	glColor3f(0.3, 0.3, 0.8);
-    drawText(10, this->height() - 10, "frame: " + QString().number(state.frameId) +
-            "/" + QString().number(state.size()) +
-             "  polygons: " + QString().number(state.numPolygons) +
-             "  vertices: " + QString().number(state.numVertices),
+    drawText(10, this->height() - 10, "frame: " + QString().number(s.frameId) +
+            "/" + QString().number(s.historySize) +
+             "  polygons: " + QString().number(s.numPolygons) +
+             "  vertices: " + QString().number(s.numVertices),
 			QFont("Helvetica", 14, QFont::Light));
 }
 
 // Draws the height map.
-void OpenGLWidget::drawOccupancyMap()
+void OpenGLWidget::drawOccupancyMap(const Snapshot& s)
 {
     glPushMatrix();
     glTranslated(0, 0, config.heightmapDz);
-    state.gridModel.draw();
+    s.gridModel.draw();
     glPopMatrix();
 }
 
@@ -201,22 +201,22 @@ void OpenGLWidget::drawFloor()
 }
 
 // Draws the computed floor normals.
-void OpenGLWidget::drawFloorDetection()
+void OpenGLWidget::drawFloorDetection(const Snapshot& s)
 {
     glPushMatrix();
-    glMultMatrixd(state.cameraTransform);
+    glMultMatrixd(s.cameraTransform);
     glTranslated(0, 0, config.floorDz);
 
     // Sample floor normals.
-    state.sampleGrid.drawSamples();
+    s.sampleGrid.drawSamples();
 
     // The final floor normal.
     if (true)
     {
         glPushMatrix();
-        glTranslated(state.floor.p.x, state.floor.p.y, state.floor.p.z);
+        glTranslated(s.floor.p.x, s.floor.p.y, s.floor.p.z);
         glColor3f(0.0, 0.0, 1.0);
-        QGLViewer::drawArrow(qglviewer::Vec(0,0,0), qglviewer::Vec(state.floor.n.normalized(0.5)), 0.01);
+        QGLViewer::drawArrow(qglviewer::Vec(0,0,0), qglviewer::Vec(s.floor.n.normalized(0.5)), 0.01);
         glPopMatrix();
     }
 
@@ -224,36 +224,39 @@ void OpenGLWidget::drawFloorDetection()
 }
 
 // Draws the camera transform.
-void OpenGLWidget::drawCameraTransform()
+void OpenGLWidget::drawCameraTransform(const Snapshot& s)
 {
     glPushMatrix();
-    glMultMatrixd(state.cameraTransform);
+    glMultMatrixd(s.cameraTransform);
     QGLViewer::drawAxis(0.3);
     glPopMatrix();
 }
 
 // Draw the point buffer.
-void OpenGLWidget::drawPoints()
+void OpenGLWidget::drawPoints(const Snapshot& s)
 {
+    if (s.pointBuffer.size() < NUMBER_OF_POINTS || s.colorBuffer.size() < NUMBER_OF_POINTS)
+        return;
+
     glPushMatrix();
-    glMultMatrixd(state.cameraTransform);
+    glMultMatrixd(s.cameraTransform);
     glPointSize(3);
     glBegin(GL_POINTS);
 
     for (int i = 0; i < NUMBER_OF_POINTS; i++)
     {
-        if (state.pointBuffer[i].isNull())
+        if (s.pointBuffer[i].isNull())
             continue;
 
         if (!showDiscardedPoints)
         {
-            Vec3 p = state.cameraTransform*state.pointBuffer[i];
+            Vec3 p = s.cameraTransform*s.pointBuffer[i];
             if (p.z < config.floor)
                 continue;
         }
 
-        glColor3ubv((GLubyte*)&state.colorBuffer[i]);
-        glVertex3dv(state.pointBuffer[i]);
+        glColor3ubv((GLubyte*)&s.colorBuffer[i]);
+        glVertex3dv(s.pointBuffer[i]);
     }
 
     glEnd();
@@ -261,17 +264,17 @@ void OpenGLWidget::drawPoints()
 }
 
 // Draws the polygons.
-void OpenGLWidget::drawPolygons()
+void OpenGLWidget::drawPolygons(const Snapshot& s)
 {
     glPushMatrix();
     glLineWidth(5);
     glTranslated(0, 0, config.polygonsDz);
-    for (int i = 0; i < state.polygons.size(); i++)
+    for (int i = 0; i < s.polygonSet.size(); i++)
     {
         //QColor c = colorUtil.sampleUniformColor();
         //glColor3f(c.redF(), c.greenF(), c.blueF());
         glColor3f(1, 0, 0);
-        state.polygons[i].draw();
+        s.polygonSet.polygon(i).draw();
     }
     glPopMatrix();
 }
@@ -4,6 +4,7 @@
 #include "MessageQueue.h"
 #include <QGLViewer/qglviewer.h>
 #include "blackboard/State.h"
+#include "blackboard/Snapshot.h"
 #include "util/StopWatch.h"
 
 using namespace qglviewer;
@@ -50,12 +51,12 @@ protected:
 	void draw();
 
 private:
-    void drawPoints();
-    void drawCameraTransform();
-    void drawOccupancyMap();
+    void drawPoints(const Snapshot& s);
+    void drawCameraTransform(const Snapshot& s);
+    void drawOccupancyMap(const Snapshot& s);
     void drawFloor();
-    void drawPolygons();
-    void drawFloorDetection();
+    void drawPolygons(const Snapshot& s);
+    void drawFloorDetection(const Snapshot& s);
 };
 
 #endif
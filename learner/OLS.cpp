@@ -1,9 +1,11 @@
 #include "OLS.h"
 #include <QColor>
 #include "blackboard/Config.h"
-#include "util/GLlib.h"
 #include "util/ColorUtil.h"
+#ifndef HEADLESS
+#include "util/GLlib.h"
 #include <GL/glu.h>
+#endif
 
 // This is an ordinary (linear) least squares regressor.
 // Use addDataPoint() to feed the OLS with data. Then, use init() to initialze
@@ -105,6 +107,7 @@ void OLS::print() const
 // OpenGL drawing code that draws the location of the stored data points.
 void OLS::draw(uint sampleFactor) const
 {
+#ifndef HEADLESS
     glPushMatrix();
     glPointSize(3);
     glColor3f(0,0,0);
@@ -114,6 +117,7 @@ void OLS::draw(uint sampleFactor) const
         glVertex3dv(data.at(k));
     glEnd();
     glPopMatrix();
+#endif
 }
 
 QDebug operator<<(QDebug dbg, const OLS &o)
@@ -0,0 +1,36 @@
+# Microbenchmarks of the kernels of the pipeline. Builds without OpenGL and QGLViewer.
+# qmake polyperception-bench.pro -o Makefile.bench && make -f Makefile.bench
+DEFINES += HEADLESS
+
+include(blackboard/blackboard.pri)
+include(util/util.pri)
+include(geometry/geometry.pri)
+include(learner/learner.pri)
+include(recording/recording.pri)
+include(bench/bench.pri)
+
+TEMPLATE = app
+TARGET = polyperception-bench
+QT += core \
+    gui
+HEADERS += Pipeline.h \
+    Profiler.h \
+    GridModel.h \
+    globals.h \
+    SampleGrid.h \
+    PolygonMap.h
+SOURCES += Pipeline.cpp \
+    Profiler.cpp \
+    GridModel.cpp \
+    SampleGrid.cpp \
+    PolygonMap.cpp
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG += warn_off
+CONFIG += c++11
+QMAKE_CXXFLAGS_RELEASE -= -O2
+QMAKE_CXXFLAGS_RELEASE += -O3
+
+LIBS += -L/usr/lib -L/usr/local/lib
+LIBS += -L/usr/include/opencv2 -lopencv_imgproc -lopencv_core -lz -ltbb
+LIBS += -L/usr/include/armadillo_bits -larmadillo -lopenblas -llapack -lblas
@@ -0,0 +1,44 @@
+# Headless command line runner of the pipeline. Builds without OpenGL and QGLViewer.
+# qmake polyperception-cli.pro -o Makefile.cli && make -f Makefile.cli
+DEFINES += HEADLESS
+
+include(blackboard/blackboard.pri)
+include(util/util.pri)
+include(geometry/geometry.pri)
+include(learner/learner.pri)
+include(recording/recording.pri)
+include(cli/cli.pri)
+
+TEMPLATE = app
+TARGET = polyperception-cli
+QT += core \
+    gui
+HEADERS += RobotControl.h \
+    Pipeline.h \
+    Profiler.h \
+    BatchProcessor.h \
+    GridModel.h \
+    globals.h \
+    SampleGrid.h \
+    PolygonMap.h \
+    PolygonRegistration.h \
+    PolygonStabilizer.h
+SOURCES += RobotControl.cpp \
+    Pipeline.cpp \
+    Profiler.cpp \
+    BatchProcessor.cpp \
+    GridModel.cpp \
+    SampleGrid.cpp \
+    PolygonMap.cpp \
+    PolygonRegistration.cpp \
+    PolygonStabilizer.cpp
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG += warn_off
+CONFIG += c++11
+QMAKE_CXXFLAGS_RELEASE -= -O2
+QMAKE_CXXFLAGS_RELEASE += -O3
+
+LIBS += -L/usr/lib -L/usr/local/lib
+LIBS += -L/usr/include/opencv2 -lopencv_imgproc -lopencv_core -lz -ltbb
+LIBS += -L/usr/include/armadillo_bits -larmadillo -lopenblas -llapack -lblas
@@ -0,0 +1,36 @@
+# Regression tests. Builds without OpenGL and QGLViewer.
+# qmake polyperception-tests.pro -o Makefile.tests && make -f Makefile.tests && ./polyperception-tests
+DEFINES += HEADLESS
+
+include(blackboard/blackboard.pri)
+include(util/util.pri)
+include(geometry/geometry.pri)
+include(learner/learner.pri)
+include(recording/recording.pri)
+include(tests/tests.pri)
+
+TEMPLATE = app
+TARGET = polyperception-tests
+QT += core \
+    gui
+HEADERS += Pipeline.h \
+    Profiler.h \
+    GridModel.h \
+    globals.h \
+    SampleGrid.h \
+    PolygonMap.h \
+    PolygonStabilizer.h
+SOURCES += Pipeline.cpp \
+    Profiler.cpp \
+    GridModel.cpp \
+    SampleGrid.cpp \
+    PolygonMap.cpp \
+    PolygonStabilizer.cpp
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG += warn_off
+CONFIG += c++11
+
+LIBS += -L/usr/lib -L/usr/local/lib
+LIBS += -L/usr/include/opencv2 -lopencv_imgproc -lopencv_core -lz -ltbb
+LIBS += -L/usr/include/armadillo_bits -larmadillo -lopenblas -llapack -lblas
@@ -0,0 +1,188 @@
+#include "AsyncRecorder.h"
+#include <QDebug>
+#include <QElapsedTimer>
+
+// Minimum time between two commits of the index in milliseconds.
+static const int COMMIT_INTERVAL = 1000;
+
+// The AsyncRecorder keeps file I/O and compression out of the timed control step.
+// enqueue() only stores references to the shared point and color buffers of the frame
+// in a ring of queueSize slots and publishes the slot by advancing the head counter.
+// The writer thread appends all queued frames to the recording, updates the index at most
+// once per second, and releases the slots by advancing the tail counter. The buffers are
+// copy-on-write, so the sensor interface can fill the next frame while the queued one
+// is written. When the queue is full, the frame is either dropped or the control thread
+// waits for the writer, depending on the FullPolicy. The counters tell how many frames
+// took which path.
+
+AsyncRecorder::AsyncRecorder()
+{
+    head = 0;
+    tail = 0;
+    running = false;
+    policy = DropNewest;
+    enqueuedFrames = 0;
+    droppedFrames = 0;
+    blockedFrames = 0;
+    writtenFrames = 0;
+    failedFrames = 0;
+}
+
+AsyncRecorder::~AsyncRecorder()
+{
+    close();
+}
+
+// Opens the recording file for appending and starts the writer thread.
+bool AsyncRecorder::open(QString fileName, int numPoints, int queueSize, FullPolicy policy, bool compressed, bool withColor)
+{
+    close();
+
+    if (!writer.open(fileName, numPoints, true))
+        return false;
+    writer.setCompression(compressed, withColor);
+
+    queue.clear();
+    queue.resize(qMax(1, queueSize));
+    head = 0;
+    tail = 0;
+    this->policy = policy;
+    enqueuedFrames = 0;
+    droppedFrames = 0;
+    blockedFrames = 0;
+    writtenFrames = 0;
+    failedFrames = 0;
+
+    running = true;
+    start();
+    return true;
+}
+
+// Writes the frames that are still queued, stops the writer thread and closes the file.
+void AsyncRecorder::close()
+{
+    running = false;
+    wait();
+    writer.close();
+    queue.clear();
+}
+
+bool AsyncRecorder::isOpen() const
+{
+    return running;
+}
+
+// Queues a frame for writing. The channels are copied into the queue slot.
+// A GRID channel is expected with uncompressed cells and compressed by the writer thread.
+// Returns false if the frame was dropped. Must only be called from one thread.
+bool AsyncRecorder::enqueue(int frameId, double time, const SharedBuffer<Vec3>& points, const SharedBuffer<Pixel>& colors,
+                            const RecordingChannels* channels)
+{
+    if (!running)
+        return false;
+
+    quint64 h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= (quint64)queue.size())
+    {
+        if (policy == DropNewest)
+        {
+            droppedFrames++;
+            return false;
+        }
+
+        blockedFrames++;
+        while (h - tail.load(std::memory_order_acquire) >= (quint64)queue.size())
+            QThread::usleep(100);
+    }
+
+    Frame& frame = queue[h % queue.size()];
+    frame.frameId = frameId;
+    frame.time = time;
+    frame.points = points;
+    frame.colors = colors;
+    if (channels != 0)
+        frame.channels = *channels;
+    else
+        frame.channels.clear();
+    head.store(h+1, std::memory_order_release);
+    enqueuedFrames++;
+    return true;
+}
+
+// The writer thread. The index is committed at most once per COMMIT_INTERVAL
+// milliseconds, since every commit leaves the replaced index behind in the file.
+// The commit also happens while the queue is empty, so that the frames of the
+// last burst do not stay out of the index while the recording is paused.
+void AsyncRecorder::run()
+{
+    QElapsedTimer sinceCommit;
+    sinceCommit.start();
+    while (true)
+    {
+        if (writer.isDirty() && sinceCommit.elapsed() >= COMMIT_INTERVAL)
+        {
+            writer.commit();
+            sinceCommit.restart();
+        }
+
+        // Read running before head, so that the last frames enqueued before close()
+        // are still written.
+        bool stop = !running;
+        quint64 t = tail.load(std::memory_order_relaxed);
+        quint64 h = head.load(std::memory_order_acquire);
+        if (t == h)
+        {
+            if (stop)
+                break;
+            QThread::msleep(2);
+            continue;
+        }
+
+        for (; t != h; t++)
+        {
+            Frame& frame = queue[t % queue.size()];
+            frame.channels.compress(RecordingChannel::GRID, sizeof(RecordingGrid));
+            if (writer.appendFrame(frame.frameId, frame.time, frame.points.constData(), frame.colors.constData(),
+                                   &frame.channels, false))
+                writtenFrames++;
+            else
+                failedFrames++;
+
+            // Release the buffers before the slot is handed back to the producer.
+            frame.points.clear();
+            frame.colors.clear();
+            tail.store(t+1, std::memory_order_release);
+        }
+    }
+}
+
+// Returns the number of frames waiting in the queue.
+int AsyncRecorder::queued() const
+{
+    return head.load() - tail.load();
+}
+
+int AsyncRecorder::enqueued() const
+{
+    return enqueuedFrames;
+}
+
+int AsyncRecorder::dropped() const
+{
+    return droppedFrames;
+}
+
+int AsyncRecorder::blocked() const
+{
+    return blockedFrames;
+}
+
+int AsyncRecorder::written() const
+{
+    return writtenFrames;
+}
+
+int AsyncRecorder::failed() const
+{
+    return failedFrames;
+}
@@ -0,0 +1,68 @@
+#ifndef ASYNCRECORDER_H
+#define ASYNCRECORDER_H
+#include <QThread>
+#include <atomic>
+#include "recording/Recording.h"
+#include "util/SharedBuffer.h"
+
+// Writes frames to a recording file in a background thread.
+// The control thread hands frames over through a bounded single producer,
+// single consumer queue without taking a lock.
+class AsyncRecorder : public QThread
+{
+public:
+
+    enum FullPolicy
+    {
+        DropNewest, // Reject the new frame when the queue is full.
+        Block // Wait in enqueue() until the writer has made room.
+    };
+
+private:
+
+    struct Frame
+    {
+        int frameId = 0;
+        double time = 0;
+        SharedBuffer<Vec3> points;
+        SharedBuffer<Pixel> colors;
+        RecordingChannels channels;
+    };
+
+    RecordingWriter writer;
+    Vector<Frame> queue;
+    std::atomic<quint64> head; // Number of frames enqueued so far. Written by the producer.
+    std::atomic<quint64> tail; // Number of frames written so far. Written by the consumer.
+    std::atomic<bool> running;
+    FullPolicy policy;
+
+    std::atomic<int> enqueuedFrames;
+    std::atomic<int> droppedFrames;
+    std::atomic<int> blockedFrames;
+    std::atomic<int> writtenFrames;
+    std::atomic<int> failedFrames;
+
+public:
+
+    AsyncRecorder();
+    ~AsyncRecorder();
+
+    bool open(QString fileName, int numPoints, int queueSize, FullPolicy policy, bool compressed, bool withColor);
+    void close();
+    bool isOpen() const;
+
+    bool enqueue(int frameId, double time, const SharedBuffer<Vec3>& points, const SharedBuffer<Pixel>& colors,
+                 const RecordingChannels* channels = 0);
+
+    int queued() const;
+    int enqueued() const;
+    int dropped() const;
+    int blocked() const;
+    int written() const;
+    int failed() const;
+
+private:
+    void run();
+};
+
+#endif // ASYNCRECORDER_H
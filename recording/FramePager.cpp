@@ -0,0 +1,215 @@
+#include "FramePager.h"
+#include <QDebug>
+
+// The FramePager lets the player browse recordings of any length with bounded memory.
+// Opening a recording only maps the file. A frame is decoded when the player asks for
+// it and kept in an LRU cache of cacheSize frames. After each request, the prefetch
+// thread decodes the next prefetch frames in the playback direction, so that during
+// playback the requested frame is usually already in the cache. The decoded buffers
+// are shared copy-on-write with the state, so handing out a cached frame copies nothing.
+
+FramePager::FramePager()
+{
+    useCounter = 0;
+    prefetchCount = 0;
+    cursor = 0;
+    direction = 1;
+    requestCounter = 0;
+    servedCounter = 0;
+    stopRequested = false;
+    hits = 0;
+    misses = 0;
+}
+
+FramePager::~FramePager()
+{
+    close();
+}
+
+// Opens a recording and starts the prefetch thread.
+bool FramePager::open(QString fileName, int cacheSize, int prefetch)
+{
+    close();
+
+    if (!recording.open(fileName))
+        return false;
+
+    // The cache has to hold the current frame and the prefetched ones.
+    prefetchCount = qMax(0, prefetch);
+    cache.clear();
+    cache.resize(qMax(cacheSize, prefetchCount+2));
+    slotOfFrame.clear();
+    useCounter = 0;
+    requestCounter = 0;
+    servedCounter = 0;
+    hits = 0;
+    misses = 0;
+    stopRequested = false;
+
+    if (prefetchCount > 0)
+        start(QThread::LowPriority);
+
+    return true;
+}
+
+// Stops the prefetch thread, releases the cache and unmaps the recording.
+void FramePager::close()
+{
+    mutex.lock();
+    stopRequested = true;
+    wakeUp.wakeAll();
+    mutex.unlock();
+    wait();
+
+    cache.clear();
+    slotOfFrame.clear();
+    recording.close();
+}
+
+bool FramePager::isOpen() const
+{
+    return recording.isOpen();
+}
+
+int FramePager::numFrames() const
+{
+    return recording.numFrames();
+}
+
+int FramePager::frameId(int i) const
+{
+    return recording.frameId(i);
+}
+
+double FramePager::time(int i) const
+{
+    return recording.time(i);
+}
+
+int FramePager::cacheHits() const
+{
+    QMutexLocker locker(&mutex);
+    return hits;
+}
+
+int FramePager::cacheMisses() const
+{
+    QMutexLocker locker(&mutex);
+    return misses;
+}
+
+// Provides frame i in the given buffers. The frame is taken from the cache or
+// decoded on the spot. direction is +1 or -1 and tells the prefetch thread
+// in which direction to read ahead.
+bool FramePager::load(int i, int direction, SharedBuffer<Vec3>& points, SharedBuffer<Pixel>& colors)
+{
+    if (!isOpen() || i < 0 || i >= numFrames())
+        return false;
+
+    if (!lookup(i, points, colors))
+    {
+        SharedBuffer<Vec3> p;
+        SharedBuffer<Pixel> c;
+        decode(i, p, c);
+        insert(i, p, c);
+        points = p;
+        colors = c;
+    }
+
+    mutex.lock();
+    cursor = i;
+    this->direction = direction < 0 ? -1 : 1;
+    requestCounter++;
+    wakeUp.wakeAll();
+    mutex.unlock();
+
+    return true;
+}
+
+// The prefetch thread. It decodes the frames ahead of the cursor that are not cached yet.
+// A new request interrupts the read ahead of the previous one.
+void FramePager::run()
+{
+    mutex.lock();
+    while (!stopRequested)
+    {
+        if (servedCounter == requestCounter)
+        {
+            wakeUp.wait(&mutex);
+            continue;
+        }
+
+        servedCounter = requestCounter;
+        int c = cursor;
+        int d = direction;
+
+        for (int k = 1; k <= prefetchCount && !stopRequested && servedCounter == requestCounter; k++)
+        {
+            int f = c + k*d;
+            if (f < 0 || f >= recording.numFrames())
+                break;
+            if (slotOfFrame.contains(f))
+            {
+                cache[slotOfFrame.value(f)].lastUse = ++useCounter;
+                continue;
+            }
+
+            mutex.unlock();
+            SharedBuffer<Vec3> p;
+            SharedBuffer<Pixel> col;
+            decode(f, p, col);
+            insert(f, p, col);
+            mutex.lock();
+        }
+    }
+    mutex.unlock();
+}
+
+// Looks up frame i in the cache.
+bool FramePager::lookup(int i, SharedBuffer<Vec3>& points, SharedBuffer<Pixel>& colors)
+{
+    QMutexLocker locker(&mutex);
+    if (!slotOfFrame.contains(i))
+    {
+        misses++;
+        return false;
+    }
+
+    Slot& slot = cache[slotOfFrame.value(i)];
+    slot.lastUse = ++useCounter;
+    points = slot.points;
+    colors = slot.colors;
+    hits++;
+    return true;
+}
+
+// Puts frame i into the least recently used cache slot.
+void FramePager::insert(int i, const SharedBuffer<Vec3>& points, const SharedBuffer<Pixel>& colors)
+{
+    QMutexLocker locker(&mutex);
+    if (slotOfFrame.contains(i) || cache.isEmpty())
+        return;
+
+    int lru = 0;
+    for (int k = 1; k < cache.size(); k++)
+        if (cache[k].lastUse < cache[lru].lastUse)
+            lru = k;
+
+    Slot& slot = cache[lru];
+    if (slot.frame >= 0)
+        slotOfFrame.remove(slot.frame);
+    slot.frame = i;
+    slot.lastUse = ++useCounter;
+    slot.points = points;
+    slot.colors = colors;
+    slotOfFrame.insert(i, lru);
+}
+
+// Decodes frame i into newly allocated buffers. Decoding does not touch the cache,
+// so it runs without holding the lock.
+void FramePager::decode(int i, SharedBuffer<Vec3>& points, SharedBuffer<Pixel>& colors) const
+{
+    points.resize(recording.numPoints());
+    colors.resize(recording.numPoints());
+    recording.readFrame(i, points.data(), colors.data());
+}
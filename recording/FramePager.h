@@ -0,0 +1,66 @@
+#ifndef FRAMEPAGER_H
+#define FRAMEPAGER_H
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include "recording/Recording.h"
+#include "util/SharedBuffer.h"
+
+// Pages the frames of a recording into a bounded LRU cache on demand.
+// A background thread reads ahead in the direction of playback.
+class FramePager : public QThread
+{
+    struct Slot
+    {
+        int frame = -1; // -1 marks an unused slot.
+        quint64 lastUse = 0;
+        SharedBuffer<Vec3> points;
+        SharedBuffer<Pixel> colors;
+    };
+
+    Recording recording;
+    Vector<Slot> cache;
+    QHash<int, int> slotOfFrame;
+    quint64 useCounter;
+    int prefetchCount;
+
+    // Prefetch request.
+    int cursor;
+    int direction;
+    quint64 requestCounter;
+    quint64 servedCounter;
+    bool stopRequested;
+
+    int hits;
+    int misses;
+
+    mutable QMutex mutex;
+    QWaitCondition wakeUp;
+
+public:
+
+    FramePager();
+    ~FramePager();
+
+    bool open(QString fileName, int cacheSize, int prefetch);
+    void close();
+    bool isOpen() const;
+
+    int numFrames() const;
+    int frameId(int i) const;
+    double time(int i) const;
+
+    bool load(int i, int direction, SharedBuffer<Vec3>& points, SharedBuffer<Pixel>& colors);
+
+    int cacheHits() const;
+    int cacheMisses() const;
+
+private:
+    void run();
+    bool lookup(int i, SharedBuffer<Vec3>& points, SharedBuffer<Pixel>& colors);
+    void insert(int i, const SharedBuffer<Vec3>& points, const SharedBuffer<Pixel>& colors);
+    void decode(int i, SharedBuffer<Vec3>& points, SharedBuffer<Pixel>& colors) const;
+};
+
+#endif // FRAMEPAGER_H
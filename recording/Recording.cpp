@@ -0,0 +1,831 @@
+#include "Recording.h"
+#include "globals.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QtGlobal>
+#include <string.h>
+#include <thread>
+#include <atomic>
+
+// The recording stores the point cloud frames of a session in a flat binary file that
+// can be memory mapped. Unlike the QDataStream based state history file, which has to be
+// parsed value by value from front to back, any frame of a recording can be located in
+// constant time through the frame index and read in place without parsing.
+
+static_assert(sizeof(RecordingHeader) == 32, "unexpected RecordingHeader layout");
+static_assert(sizeof(RecordingIndexEntry) == 32, "unexpected RecordingIndexEntry layout");
+static_assert(sizeof(Pixel) == 3, "unexpected Pixel layout");
+static_assert(sizeof(RecordingChannel) == 24, "unexpected RecordingChannel layout");
+
+// The number of independently compressed chunks per frame.
+static const int NUMBER_OF_CHUNKS = 8;
+
+// Returns the byte size of a raw frame block with n points.
+static quint64 frameBlockSize(int n)
+{
+    quint64 size = quint64(n)*3*sizeof(double) + quint64(n)*sizeof(Pixel);
+    return (size + 7) & ~quint64(7);
+}
+
+// Runs f(k) for k = 0..n-1 on up to n threads, or on the calling thread only
+// if parallel is false.
+template <typename F>
+static void parallelFor(int n, F f, bool parallel = true)
+{
+    int workers = parallel ? qBound(1, (int)std::thread::hardware_concurrency(), n) : 1;
+    std::vector<std::thread> threads;
+    for (int w = 1; w < workers; w++)
+        threads.emplace_back([=]{for (int k = w; k < n; k += workers) f(k);});
+    for (int k = 0; k < n; k += workers)
+        f(k);
+    for (uint w = 0; w < threads.size(); w++)
+        threads[w].join();
+}
+
+// Quantizes a coordinate to signed 16 bit millimeters.
+static qint16 quantize(double v)
+{
+    return (qint16)qBound(-32767, qRound(v*1000.0), 32767);
+}
+
+// Encodes m points into a compressed chunk. The quantized coordinates are delta coded and
+// split into byte planes, which makes them compress much better than the interleaved values.
+static void encodeChunk(const Vec3* points, const Pixel* colors, int m, QByteArray& out)
+{
+    thread_local Vector<uchar> planes;
+    planes.resize(6*m + (colors ? 3*m : 0));
+    uchar* low = &planes[0];
+    uchar* high = low + 3*m;
+    for (int d = 0; d < 3; d++)
+    {
+        qint16 last = 0;
+        for (int i = 0; i < m; i++)
+        {
+            qint16 q = quantize(points[i][d]);
+            quint16 delta = quint16(q) - quint16(last);
+            last = q;
+            low[d*m+i] = delta & 0xFF;
+            high[d*m+i] = delta >> 8;
+        }
+    }
+    if (colors)
+    {
+        uchar* c = &planes[6*m];
+        for (int i = 0; i < m; i++)
+        {
+            c[i] = colors[i].r;
+            c[m+i] = colors[i].g;
+            c[2*m+i] = colors[i].b;
+        }
+    }
+    out = qCompress(planes.data(), planes.size(), 1);
+}
+
+// Decodes a compressed chunk of m points. Returns false if the chunk is corrupt.
+static bool decodeChunk(const uchar* data, int size, int m, Vec3* points, Pixel* colors)
+{
+    QByteArray planes = qUncompress(data, size);
+    if (planes.size() != 6*m + (colors ? 3*m : 0))
+        return false;
+
+    const uchar* low = (const uchar*)planes.data();
+    const uchar* high = low + 3*m;
+    for (int d = 0; d < 3; d++)
+    {
+        quint16 q = 0;
+        for (int i = 0; i < m; i++)
+        {
+            q += quint16(low[d*m+i] | (high[d*m+i] << 8));
+            points[i][d] = qint16(q) / 1000.0;
+        }
+    }
+    if (colors)
+    {
+        const uchar* c = low + 6*m;
+        for (int i = 0; i < m; i++)
+        {
+            colors[i].r = c[i];
+            colors[i].g = c[m+i];
+            colors[i].b = c[2*m+i];
+        }
+    }
+    return true;
+}
+
+void RecordingChannels::clear()
+{
+    channels.clear();
+    payload.clear();
+}
+
+int RecordingChannels::size() const
+{
+    return channels.size();
+}
+
+// Adds a channel and returns bytes of 8 byte aligned memory for its data.
+// The memory is valid until the next channel is added.
+void* RecordingChannels::add(int type, int bytes)
+{
+    RecordingChannel channel;
+    channel.type = type;
+    channel.reserved = 0;
+    channel.offset = payload.size()*sizeof(quint64);
+    channel.size = bytes;
+    channels << channel;
+
+    int words = (bytes + 7) / 8;
+    int begin = payload.size();
+    payload.resize(begin + words);
+    if (words > 0)
+        payload[begin+words-1] = 0; // Zero the padding.
+    return words > 0 ? &payload[begin] : 0;
+}
+
+// Adds a channel with a copy of the given data.
+void RecordingChannels::add(int type, const void* data, int bytes)
+{
+    void* p = add(type, bytes);
+    if (bytes > 0)
+        memcpy(p, data, bytes);
+}
+
+// Replaces the data of the channels of the given type, except for the first offset
+// bytes, with its qCompress'ed version. This allows to collect a channel uncompressed
+// in a timed thread and to compress it later in the thread that writes it.
+void RecordingChannels::compress(int type, int offset)
+{
+    RecordingChannels compressed;
+    for (int k = 0; k < channels.size(); k++)
+    {
+        const RecordingChannel& channel = channels[k];
+        const char* data = (const char*)payload.data() + channel.offset;
+        if (channel.type != (quint32)type || channel.size < (quint64)offset)
+        {
+            compressed.add(channel.type, data, channel.size);
+            continue;
+        }
+
+        QByteArray bytes = qCompress((const uchar*)data + offset, channel.size - offset);
+        char* p = (char*)compressed.add(channel.type, offset + bytes.size());
+        memcpy(p, data, offset);
+        memcpy(p + offset, bytes.data(), bytes.size());
+    }
+    *this = compressed;
+}
+
+// Returns the size of the channel block.
+int RecordingChannels::byteSize() const
+{
+    return sizeof(RecordingChannelTable) + channels.size()*sizeof(RecordingChannel) + payload.size()*sizeof(quint64);
+}
+
+// Writes the channel block into the buffer. The channel offsets become relative to the block.
+void RecordingChannels::serialize(Vector<quint64>& buffer) const
+{
+    buffer.resize(byteSize()/sizeof(quint64));
+    char* p = (char*)&buffer[0];
+
+    RecordingChannelTable table;
+    table.numChannels = channels.size();
+    table.reserved = 0;
+    memcpy(p, &table, sizeof(table));
+    p += sizeof(table);
+
+    quint64 dataOffset = sizeof(RecordingChannelTable) + channels.size()*sizeof(RecordingChannel);
+    for (int k = 0; k < channels.size(); k++)
+    {
+        RecordingChannel channel = channels[k];
+        channel.offset += dataOffset;
+        memcpy(p, &channel, sizeof(channel));
+        p += sizeof(channel);
+    }
+
+    if (payload.size() > 0)
+        memcpy(p, payload.data(), payload.size()*sizeof(quint64));
+}
+
+RecordingWriter::RecordingWriter()
+{
+    memset(&header, 0, sizeof(header));
+    compressed = false;
+    withColor = true;
+    dirty = false;
+    dataEnd = 0;
+}
+
+RecordingWriter::~RecordingWriter()
+{
+    close();
+}
+
+// Opens a recording file for writing frames with numPoints points each.
+// If append is set and the file is an existing recording, new frames are
+// appended to it. Otherwise the file is truncated.
+bool RecordingWriter::open(QString fileName, int numPoints, bool append)
+{
+    close();
+
+    if (Q_BYTE_ORDER != Q_LITTLE_ENDIAN)
+    {
+        qDebug() << "RecordingWriter: recordings can only be written on little-endian hosts.";
+        return false;
+    }
+
+    file.setFileName(fileName);
+    index.clear();
+    channelIndex.clear();
+
+    if (append && QFile::exists(fileName))
+    {
+        if (!file.open(QIODevice::ReadWrite))
+        {
+            qDebug() << "RecordingWriter: could not open" << fileName << file.errorString();
+            return false;
+        }
+
+        bool valid = file.read((char*)&header, sizeof(header)) == sizeof(header)
+                && header.magic == RecordingHeader::MAGIC
+                && header.version >= 1 && header.version <= RecordingHeader::VERSION
+                && header.numPoints == (quint32)numPoints
+                && header.indexOffset + header.numFrames*sizeof(RecordingIndexEntry) <= (quint64)file.size();
+        if (valid)
+        {
+            index.resize(header.numFrames);
+            qint64 indexSize = header.numFrames*sizeof(RecordingIndexEntry);
+            valid = file.seek(header.indexOffset)
+                    && (indexSize == 0 || file.read((char*)&index[0], indexSize) == indexSize);
+        }
+
+        // Frames of older versions have no channels.
+        channelIndex.resize(header.numFrames);
+        RecordingChannelIndexEntry none = {0, 0};
+        channelIndex.fill(none);
+        if (valid && header.version >= 3 && header.channelIndexOffset != 0)
+        {
+            qint64 channelIndexSize = header.numFrames*sizeof(RecordingChannelIndexEntry);
+            valid = file.seek(header.channelIndexOffset)
+                    && (channelIndexSize == 0 || file.read((char*)&channelIndex[0], channelIndexSize) == channelIndexSize);
+        }
+
+        if (!valid)
+        {
+            qDebug() << "RecordingWriter:" << fileName << "is not a compatible recording.";
+            file.close();
+            index.clear();
+            channelIndex.clear();
+            return false;
+        }
+
+        // The new frames go behind the committed index, which stays valid until
+        // the next commit() has written the new index and header.
+        header.version = RecordingHeader::VERSION;
+        dataEnd = (quint64(file.size()) + 7) & ~quint64(7);
+        return true;
+    }
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "RecordingWriter: could not open" << fileName << file.errorString();
+        return false;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.magic = RecordingHeader::MAGIC;
+    header.version = RecordingHeader::VERSION;
+    header.numPoints = numPoints;
+    header.indexOffset = sizeof(RecordingHeader);
+    dataEnd = sizeof(RecordingHeader);
+    return commit();
+}
+
+// Commits the frames appended since the last commit and closes the file.
+void RecordingWriter::close()
+{
+    if (file.isOpen())
+    {
+        if (dirty)
+            commit();
+        file.close();
+    }
+}
+
+bool RecordingWriter::isOpen() const
+{
+    return file.isOpen();
+}
+
+int RecordingWriter::numFrames() const
+{
+    return index.size();
+}
+
+// Returns true if frames were appended that are not in the committed index yet.
+bool RecordingWriter::isDirty() const
+{
+    return dirty;
+}
+
+// Selects whether the following frames are written compressed, and whether
+// compressed frames include the colors.
+void RecordingWriter::setCompression(bool compressed, bool withColor)
+{
+    this->compressed = compressed;
+    this->withColor = withColor;
+}
+
+// Appends a frame to the recording and updates the index and the header.
+// The optional channels are written into a channel block behind the frame block.
+// When a batch of frames is written, commitIndex can be cleared to update the
+// index only once with commit() after the last frame of the batch. A frame that
+// has not been committed is not part of the recording yet.
+bool RecordingWriter::appendFrame(int frameId, double time, const Vec3* points, const Pixel* colors,
+                                  const RecordingChannels* channels, bool commitIndex)
+{
+    if (!file.isOpen())
+        return false;
+
+    RecordingIndexEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.offset = dataEnd;
+    entry.frameId = frameId;
+    entry.time = time;
+
+    bool ok = file.seek(entry.offset);
+    if (ok && compressed)
+        ok = writeCompressedFrame(points, colors, entry);
+    else if (ok)
+        ok = writeRawFrame(points, colors, entry);
+
+    RecordingChannelIndexEntry channelEntry = {entry.offset + entry.size, 0};
+    if (ok && channels != 0 && channels->size() > 0)
+    {
+        channels->serialize(channelScratch);
+        channelEntry.size = channelScratch.size()*sizeof(quint64);
+        ok = file.write((const char*)channelScratch.data(), channelEntry.size) == (qint64)channelEntry.size;
+    }
+
+    if (!ok)
+    {
+        qDebug() << "RecordingWriter: failed to write frame" << frameId << file.errorString();
+        return false;
+    }
+
+    index << entry;
+    channelIndex << channelEntry;
+    dataEnd += entry.size + channelEntry.size;
+    dirty = true;
+    return commitIndex ? commit() : true;
+}
+
+// Writes a frame block with the points as doubles and the colors as bytes.
+bool RecordingWriter::writeRawFrame(const Vec3* points, const Pixel* colors, RecordingIndexEntry& entry)
+{
+    int n = header.numPoints;
+    pointScratch.resize(3*n);
+    for (int i = 0; i < n; i++)
+    {
+        pointScratch[3*i] = points[i].x;
+        pointScratch[3*i+1] = points[i].y;
+        pointScratch[3*i+2] = points[i].z;
+    }
+
+    entry.size = frameBlockSize(n);
+    entry.flags = RecordingIndexEntry::FRAME_COLOR;
+
+    qint64 pointBytes = qint64(n)*3*sizeof(double);
+    qint64 colorBytes = qint64(n)*sizeof(Pixel);
+    qint64 padding = entry.size - pointBytes - colorBytes;
+    const char zeros[8] = {0};
+
+    return file.write((const char*)pointScratch.data(), pointBytes) == pointBytes
+            && file.write((const char*)colors, colorBytes) == colorBytes
+            && file.write(zeros, padding) == padding;
+}
+
+// Writes a frame block with quantized, compressed chunks. The chunks are encoded in parallel.
+bool RecordingWriter::writeCompressedFrame(const Vec3* points, const Pixel* colors, RecordingIndexEntry& entry)
+{
+    int n = header.numPoints;
+    RecordingChunkTable table;
+    table.numChunks = NUMBER_OF_CHUNKS;
+    table.pointsPerChunk = (n + NUMBER_OF_CHUNKS - 1) / NUMBER_OF_CHUNKS;
+
+    chunks.resize(NUMBER_OF_CHUNKS);
+    const Pixel* c = withColor ? colors : 0;
+    Vector<QByteArray>& out = chunks;
+    parallelFor(NUMBER_OF_CHUNKS, [&](int k)
+    {
+        int begin = qMin(n, k*(int)table.pointsPerChunk);
+        int end = qMin(n, begin + (int)table.pointsPerChunk);
+        encodeChunk(points + begin, c ? c + begin : 0, end - begin, out[k]);
+    });
+
+    RecordingChunk chunkTable[NUMBER_OF_CHUNKS];
+    quint32 offset = sizeof(table) + sizeof(chunkTable);
+    for (int k = 0; k < NUMBER_OF_CHUNKS; k++)
+    {
+        chunkTable[k].offset = offset;
+        chunkTable[k].size = chunks[k].size();
+        offset += chunks[k].size();
+    }
+
+    entry.size = (quint64(offset) + 7) & ~quint64(7);
+    entry.flags = RecordingIndexEntry::FRAME_COMPRESSED | (withColor ? RecordingIndexEntry::FRAME_COLOR : 0);
+
+    bool ok = file.write((const char*)&table, sizeof(table)) == sizeof(table)
+            && file.write((const char*)chunkTable, sizeof(chunkTable)) == sizeof(chunkTable);
+    for (int k = 0; k < NUMBER_OF_CHUNKS && ok; k++)
+        ok = file.write(chunks[k].data(), chunks[k].size()) == chunks[k].size();
+    const char zeros[8] = {0};
+    qint64 padding = entry.size - offset;
+    return ok && file.write(zeros, padding) == padding;
+}
+
+// Writes the frame index behind the last frame and patches the header.
+// The file is a consistent recording afterwards. The previous index is not
+// overwritten, so the file stays consistent if the writer dies in between:
+// until the header is patched, it still points to the previous index. The
+// previous index is left behind as unused space, which is why frames should
+// be committed in batches rather than one by one.
+bool RecordingWriter::commit()
+{
+    RecordingHeader h = header;
+    h.numFrames = index.size();
+    h.indexOffset = dataEnd;
+    qint64 indexSize = index.size()*sizeof(RecordingIndexEntry);
+    qint64 channelIndexSize = channelIndex.size()*sizeof(RecordingChannelIndexEntry);
+    h.channelIndexOffset = h.indexOffset + indexSize;
+    bool ok = file.seek(h.indexOffset)
+            && (indexSize == 0 || file.write((const char*)index.data(), indexSize) == indexSize)
+            && (channelIndexSize == 0 || file.write((const char*)channelIndex.data(), channelIndexSize) == channelIndexSize)
+            && file.flush()
+            && file.seek(0)
+            && file.write((const char*)&h, sizeof(h)) == sizeof(h)
+            && file.flush();
+    if (!ok)
+    {
+        qDebug() << "RecordingWriter: failed to write the index of" << file.fileName() << file.errorString();
+        return false;
+    }
+
+    // The next frames go behind the new index.
+    header = h;
+    dataEnd = h.channelIndexOffset + channelIndexSize;
+    dirty = false;
+    return true;
+}
+
+Recording::Recording()
+{
+    map = 0;
+    mapSize = 0;
+    header = 0;
+    index = 0;
+    channelIndex = 0;
+}
+
+Recording::~Recording()
+{
+    close();
+}
+
+// Checks that the chunk table of a compressed frame block lies within the block
+// and covers all points of the frame.
+static bool validChunks(const uchar* block, quint64 size, int n)
+{
+    const RecordingChunkTable* table = (const RecordingChunkTable*)block;
+    if (table->numChunks == 0
+            || quint64(table->numChunks)*table->pointsPerChunk < quint64(n)
+            || sizeof(RecordingChunkTable) + quint64(table->numChunks)*sizeof(RecordingChunk) > size)
+        return false;
+
+    const RecordingChunk* chunks = (const RecordingChunk*)(table+1);
+    for (uint k = 0; k < table->numChunks; k++)
+        if (quint64(chunks[k].offset) + chunks[k].size > size)
+            return false;
+    return true;
+}
+
+// Checks that the channel table of a channel block lies within the block.
+static bool validChannels(const uchar* block, quint64 size)
+{
+    const RecordingChannelTable* table = (const RecordingChannelTable*)block;
+    if (size < sizeof(RecordingChannelTable)
+            || sizeof(RecordingChannelTable) + quint64(table->numChannels)*sizeof(RecordingChannel) > size)
+        return false;
+
+    const RecordingChannel* channels = (const RecordingChannel*)(table+1);
+    for (uint k = 0; k < table->numChannels; k++)
+        if (channels[k].offset % 8 != 0 || channels[k].offset + channels[k].size > size)
+            return false;
+    return true;
+}
+
+// Maps a recording file into memory and validates its header and index.
+bool Recording::open(QString fileName)
+{
+    close();
+
+    if (Q_BYTE_ORDER != Q_LITTLE_ENDIAN)
+    {
+        qDebug() << "Recording: recordings can only be read on little-endian hosts.";
+        return false;
+    }
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Recording: could not open" << fileName << file.errorString();
+        return false;
+    }
+
+    mapSize = file.size();
+    if (mapSize < (qint64)sizeof(RecordingHeader) || (map = file.map(0, mapSize)) == 0)
+    {
+        qDebug() << "Recording: could not map" << fileName;
+        close();
+        return false;
+    }
+
+    header = (const RecordingHeader*)map;
+    bool valid = header->magic == RecordingHeader::MAGIC
+            && header->version >= 1 && header->version <= RecordingHeader::VERSION
+            && header->indexOffset % 8 == 0
+            && header->indexOffset + header->numFrames*sizeof(RecordingIndexEntry) <= (quint64)mapSize;
+    if (valid)
+    {
+        index = (const RecordingIndexEntry*)(map + header->indexOffset);
+        quint64 blockSize = frameBlockSize(header->numPoints);
+        for (uint i = 0; i < header->numFrames && valid; i++)
+        {
+            valid = index[i].offset % 8 == 0
+                    && index[i].offset + index[i].size <= header->indexOffset;
+            if (header->version == 1)
+                valid = valid && index[i].flags == 0;
+            if (!(index[i].flags & RecordingIndexEntry::FRAME_COMPRESSED))
+                valid = valid && index[i].size == blockSize;
+            else
+                valid = valid && index[i].size >= sizeof(RecordingChunkTable)
+                        && validChunks(map + index[i].offset, index[i].size, header->numPoints);
+        }
+    }
+    if (valid && header->version >= 3 && header->channelIndexOffset != 0)
+    {
+        valid = header->channelIndexOffset % 8 == 0
+                && header->channelIndexOffset + header->numFrames*sizeof(RecordingChannelIndexEntry) <= (quint64)mapSize;
+        if (valid)
+            channelIndex = (const RecordingChannelIndexEntry*)(map + header->channelIndexOffset);
+        for (uint i = 0; i < header->numFrames && valid; i++)
+            valid = channelIndex[i].size == 0
+                    || (channelIndex[i].offset % 8 == 0
+                        && channelIndex[i].offset + channelIndex[i].size <= header->indexOffset
+                        && validChannels(map + channelIndex[i].offset, channelIndex[i].size));
+    }
+
+    if (!valid)
+    {
+        qDebug() << "Recording:" << fileName << "is not a valid recording.";
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void Recording::close()
+{
+    if (map != 0)
+        file.unmap(map);
+    if (file.isOpen())
+        file.close();
+    map = 0;
+    mapSize = 0;
+    header = 0;
+    index = 0;
+    channelIndex = 0;
+}
+
+bool Recording::isOpen() const
+{
+    return header != 0;
+}
+
+int Recording::numFrames() const
+{
+    return header ? header->numFrames : 0;
+}
+
+int Recording::numPoints() const
+{
+    return header ? header->numPoints : 0;
+}
+
+int Recording::frameId(int i) const
+{
+    return index[i].frameId;
+}
+
+double Recording::time(int i) const
+{
+    return index[i].time;
+}
+
+bool Recording::isCompressed(int i) const
+{
+    return index[i].flags & RecordingIndexEntry::FRAME_COMPRESSED;
+}
+
+bool Recording::hasColor(int i) const
+{
+    return header->version == 1 || (index[i].flags & RecordingIndexEntry::FRAME_COLOR);
+}
+
+// Returns the interleaved xyz coordinates of the points of frame i.
+// The pointer points directly into the mapped file.
+// Returns 0 if the frame is compressed.
+const double* Recording::points(int i) const
+{
+    if (isCompressed(i))
+        return 0;
+    return (const double*)(map + index[i].offset);
+}
+
+// Returns the colors of the points of frame i.
+// The pointer points directly into the mapped file.
+// Returns 0 if the frame is compressed.
+const Pixel* Recording::colors(int i) const
+{
+    if (isCompressed(i))
+        return 0;
+    return (const Pixel*)(map + index[i].offset + quint64(header->numPoints)*3*sizeof(double));
+}
+
+// Copies frame i into the given point and color buffers. Compressed frames are
+// decoded in parallel, unless parallel is false, which is meant for callers that
+// already read frames on several threads. If the frame has no colors, the colors
+// are set to black.
+void Recording::readFrame(int i, Vec3* points, Pixel* colors, bool parallel) const
+{
+    int n = header->numPoints;
+
+    if (!isCompressed(i))
+    {
+        const double* p = this->points(i);
+        for (int k = 0; k < n; k++)
+        {
+            points[k].x = p[3*k];
+            points[k].y = p[3*k+1];
+            points[k].z = p[3*k+2];
+        }
+        memcpy(colors, this->colors(i), n*sizeof(Pixel));
+        return;
+    }
+
+    const uchar* block = map + index[i].offset;
+    const RecordingChunkTable* table = (const RecordingChunkTable*)block;
+    const RecordingChunk* chunks = (const RecordingChunk*)(table+1);
+    bool color = hasColor(i);
+    if (!color)
+        for (int k = 0; k < n; k++)
+            colors[k] = Pixel();
+
+    std::atomic<bool> ok(true);
+    parallelFor(table->numChunks, [&](int k)
+    {
+        int begin = qMin(n, k*(int)table->pointsPerChunk);
+        int end = qMin(n, begin + (int)table->pointsPerChunk);
+        if (!decodeChunk(block + chunks[k].offset, chunks[k].size, end - begin,
+                         points + begin, color ? colors + begin : 0))
+            ok = false;
+    }, parallel);
+
+    if (!ok)
+        qDebug() << "Recording: frame" << index[i].frameId << "is corrupt.";
+}
+
+// Returns true if pipeline outputs were recorded with frame i.
+bool Recording::hasChannels(int i) const
+{
+    return channelIndex != 0 && channelIndex[i].size > 0;
+}
+
+// Returns the data of the channel of the given type of frame i, or 0 if the frame
+// does not have the channel. The pointer points directly into the mapped file and
+// is 8 byte aligned. The point data of the frame is not touched.
+const void* Recording::channel(int i, int type, int* bytes) const
+{
+    if (!hasChannels(i))
+        return 0;
+
+    const uchar* block = map + channelIndex[i].offset;
+    const RecordingChannelTable* table = (const RecordingChannelTable*)block;
+    const RecordingChannel* channels = (const RecordingChannel*)(table+1);
+    for (uint k = 0; k < table->numChannels; k++)
+    {
+        if (channels[k].type == (quint32)type)
+        {
+            if (bytes != 0)
+                *bytes = channels[k].size;
+            return block + channels[k].offset;
+        }
+    }
+    return 0;
+}
+
+const RecordingFloor* Recording::floor(int i) const
+{
+    int bytes = 0;
+    const void* data = channel(i, RecordingChannel::FLOOR, &bytes);
+    return bytes >= (int)sizeof(RecordingFloor) ? (const RecordingFloor*)data : 0;
+}
+
+// Returns the camera transform of frame i as 16 doubles in column-major order.
+const double* Recording::cameraTransform(int i) const
+{
+    int bytes = 0;
+    const void* data = channel(i, RecordingChannel::CAMERA_TRANSFORM, &bytes);
+    return bytes >= 16*(int)sizeof(double) ? (const double*)data : 0;
+}
+
+const RecordingTimings* Recording::timings(int i) const
+{
+    int bytes = 0;
+    const void* data = channel(i, RecordingChannel::TIMINGS, &bytes);
+    return bytes >= (int)sizeof(RecordingTimings) ? (const RecordingTimings*)data : 0;
+}
+
+// Returns a view of the polygons of frame i. The view points into the mapped file.
+PolygonSetView Recording::polygons(int i) const
+{
+    int bytes = 0;
+    const void* data = channel(i, RecordingChannel::POLYGONS, &bytes);
+    return PolygonSetView::fromBuffer(data, bytes);
+}
+
+// Returns the grid snapshot header of frame i, or 0 if no grid was recorded.
+// If cells is given, the width*height grid cells are decompressed into it.
+const RecordingGrid* Recording::grid(int i, QByteArray* cells) const
+{
+    int bytes = 0;
+    const uchar* data = (const uchar*)channel(i, RecordingChannel::GRID, &bytes);
+    if (bytes < (int)sizeof(RecordingGrid))
+        return 0;
+
+    const RecordingGrid* grid = (const RecordingGrid*)data;
+    if (cells != 0)
+    {
+        *cells = qUncompress(data + sizeof(RecordingGrid), bytes - sizeof(RecordingGrid));
+        if (cells->size() != int(grid->width*grid->height))
+        {
+            qDebug() << "Recording: the grid of frame" << index[i].frameId << "is corrupt.";
+            return 0;
+        }
+    }
+    return grid;
+}
+
+// Converts a state history file written with QDataStream into a recording.
+bool Recording::convert(QString datFileName, QString recordingFileName)
+{
+    QFile datFile(datFileName);
+    if (!datFile.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Recording: could not open" << datFileName << datFile.errorString();
+        return false;
+    }
+    QDataStream in(&datFile);
+
+    RecordingWriter writer;
+    if (!writer.open(recordingFileName, NUMBER_OF_POINTS))
+        return false;
+
+    Vector<Vec3> points(NUMBER_OF_POINTS);
+    Vector<Pixel> colors(NUMBER_OF_POINTS);
+    int frameId;
+    double time;
+    while (!in.atEnd())
+    {
+        in >> frameId;
+        in >> time;
+        for (int i = 0; i < NUMBER_OF_POINTS; i++)
+        {
+            in >> points[i];
+            in >> colors[i].r;
+            in >> colors[i].g;
+            in >> colors[i].b;
+        }
+
+        if (in.status() != QDataStream::Ok)
+        {
+            qDebug() << "Recording:" << datFileName << "ends with a truncated frame.";
+            break;
+        }
+
+        if (!writer.appendFrame(frameId, time, &points[0], &colors[0], 0, false))
+            return false;
+    }
+
+    qDebug() << "Recording: converted" << writer.numFrames() << "frames from" << datFileName << "to" << recordingFileName;
+    return true;
+}
@@ -0,0 +1,225 @@
+#ifndef RECORDING_H
+#define RECORDING_H
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+#include "util/Vec3.h"
+#include "util/Vector.h"
+#include "util/ColorUtil.h"
+#include "geometry/PolygonSet.h"
+
+// The binary layout of a recording file. All values are little-endian.
+//
+// RecordingHeader
+// frame block 0
+// frame block 1
+// ...
+// RecordingIndexEntry[numFrames]
+// RecordingChannelIndexEntry[numFrames]
+//
+// A raw frame block holds numPoints xyz triplets of doubles followed by numPoints rgb
+// byte triplets, padded to a multiple of 8 bytes. The frame index sits behind the
+// frames. Frames are appended behind the index and a new index is written behind
+// them before the header is switched over to it, so that the file stays a valid
+// recording at any time. The space of the replaced indices remains unused. Every
+// block starts at an 8 byte aligned offset, so that the file can be memory mapped
+// and the points can be read in place.
+//
+// A compressed frame block (FRAME_COMPRESSED) starts with a RecordingChunkTable followed
+// by numChunks RecordingChunk entries and the zlib compressed chunk data. A chunk holds
+// the points [k*pointsPerChunk, (k+1)*pointsPerChunk) of the frame. The coordinates are
+// quantized to signed 16 bit millimeters and delta coded along the scan order. The
+// quantization error is at most 0.5 mm per coordinate, coordinates beyond +-32.767 m are
+// clamped, and null points stay exactly null. The colors are stored only if the frame
+// has the FRAME_COLOR flag. The chunks are encoded and decoded in parallel.
+//
+// The outputs of the pipeline for a frame are stored in a channel block behind the frame
+// block. It starts with a RecordingChannelTable followed by numChannels RecordingChannel
+// entries and the 8 byte aligned channel data. The channel index at channelIndexOffset
+// locates the channel block of each frame (size 0 if the frame has none), so that a
+// channel can be read without touching the point data.
+
+struct RecordingHeader
+{
+    enum {MAGIC = 0x43525050}; // "PPRC"
+    enum {VERSION = 3}; // Version 1 and 2 files have no channels and are still readable.
+
+    quint32 magic;
+    quint32 version;
+    quint32 numFrames;
+    quint32 numPoints;
+    quint64 indexOffset; // Byte offset of the frame index.
+    quint64 channelIndexOffset; // Byte offset of the channel index. 0 before version 3.
+};
+
+struct RecordingChunkTable
+{
+    quint32 numChunks;
+    quint32 pointsPerChunk;
+};
+
+struct RecordingChunk
+{
+    quint32 offset; // Byte offset of the chunk data relative to the frame block.
+    quint32 size; // Byte size of the compressed chunk data.
+};
+
+struct RecordingIndexEntry
+{
+    enum {FRAME_COMPRESSED = 1, FRAME_COLOR = 2};
+
+    quint64 offset; // Byte offset of the frame block.
+    quint64 size; // Byte size of the frame block.
+    qint32 frameId;
+    quint32 flags;
+    double time;
+};
+
+struct RecordingChannelIndexEntry
+{
+    quint64 offset; // Byte offset of the channel block.
+    quint64 size; // Byte size of the channel block. 0 if the frame has no channels.
+};
+
+struct RecordingChannelTable
+{
+    quint32 numChannels;
+    quint32 reserved;
+};
+
+struct RecordingChannel
+{
+    enum Type
+    {
+        FLOOR = 1, // RecordingFloor
+        CAMERA_TRANSFORM = 2, // 16 doubles, column-major
+        POLYGONS = 3, // A serialized PolygonSet
+        TIMINGS = 4, // RecordingTimings
+        GRID = 5 // RecordingGrid followed by the qCompress'ed grid cells
+    };
+
+    quint32 type;
+    quint32 reserved;
+    quint64 offset; // Byte offset of the channel data relative to the channel block.
+    quint64 size; // Byte size of the channel data.
+};
+
+struct RecordingFloor
+{
+    double p[3]; // A point on the floor plane.
+    double n[3]; // The normal of the floor plane.
+};
+
+struct RecordingTimings
+{
+    double executionTime;
+    double captureTime;
+    double publishTime;
+    double latency;
+};
+
+struct RecordingGrid
+{
+    quint32 width;
+    quint32 height;
+    double min[2];
+    double max[2];
+};
+
+// Collects the output channels of one frame for the RecordingWriter.
+class RecordingChannels
+{
+    Vector<RecordingChannel> channels;
+    Vector<quint64> payload; // quint64 keeps the channel data 8 byte aligned.
+
+public:
+
+    void clear();
+    int size() const;
+    void* add(int type, int bytes);
+    void add(int type, const void* data, int bytes);
+    void compress(int type, int offset);
+
+    int byteSize() const;
+    void serialize(Vector<quint64>& buffer) const;
+};
+
+// Appends frames to a recording file.
+class RecordingWriter
+{
+    QFile file;
+    RecordingHeader header;
+    Vector<RecordingIndexEntry> index;
+    Vector<RecordingChannelIndexEntry> channelIndex;
+    Vector<double> pointScratch;
+    Vector<quint64> channelScratch;
+    Vector<QByteArray> chunks;
+    bool compressed;
+    bool withColor;
+    bool dirty; // Frames were appended after the last commit().
+    quint64 dataEnd; // Byte offset behind the last written block, where the next frame goes.
+
+public:
+
+    RecordingWriter();
+    ~RecordingWriter();
+
+    bool open(QString fileName, int numPoints, bool append = false);
+    void close();
+    bool isOpen() const;
+    int numFrames() const;
+    bool isDirty() const;
+    void setCompression(bool compressed, bool withColor = true);
+
+    bool appendFrame(int frameId, double time, const Vec3* points, const Pixel* colors,
+                     const RecordingChannels* channels = 0, bool commitIndex = true);
+    bool commit();
+
+private:
+    bool writeRawFrame(const Vec3* points, const Pixel* colors, RecordingIndexEntry& entry);
+    bool writeCompressedFrame(const Vec3* points, const Pixel* colors, RecordingIndexEntry& entry);
+};
+
+// A memory mapped, read only view of a recording file.
+// Every frame can be accessed in O(1) through the frame index.
+class Recording
+{
+    QFile file;
+    uchar* map;
+    qint64 mapSize;
+    const RecordingHeader* header;
+    const RecordingIndexEntry* index;
+    const RecordingChannelIndexEntry* channelIndex;
+
+public:
+
+    Recording();
+    ~Recording();
+
+    bool open(QString fileName);
+    void close();
+    bool isOpen() const;
+
+    int numFrames() const;
+    int numPoints() const;
+    int frameId(int i) const;
+    double time(int i) const;
+    bool isCompressed(int i) const;
+    bool hasColor(int i) const;
+
+    const double* points(int i) const;
+    const Pixel* colors(int i) const;
+    void readFrame(int i, Vec3* points, Pixel* colors, bool parallel = true) const;
+
+    bool hasChannels(int i) const;
+    const void* channel(int i, int type, int* bytes = 0) const;
+    const RecordingFloor* floor(int i) const;
+    const double* cameraTransform(int i) const;
+    const RecordingTimings* timings(int i) const;
+    PolygonSetView polygons(int i) const;
+    const RecordingGrid* grid(int i, QByteArray* cells = 0) const;
+
+    static bool convert(QString datFileName, QString recordingFileName);
+};
+
+#endif // RECORDING_H
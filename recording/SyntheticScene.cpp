@@ -0,0 +1,96 @@
+#include "SyntheticScene.h"
+#include "globals.h"
+
+// The scene is generated in the camera frame with x pointing forward, y to the left
+// and z up. Every pixel of the image looks at a point on the floor. The image rows
+// span the floor from 0.5 m to 4.5 m in front of the camera, and the columns span a
+// field of view that widens with the distance. Pixels that look at an obstacle get
+// the height of its top face. The obstacles move towards the camera with the speed
+// of the robot and reappear in the back when they have passed it, so that every frame
+// is different, but the scene has the same statistics at all times. A small
+// deterministic noise makes the point cloud look like a real depth image.
+
+static const double NEAR_DISTANCE = 0.5;
+static const double FAR_DISTANCE = 4.5;
+
+// Returns a pseudo random number in [0,1) for the state s and advances the state.
+static double nextRandom(quint32& s)
+{
+    s = s*1664525u + 1013904223u;
+    return (s >> 8) / double(1 << 24);
+}
+
+SyntheticScene::SyntheticScene(int numObstacles, quint32 seed)
+{
+    cameraHeight = 0.6;
+    speed = 0.02;
+    noise = 0.002;
+    this->seed = seed;
+    setObstacles(numObstacles);
+}
+
+// Places numObstacles randomly sized obstacles in the field of view.
+void SyntheticScene::setObstacles(int numObstacles)
+{
+    quint32 s = seed;
+    obstacles.clear();
+    for (int i = 0; i < numObstacles; i++)
+    {
+        Obstacle o;
+        o.x = NEAR_DISTANCE + nextRandom(s)*(FAR_DISTANCE-NEAR_DISTANCE);
+        o.y = (nextRandom(s)-0.5)*o.x;
+        o.w = 0.1 + 0.4*nextRandom(s);
+        o.d = 0.1 + 0.4*nextRandom(s);
+        o.h = 0.15 + 0.35*nextRandom(s);
+        obstacles << o;
+    }
+}
+
+int SyntheticScene::numObstacles() const
+{
+    return obstacles.size();
+}
+
+// Writes the point cloud of the given frame into points, which has to hold
+// NUMBER_OF_POINTS points. If colors is given, the points are also colored.
+void SyntheticScene::generate(int frame, Vec3* points, Pixel* colors) const
+{
+    double range = FAR_DISTANCE-NEAR_DISTANCE;
+    double travel = fmod(frame*speed, range);
+
+    for (int v = 0; v < IMAGE_HEIGHT; v++)
+    {
+        double x = NEAR_DISTANCE + range*(IMAGE_HEIGHT-1-v)/(IMAGE_HEIGHT-1);
+        for (int u = 0; u < IMAGE_WIDTH; u++)
+        {
+            double y = x*(0.5*IMAGE_WIDTH-u)/IMAGE_WIDTH;
+            double z = 0;
+            int hit = -1;
+            for (int i = 0; i < obstacles.size(); i++)
+            {
+                const Obstacle& o = obstacles[i];
+                double ox = o.x - travel;
+                if (ox < NEAR_DISTANCE)
+                    ox += range;
+                if (fabs(x-ox) < 0.5*o.w && fabs(y-o.y) < 0.5*o.d && o.h > z)
+                {
+                    z = o.h;
+                    hit = i;
+                }
+            }
+
+            int k = u + v*IMAGE_WIDTH;
+            quint32 s = seed ^ (quint32(k)*2654435761u) ^ (quint32(frame)*40503u);
+            points[k] = Vec3(x, y, z - cameraHeight + noise*(2.0*nextRandom(s)-1.0));
+
+            if (colors != 0)
+            {
+                Pixel c;
+                c.r = hit < 0 ? 128 : 64 + (hit*53) % 192;
+                c.g = hit < 0 ? 128 : 64 + (hit*97) % 192;
+                c.b = hit < 0 ? 128 : 64 + (hit*29) % 192;
+                colors[k] = c;
+            }
+        }
+    }
+}
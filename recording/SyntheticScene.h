@@ -0,0 +1,38 @@
+#ifndef SYNTHETICSCENE_H
+#define SYNTHETICSCENE_H
+#include "util/Vector.h"
+#include "util/Vec3.h"
+#include "util/ColorUtil.h"
+
+// Generates point clouds of a flat floor with box shaped obstacles, as seen
+// by a depth camera on a robot that drives forward. The scenes are deterministic
+// for a given seed, so they can stand in for a recording in tests and benchmarks.
+class SyntheticScene
+{
+    struct Obstacle
+    {
+        double x = 0; // Center on the floor, in meters.
+        double y = 0;
+        double w = 0; // Extent along x and y.
+        double d = 0;
+        double h = 0; // Height above the floor.
+    };
+
+    Vector<Obstacle> obstacles;
+    double cameraHeight; // Height of the camera above the floor.
+    double speed; // Forward speed of the robot in meters per frame.
+    double noise; // Amplitude of the depth noise in meters.
+    quint32 seed;
+
+public:
+
+    SyntheticScene(int numObstacles = 8, quint32 seed = 1);
+    ~SyntheticScene(){}
+
+    void setObstacles(int numObstacles);
+    int numObstacles() const;
+
+    void generate(int frame, Vec3* points, Pixel* colors = 0) const;
+};
+
+#endif // SYNTHETICSCENE_H
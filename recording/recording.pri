@@ -0,0 +1,8 @@
+HEADERS += recording/Recording.h \
+    recording/FramePager.h \
+    recording/AsyncRecorder.h \
+    recording/SyntheticScene.h
+SOURCES += recording/Recording.cpp \
+    recording/FramePager.cpp \
+    recording/AsyncRecorder.cpp \
+    recording/SyntheticScene.cpp
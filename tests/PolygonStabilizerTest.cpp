@@ -0,0 +1,131 @@
+#include "Test.h"
+#include "PolygonStabilizer.h"
+#include "blackboard/Config.h"
+
+// Returns n squares in a row that starts at x. The vertices are given in the
+// robot frame like the polygons of the pipeline.
+static Vector<Polygon> squares(double x, int n)
+{
+    Vector<Polygon> pols;
+    for (int i = 0; i < n; i++)
+    {
+        pols << Polygon(x+i, 0, 0.2, 0.2);
+        pols.last().transform();
+    }
+    return pols;
+}
+
+// Checks that the ids of the stabilized polygons are unique.
+static void checkIds(const PolygonStabilizer& stabilizer)
+{
+    const Vector<int>& ids = stabilizer.getIds();
+    CHECK(ids.size() == stabilizer.getPolygons().size());
+    CHECK(ids.size() == stabilizer.getUnchanged().size());
+    for (int i = 0; i < ids.size(); i++)
+        for (int j = i+1; j < ids.size(); j++)
+            CHECK(ids[i] != ids[j]);
+}
+
+// The number of observations drops while the number of tracks grows, because
+// the tracks of the obstacles that are not observed any more are held. The
+// broadphase then shrinks the observation group and grows the track group.
+static void testObservationsDropTracksGrow()
+{
+    double appear = config.stabilizationAppear;
+    double disappear = config.stabilizationDisappear;
+    config.stabilizationAppear = 1;
+    config.stabilizationDisappear = 10;
+
+    PolygonStabilizer stabilizer;
+    Vec3 pose;
+
+    stabilizer.update(squares(0, 2), pose);
+    CHECK(stabilizer.getPolygons().size() == 2);
+    checkIds(stabilizer);
+
+    stabilizer.update(squares(10, 6), pose);
+    CHECK(stabilizer.getPolygons().size() == 8);
+    checkIds(stabilizer);
+
+    stabilizer.update(squares(20, 1), pose);
+    CHECK(stabilizer.getPolygons().size() == 9);
+    checkIds(stabilizer);
+    Vector<int> ids = stabilizer.getIds();
+
+    // Observing the held obstacles again continues their tracks.
+    stabilizer.update(squares(10, 3), pose);
+    CHECK(stabilizer.getPolygons().size() == 9);
+    checkIds(stabilizer);
+    for (int i = 0; i < ids.size(); i++)
+        CHECK(stabilizer.getIds()[i] == ids[i]);
+
+    config.stabilizationAppear = appear;
+    config.stabilizationDisappear = disappear;
+}
+
+// The last observed vertex snaps to the same track vertex as the first one. The
+// collapse wraps around, so the track keeps four vertices and stays unchanged.
+static void testSnapWrapsAround()
+{
+    double appear = config.stabilizationAppear;
+    double tolerance = config.stabilizationTolerance;
+    config.stabilizationAppear = 1;
+    config.stabilizationTolerance = 0.05;
+
+    Polygon square;
+    square << Vec2(0, 0) << Vec2(1, 0) << Vec2(1, 1) << Vec2(0, 1);
+    Polygon observed = square;
+    observed << Vec2(0, 0.01);
+    Vector<Polygon> pols;
+    pols << square;
+
+    PolygonStabilizer stabilizer;
+    Vec3 pose;
+    stabilizer.update(pols, pose);
+    pols[0] = observed;
+    stabilizer.update(pols, pose);
+    CHECK(stabilizer.getPolygons().size() == 1);
+    CHECK(stabilizer.getPolygons()[0].size() == 4);
+    CHECK(stabilizer.numChanged() == 0);
+    stabilizer.update(pols, pose);
+    CHECK(stabilizer.getPolygons()[0].size() == 4);
+    CHECK(stabilizer.numChanged() == 0);
+
+    config.stabilizationAppear = appear;
+    config.stabilizationTolerance = tolerance;
+}
+
+// A confirmed obstacle that is missed for a frame and then observed again is
+// not reported as new.
+static void testReappearanceIsNotNew()
+{
+    double appear = config.stabilizationAppear;
+    double disappear = config.stabilizationDisappear;
+    config.stabilizationAppear = 2;
+    config.stabilizationDisappear = 10;
+
+    PolygonStabilizer stabilizer;
+    Vec3 pose;
+    stabilizer.update(squares(0, 1), pose);
+    CHECK(stabilizer.getPolygons().size() == 0);
+    stabilizer.update(squares(0, 1), pose);
+    CHECK(stabilizer.numChanged() == 1);
+    stabilizer.update(squares(0, 1), pose);
+    CHECK(stabilizer.numChanged() == 0);
+    stabilizer.update(Vector<Polygon>(), pose);
+    CHECK(stabilizer.getPolygons().size() == 1);
+    stabilizer.update(squares(0, 1), pose);
+    CHECK(stabilizer.numChanged() == 0);
+    stabilizer.update(squares(0, 1), pose);
+    CHECK(stabilizer.numChanged() == 0);
+
+    config.stabilizationAppear = appear;
+    config.stabilizationDisappear = disappear;
+}
+
+void testPolygonStabilizer()
+{
+    testObservationsDropTracksGrow();
+    testSnapWrapsAround();
+    testReappearanceIsNotNew();
+}
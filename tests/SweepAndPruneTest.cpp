@@ -0,0 +1,81 @@
+#include "Test.h"
+#include "geometry/SweepAndPrune.h"
+#include "util/Statistics.h"
+
+// Counts the pairs of overlapping bounding boxes by testing all pairs.
+static int countOverlaps(const Vector<Polygon>& a, const Vector<Polygon>& b)
+{
+    int count = 0;
+    for (int i = 0; i < a.size(); i++)
+    {
+        const Box& ba = a[i].boundingBox();
+        for (int j = 0; j < b.size(); j++)
+        {
+            const Box& bb = b[j].boundingBox();
+            if (ba.left() <= bb.right() && bb.left() <= ba.right() && ba.bottom() <= bb.top() && bb.bottom() <= ba.top())
+                count++;
+        }
+    }
+    return count;
+}
+
+// Checks the pairs against the brute force result.
+static void checkPairs(const Vector<SweepAndPrune::Pair>& pairs, const Vector<Polygon>& a, const Vector<Polygon>& b)
+{
+    CHECK(pairs.size() == countOverlaps(a, b));
+    for (int i = 0; i < pairs.size(); i++)
+    {
+        CHECK(pairs[i].a >= 0 && pairs[i].a < a.size());
+        CHECK(pairs[i].b >= 0 && pairs[i].b < b.size());
+    }
+}
+
+// One setBoxes() call shrinks group 0 and the next one grows group 1, so that
+// group 1 reuses the freed object slots of group 0.
+static void testShrinkThenGrow()
+{
+    SweepAndPrune sap;
+    Vector<Polygon> a;
+    Vector<Polygon> b;
+    for (int i = 0; i < 6; i++)
+        a << Polygon(i, 0, 0.3, 0.3);
+    b << Polygon(0, 0, 0.3, 0.3);
+    sap.setBoxes(0, a);
+    sap.setBoxes(1, b);
+    checkPairs(sap.findPairs(), a, b);
+
+    a.resize(2);
+    for (int i = 1; i < 6; i++)
+        b << Polygon(i, 0.1, 0.3, 0.3);
+    sap.setBoxes(0, a);
+    sap.setBoxes(1, b);
+    checkPairs(sap.findPairs(), a, b);
+    CHECK(sap.size(0) == 2);
+    CHECK(sap.size(1) == 6);
+}
+
+// Random group sizes and boxes over many rounds.
+static void testRandomResizes()
+{
+    Statistics::setSeed(1);
+    SweepAndPrune sap;
+    Vector<Polygon> groups[2];
+    for (int round = 0; round < 200; round++)
+    {
+        for (int g = 0; g < 2; g++)
+        {
+            groups[g].clear();
+            int n = (int)Statistics::uniformSample(0.0, 20.0);
+            for (int i = 0; i < n; i++)
+                groups[g] << Polygon(Statistics::uniformSample(-5.0, 5.0), Statistics::uniformSample(-5.0, 5.0), 0.5, 0.5);
+            sap.setBoxes(g, groups[g]);
+        }
+        checkPairs(sap.findPairs(), groups[0], groups[1]);
+    }
+}
+
+void testSweepAndPrune()
+{
+    testShrinkThenGrow();
+    testRandomResizes();
+}
@@ -0,0 +1,15 @@
+#ifndef TEST_H_
+#define TEST_H_
+#include <QDebug>
+
+// A minimal check facility for the regression tests. A failed check is
+// reported with its location and counted, the test carries on.
+extern int testFailures;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { testFailures++; qDebug() << __FILE__ << ":" << __LINE__ << "check failed:" << #cond; } } while (0)
+
+void testSweepAndPrune();
+void testPolygonStabilizer();
+
+#endif
@@ -0,0 +1,28 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include "Test.h"
+#include "blackboard/Config.h"
+
+// Regression tests. Returns a non zero exit code if any check failed.
+//
+// qmake polyperception-tests.pro -o Makefile.tests && make -f Makefile.tests && ./polyperception-tests
+
+int testFailures = 0;
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    config.init();
+
+    testSweepAndPrune();
+    testPolygonStabilizer();
+
+    if (testFailures > 0)
+    {
+        qDebug() << testFailures << "checks failed.";
+        return 1;
+    }
+
+    qDebug() << "All tests passed.";
+    return 0;
+}
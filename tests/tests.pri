@@ -0,0 +1,4 @@
+HEADERS += tests/Test.h
+SOURCES += tests/main.cpp \
+    tests/SweepAndPruneTest.cpp \
+    tests/PolygonStabilizerTest.cpp
@@ -1,20 +1,63 @@
 #include "AdjacencyMatrix.h"
 
-// This is a memory preserving implementation of an adjacency matrix
+// This is a memory preserving implementation of a symmetric adjacency matrix
 // where any entry (i,j) of the matrix can be 0 or 1. Memory preserving
 // means that the matrix grows automatically in size when needed, but
 // memory is never released again to avoid reoccuring heap allocations.
+// The entries are packed into 64 bit words, one row after another, so that
+// a matrix of 1000 nodes takes only 125 kB and the neighbours of a node can
+// be enumerated with a bit scan over its row using nextNeighbour().
+// Both (i,j) and (j,i) are stored so that every row is a complete
+// neighbour list.
 
 AdjacencyMatrix::AdjacencyMatrix()
 {
-
+    n = 0;
+    stride = 0;
 }
 
 // Resets the matrix to all zeros.
 void AdjacencyMatrix::clear()
 {
-    for (int i = 0; i < m.size(); i++)
-        m[i].fill(0);
+    m.fill(0);
+}
+
+// Makes sure the matrix has at least n rows and columns. Existing entries
+// are preserved. The matrix never shrinks.
+void AdjacencyMatrix::resize(uint n)
+{
+    if (n <= this->n)
+        return;
+
+    uint newStride = (n+63)/64;
+    if (newStride != stride)
+    {
+        // Copy the rows over into the wider layout, starting at the last
+        // row so that the rows can be moved in place.
+        m.resize(n*newStride);
+        for (int i = this->n-1; i >= 0; i--)
+        {
+            for (int k = newStride-1; k >= 0; k--)
+                m[i*newStride+k] = (k < stride) ? m[i*stride+k] : 0;
+        }
+        for (uint i = this->n*newStride; i < n*newStride; i++)
+            m[i] = 0;
+        stride = newStride;
+    }
+    else
+    {
+        m.resize(n*stride);
+        for (uint i = this->n*stride; i < n*stride; i++)
+            m[i] = 0;
+    }
+
+    this->n = n;
+}
+
+// Returns the number of rows (and columns) of the matrix.
+uint AdjacencyMatrix::size() const
+{
+    return n;
 }
 
 // Set the matrix entry at (i,j) to 1.
@@ -22,31 +65,34 @@ void AdjacencyMatrix::clear()
 // to accomodate an element i,j.
 void AdjacencyMatrix::set(uint i, uint j)
 {
-    if (j > i)
-    {
-        uint temp = j;
-        j = i;
-        i = temp;
-    }
-
-    m.ensureSize(i+1);
-    m[i].ensureSize(j+1);
-    m[i][j] = 1;
+    resize(qMax(i, j)+1);
+    m[i*stride+j/64] |= (quint64(1) << (j%64));
+    m[j*stride+i/64] |= (quint64(1) << (i%64));
 }
 
 // Set the matrix entry at (i,j) to 0.
 // This operation will not cause the matrix to grow.
 void AdjacencyMatrix::unset(uint i, uint j)
 {
-    if (j > i)
+    if (i >= n || j >= n)
+        return;
+    m[i*stride+j/64] &= ~(quint64(1) << (j%64));
+    m[j*stride+i/64] &= ~(quint64(1) << (i%64));
+}
+
+// Sets all entries of row i and column i to 0, i.e. it disconnects the node i.
+void AdjacencyMatrix::unsetAll(uint i)
+{
+    if (i >= n)
+        return;
+    int j = nextNeighbour(i);
+    while (j >= 0)
     {
-        uint temp = j;
-        j = i;
-        i = temp;
+        m[j*stride+i/64] &= ~(quint64(1) << (i%64));
+        j = nextNeighbour(i, j);
     }
-
-    if (i < m.size() && j < m[i].size())
-        m[i][j] = 0;
+    for (uint k = 0; k < stride; k++)
+        m[i*stride+k] = 0;
 }
 
 // Check if the matrix entry at (i,j) is set to 1.
@@ -54,15 +100,42 @@ void AdjacencyMatrix::unset(uint i, uint j)
 // and returns false if i,j is out of bounds.
 bool AdjacencyMatrix::isSet(uint i, uint j) const
 {
-    if (j > i)
+    if (i >= n || j >= n)
+        return false;
+    return (m[i*stride+j/64] >> (j%64)) & 1;
+}
+
+// Returns the number of entries set in row i.
+int AdjacencyMatrix::degree(uint i) const
+{
+    if (i >= n)
+        return 0;
+    int d = 0;
+    for (uint k = 0; k < stride; k++)
+        d += __builtin_popcountll(m[i*stride+k]);
+    return d;
+}
+
+// Returns the smallest column index larger than j that is set in row i,
+// or -1 if there is none. Start with j = -1 to find the first neighbour.
+int AdjacencyMatrix::nextNeighbour(uint i, int j) const
+{
+    if (i >= n)
+        return -1;
+
+    uint c = j+1;
+    uint k = c/64;
+    if (k >= stride)
+        return -1;
+
+    quint64 word = m[i*stride+k] & (~quint64(0) << (c%64));
+    while (word == 0)
     {
-        uint temp = j;
-        j = i;
-        i = temp;
+        k++;
+        if (k >= stride)
+            return -1;
+        word = m[i*stride+k];
     }
 
-    if (i+1 > m.size() || j+1 > m[i].size())
-        return false;
-    return (m[i][j] > 0);
+    return k*64 + __builtin_ctzll(word);
 }
-
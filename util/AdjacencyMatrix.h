@@ -3,7 +3,9 @@
 #include "util/Vector.h"
 class AdjacencyMatrix
 {
-    Vector< Vector<char> > m;
+    Vector<quint64> m; // Bit-packed rows, stride words per row.
+    uint n; // Number of rows and columns.
+    uint stride; // Number of 64 bit words per row.
 
 public:
 
@@ -11,9 +13,14 @@ public:
     ~AdjacencyMatrix(){}
 
     void clear();
+    void resize(uint n);
+    uint size() const;
     void set(uint i, uint j);
     void unset(uint i, uint j);
+    void unsetAll(uint i);
     bool isSet(uint i, uint j) const;
+    int degree(uint i) const;
+    int nextNeighbour(uint i, int j = -1) const;
 };
 
 #endif
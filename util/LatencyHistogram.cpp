@@ -0,0 +1,92 @@
+#include "LatencyHistogram.h"
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+// Removes all recorded durations.
+void LatencyHistogram::reset()
+{
+    for (int i = 0; i < BUCKETS; i++)
+        counts[i].store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    maximum.store(0, std::memory_order_relaxed);
+}
+
+// Counts a duration given in seconds.
+void LatencyHistogram::record(double seconds)
+{
+    quint64 ns = seconds > 0 ? (quint64)(seconds * 1.0e9 + 0.5) : 0;
+    ns = qMin(ns, ((quint64)1 << MAX_BITS) - 1);
+
+    counts[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(ns, std::memory_order_relaxed);
+
+    quint64 m = maximum.load(std::memory_order_relaxed);
+    while (ns > m && !maximum.compare_exchange_weak(m, ns, std::memory_order_relaxed));
+}
+
+// Returns the number of recorded durations.
+quint64 LatencyHistogram::count() const
+{
+    return total.load(std::memory_order_relaxed);
+}
+
+// Returns the mean of the recorded durations in seconds.
+double LatencyHistogram::mean() const
+{
+    quint64 n = count();
+    return n > 0 ? 1.0e-9 * sum.load(std::memory_order_relaxed) / n : 0;
+}
+
+// Returns the longest recorded duration in seconds.
+double LatencyHistogram::max() const
+{
+    return 1.0e-9 * maximum.load(std::memory_order_relaxed);
+}
+
+// Returns the p-th percentile (0 <= p <= 100) of the recorded durations in seconds.
+// The result is the upper bound of the bucket that contains the percentile, so it
+// overestimates the exact value by at most the bucket width.
+double LatencyHistogram::percentile(double p) const
+{
+    quint64 n = count();
+    if (n == 0)
+        return 0;
+
+    quint64 rank = qMax((quint64)1, (quint64)(qBound(0.0, p, 100.0) / 100.0 * n + 0.999999));
+    quint64 m = maximum.load(std::memory_order_relaxed);
+    quint64 seen = 0;
+    for (int i = 0; i < BUCKETS; i++)
+    {
+        seen += counts[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+            return 1.0e-9 * qMin(upperBound(i), m);
+    }
+    return 1.0e-9 * m;
+}
+
+// Returns the bucket of a duration in nanoseconds.
+int LatencyHistogram::bucket(quint64 ns)
+{
+    int msb = 0;
+    for (quint64 v = ns >> 1; v != 0; v >>= 1)
+        msb++;
+    if (msb < SUB_BITS)
+        return (int)ns;
+    int shift = msb - SUB_BITS;
+    return (shift + 1) * SUB_BUCKETS + (int)((ns >> shift) - SUB_BUCKETS);
+}
+
+// Returns the largest duration in nanoseconds that falls into the bucket.
+quint64 LatencyHistogram::upperBound(int bucket)
+{
+    if (bucket < SUB_BUCKETS)
+        return bucket;
+    int shift = bucket / SUB_BUCKETS - 1;
+    quint64 lower = (quint64)(bucket % SUB_BUCKETS + SUB_BUCKETS) << shift;
+    return lower + ((quint64)1 << shift) - 1;
+}
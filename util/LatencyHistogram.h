@@ -0,0 +1,48 @@
+#ifndef LATENCYHISTOGRAM_H_
+#define LATENCYHISTOGRAM_H_
+#include <QtGlobal>
+#include <atomic>
+
+// A histogram of durations with a fixed relative precision, in the manner of an
+// HDR histogram. Durations are counted in nanoseconds. Below 2^SUB_BITS ns every
+// value has its own bucket, above that every power of two range is divided into
+// 2^SUB_BITS buckets, so that a bucket is at most 1/32 of its value wide.
+// record() only performs relaxed atomic increments and can be called from any
+// number of threads concurrently, also while the histogram is being read.
+class LatencyHistogram
+{
+    enum
+    {
+        SUB_BITS = 5,
+        SUB_BUCKETS = 1 << SUB_BITS,
+        MAX_BITS = 40, // Durations are clamped to 2^40 ns, about 18 minutes.
+        BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS
+    };
+
+    std::atomic<quint64> counts[BUCKETS];
+    std::atomic<quint64> total;
+    std::atomic<quint64> sum;
+    std::atomic<quint64> maximum;
+
+public:
+
+    LatencyHistogram();
+    ~LatencyHistogram(){}
+
+    void reset();
+    void record(double seconds);
+
+    quint64 count() const;
+    double mean() const;
+    double max() const;
+    double percentile(double p) const;
+
+private:
+    LatencyHistogram(const LatencyHistogram&);
+    LatencyHistogram& operator=(const LatencyHistogram&);
+
+    static int bucket(quint64 ns);
+    static quint64 upperBound(int bucket);
+};
+
+#endif /* LATENCYHISTOGRAM_H_ */
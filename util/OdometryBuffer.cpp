@@ -0,0 +1,122 @@
+#include "OdometryBuffer.h"
+#include "globals.h"
+
+// The OdometryBuffer keeps the most recent timestamped odometry poses of the
+// robot in a fixed size ring buffer. The robot interface add()s a pose whenever
+// a new odometry reading arrives, and the perception queries the pose at any
+// point in time with poseAt(). Between two samples the pose is interpolated
+// linearly. After the newest sample the pose is extrapolated with the velocity
+// of the last two samples for at most maxExtrapolation seconds. Before the
+// oldest sample the oldest pose is returned.
+//
+// The timestamps are system times in seconds (see StopWatch::systemTime()),
+// which is the time base of the capture timestamps of the point clouds.
+// Since the buffer is a plain array, it is cheap to copy with the state.
+
+OdometryBuffer::OdometryBuffer()
+{
+    head = -1;
+    count = 0;
+}
+
+// Removes all samples.
+void OdometryBuffer::clear()
+{
+    head = -1;
+    count = 0;
+}
+
+// Adds an odometry pose (x, y, theta) that was measured at the given time.
+// The samples have to be added in chronological order.
+void OdometryBuffer::add(double time, const Vec3 &pose)
+{
+    head = (head+1)%CAPACITY;
+    samples[head].time = time;
+    samples[head].x = pose.x;
+    samples[head].y = pose.y;
+    samples[head].theta = pose.z;
+    count = min(count+1, (int)CAPACITY);
+}
+
+// Returns the number of samples in the buffer.
+int OdometryBuffer::size() const
+{
+    return count;
+}
+
+// Returns true if the buffer contains no samples.
+bool OdometryBuffer::isEmpty() const
+{
+    return (count == 0);
+}
+
+// Returns the ith sample. i = 0 is the newest sample.
+const OdometrySample &OdometryBuffer::operator[](int i) const
+{
+    return samples[(head-i+CAPACITY)%CAPACITY];
+}
+
+// Returns the newest sample.
+const OdometrySample &OdometryBuffer::last() const
+{
+    return samples[head];
+}
+
+// Returns the pose at the given time. The pose is interpolated between
+// the samples and extrapolated for at most maxExtrapolation seconds.
+Vec3 OdometryBuffer::poseAt(double time, double maxExtrapolation) const
+{
+    if (count == 0)
+        return Vec3();
+
+    // Find the pair of samples that encloses the time.
+    // The search starts at the newest sample since queries are typically recent.
+    int i = 0;
+    while (i < count-1 && (*this)[i].time > time)
+        i++;
+
+    const OdometrySample* s0;
+    const OdometrySample* s1;
+    if (i == 0)
+    {
+        // Extrapolate beyond the newest sample.
+        if (count == 1)
+            return Vec3(last().x, last().y, last().theta);
+        s0 = &(*this)[1];
+        s1 = &(*this)[0];
+        time = min(time, s1->time+maxExtrapolation);
+    }
+    else
+    {
+        s0 = &(*this)[i];
+        s1 = &(*this)[i-1];
+        time = max(time, s0->time);
+    }
+
+    double dt = s1->time-s0->time;
+    if (dt < EPSILON)
+        return Vec3(s1->x, s1->y, s1->theta);
+
+    double a = (time-s0->time)/dt;
+    return Vec3(s0->x+a*(s1->x-s0->x), s0->y+a*(s1->y-s0->y), picut(s0->theta+a*picut(s1->theta-s0->theta)));
+}
+
+// Returns the pose "to" relative to the frame given by the pose "from",
+// i.e. the transform that maps points from the "to" frame into the "from" frame.
+Vec3 OdometryBuffer::relativePose(const Vec3 &from, const Vec3 &to)
+{
+    double c = cos(from.z);
+    double s = sin(from.z);
+    double dx = to.x-from.x;
+    double dy = to.y-from.y;
+    return Vec3(c*dx+s*dy, -s*dx+c*dy, picut(to.z-from.z));
+}
+
+// Returns the pose b given relative to a in the frame of a.
+// This is the inverse operation of relativePose().
+Vec3 OdometryBuffer::composePose(const Vec3 &a, const Vec3 &b)
+{
+    double c = cos(a.z);
+    double s = sin(a.z);
+    return Vec3(a.x+c*b.x-s*b.y, a.y+s*b.x+c*b.y, picut(a.z+b.z));
+}
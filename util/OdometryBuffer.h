@@ -0,0 +1,39 @@
+#ifndef ODOMETRYBUFFER_H_
+#define ODOMETRYBUFFER_H_
+#include "util/Vec3.h"
+
+// A timestamped odometry pose (x, y, theta).
+struct OdometrySample
+{
+    double time = 0;
+    double x = 0;
+    double y = 0;
+    double theta = 0;
+};
+
+class OdometryBuffer
+{
+    enum {CAPACITY = 128};
+    OdometrySample samples[CAPACITY]; // Ring buffer, no allocations.
+    int head; // Index of the newest sample.
+    int count;
+
+public:
+
+    OdometryBuffer();
+    ~OdometryBuffer(){}
+
+    void clear();
+    void add(double time, const Vec3& pose);
+    int size() const;
+    bool isEmpty() const;
+    const OdometrySample& operator[](int i) const;
+    const OdometrySample& last() const;
+
+    Vec3 poseAt(double time, double maxExtrapolation = 0.5) const;
+
+    static Vec3 relativePose(const Vec3& from, const Vec3& to);
+    static Vec3 composePose(const Vec3& a, const Vec3& b);
+};
+
+#endif
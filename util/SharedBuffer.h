@@ -0,0 +1,63 @@
+#ifndef SHAREDBUFFER_H
+#define SHAREDBUFFER_H
+#include <vector>
+#include <memory>
+#include <atomic>
+
+// The SharedBuffer is a fixed size array that is shared copy-on-write between all copies.
+// It is meant for large data blocks, such as the point cloud of a frame, that are handed
+// from a frame source through the state into the state history. Copying a SharedBuffer only
+// increments a reference count. Read access through the const operator[] or constData()
+// never copies. Write access must go through data(), which detaches the buffer first if it
+// is shared with another copy. Unlike Qt's implicit sharing, the detach is explicit so that
+// reading from a non-const object can not trigger an unexpected deep copy.
+//
+// Copies can live in different threads, e.g. in the queue of the AsyncRecorder or in a gui
+// snapshot, but every SharedBuffer object must only be used by one thread at a time. The
+// other threads may only read through and drop the references they own; they never copy
+// from or write into a buffer of another thread. Under this rule the reference count can
+// only drop concurrently, never rise, so when detach() sees a count of one, no other copy
+// exists any more and the data can be written in place. A stale count of two only causes
+// an unnecessary copy.
+
+template <typename T>
+class SharedBuffer
+{
+    std::shared_ptr<std::vector<T> > d;
+
+public:
+
+    SharedBuffer() {}
+    SharedBuffer(int k) {resize(k);}
+
+    int size() const {return d ? (int)d->size() : 0;}
+    bool isEmpty() const {return size() == 0;}
+    bool isShared() const {return d && d.use_count() > 1;}
+
+    // Resizes the buffer. This detaches the buffer if it is shared.
+    void resize(int k)
+    {
+        detach();
+        d->resize(k);
+    }
+
+    // Makes sure this object holds the only reference to the data.
+    void detach()
+    {
+        if (!d)
+            d = std::make_shared<std::vector<T> >();
+        else if (d.use_count() > 1)
+            d = std::make_shared<std::vector<T> >(*d);
+        else
+            std::atomic_thread_fence(std::memory_order_acquire); // Order after the reads of the released copies.
+    }
+
+    // Releases the reference to the data.
+    void clear() {d.reset();}
+
+    const T& operator[](int i) const {return (*d)[i];}
+    const T* constData() const {return d ? d->data() : 0;}
+    T* data() {detach(); return d->data();}
+};
+
+#endif // SHAREDBUFFER_H
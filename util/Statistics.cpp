@@ -171,6 +171,21 @@ double Statistics::median(const Vector<double>& list)
     return myList[myList.size()/2];
 }
 
+// Returns the p-th percentile (0 <= p <= 100) of the values in the list.
+// The nearest rank method is used, so the result is always one of the values.
+double Statistics::percentile(const Vector<double>& list, double p)
+{
+    if (list.isEmpty())
+        return 0;
+
+    std::vector<double> sorted(list.size());
+    for (int i = 0; i < list.size(); i++)
+        sorted[i] = list[i];
+    int rank = qBound(0, (int)ceil(p/100.0*sorted.size())-1, (int)sorted.size()-1);
+    std::nth_element(sorted.begin(), sorted.begin()+rank, sorted.end());
+    return sorted[rank];
+}
+
 // Returns a random integer between 0 and RAND_MAX
 int Statistics::randomInt(int low, int high)
 {
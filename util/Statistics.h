@@ -21,6 +21,7 @@ public:
     static double mean(const Vector<double>& values);
     static Vec2 meanstddev(const Vector<double>& values);
     static double median(const Vector<double>& values);
+    static double percentile(const Vector<double>& values, double p);
     static Vector<int> histogram(const Vector<double>& list, int bins=100, double min=0, double max=0);
     static int randomInt(int low=0, int high=RAND_MAX);
     static double randomNumber();
@@ -16,8 +16,10 @@ HEADERS += util/Timer.h \
     util/LinkedList.h \
     util/Vector.h \
     util/AdjacencyMatrix.h \
-    util/GLlib.h \
-    util/Transform3D.h
+    util/Transform3D.h \
+    util/OdometryBuffer.h \
+    util/SharedBuffer.h \
+    util/LatencyHistogram.h
 SOURCES += \
     util/StopWatch.cpp \
     util/Timer.cpp \
@@ -25,8 +27,13 @@ SOURCES += \
     util/Statistics.cpp \
     util/ColorUtil.cpp \
     util/AdjacencyMatrix.cpp \
-    util/GLlib.cpp \
-    util/Transform3D.cpp
+    util/Transform3D.cpp \
+    util/OdometryBuffer.cpp \
+    util/LatencyHistogram.cpp
+!contains(DEFINES, HEADLESS) {
+    HEADERS += util/GLlib.h
+    SOURCES += util/GLlib.cpp
+}
 win32:HEADERS += util/TimerWindows.h
 win32:SOURCES += util/TimerWindows.cpp
 win32:HEADERS += util/StopWatchWindows.h